@@ -6,7 +6,21 @@
 #include "arm_cinematics.h"
 #include "arm_trajectories.h"
 #include "arm_utils.h"
-
+#include "trig.h"
+
+/* Trajectory buffer indexes are swapped with interrupts disabled. This only
+ * lasts a few instructions, unlike holding a semaphore during the whole copy
+ * or inverse cinematics. */
+#ifdef COMPILE_ON_ROBOT
+#define ARM_ENTER_CRITICAL() OS_CPU_SR cpu_sr; OS_ENTER_CRITICAL()
+#define ARM_EXIT_CRITICAL() OS_EXIT_CRITICAL()
+#else
+#define ARM_ENTER_CRITICAL()
+#define ARM_EXIT_CRITICAL()
+#endif
+
+static int arm_keyframes_for_date(arm_t *arm, arm_trajectory_t *traj, int32_t date,
+                                  arm_keyframe_t *k1, arm_keyframe_t *k2);
 
 void arm_set_physical_parameters(arm_t *arm)
 {
@@ -33,18 +47,21 @@ void arm_set_physical_parameters(arm_t *arm)
 
 void arm_get_position(arm_t *arm, float *x, float *y, float *z)
 {
-    float alpha, beta;
+    float alpha, beta, sin_a, cos_a, sin_b, cos_b;
 
     alpha = cs_get_feedback(&arm->shoulder.manager) / (float)arm->shoulder_imp_per_rad;
     beta = cs_get_feedback(&arm->elbow.manager) / (float)arm->elbow_imp_per_rad;
 
     beta += alpha;
 
+    trig_sincos(alpha, &sin_a, &cos_a);
+    trig_sincos(beta, &sin_b, &cos_b);
+
     if (x)
-        *x = arm->length[0] * cos(alpha) + arm->length[1] * cos(beta);
+        *x = arm->length[0] * cos_a + arm->length[1] * cos_b;
 
     if (y)
-        *y = arm->length[0] * sin(alpha) + arm->length[1] * sin(beta);
+        *y = arm->length[0] * sin_a + arm->length[1] * sin_b;
 
     if (z)
         *z = cs_get_feedback(&arm->z_axis.manager) / (float)arm->z_axis_imp_per_mm;
@@ -64,129 +81,351 @@ void arm_init(arm_t *arm)
     arm->last_loop = uptime_get();
 
     arm->shoulder_mode = SHOULDER_BACK;
+    arm->manage_period = ARM_DEFAULT_MANAGE_PERIOD;
 
     platform_create_semaphore(&arm->trajectory_semaphore, 1);
 }
 
+/** Converts every keyframe which does not depend on the robot position to arm
+ * coordinates, so it does not have to be done again on every arm_manage call.
+ *
+ * Table coordinates cannot be converted here since the robot moves during the
+ * trajectory.
+ */
+static void arm_compile_trajectory(arm_t *arm, arm_trajectory_t *traj)
+{
+    int i;
+    point_t pos;
+
+    for (i = 0; i < traj->frame_count; i++) {
+        if (traj->frames[i].coordinate_type != COORDINATE_ROBOT)
+            continue;
+
+        pos.x = traj->frames[i].position[0];
+        pos.y = traj->frames[i].position[1];
+        pos = arm_coordinate_robot2arm(pos, arm->offset_xy, arm->offset_rotation);
+
+        traj->frames[i].position[0] = pos.x;
+        traj->frames[i].position[1] = pos.y;
+        traj->frames[i].coordinate_type = COORDINATE_ARM;
+    }
+}
+
+/** Marks the start of a write and returns the buffer to write to.
+ * @note Must be called with trajectory_semaphore held.
+ */
+static arm_trajectory_t *arm_begin_trajectory_write(arm_t *arm)
+{
+    int index;
+    ARM_ENTER_CRITICAL();
+
+    arm->trajectory_seq++;
+    index = 1 - arm->active_trajectory;
+
+    ARM_EXIT_CRITICAL();
+
+    return &arm->trajectory_buffers[index];
+}
+
+/** Publishes a buffer returned by arm_begin_trajectory_write. */
+static void arm_end_trajectory_write(arm_t *arm, arm_trajectory_t *traj)
+{
+    ARM_ENTER_CRITICAL();
+
+    arm->published_trajectory = traj - arm->trajectory_buffers;
+    arm->trajectory_seq++;
+
+    ARM_EXIT_CRITICAL();
+}
+
+/** Switches to the last published trajectory if there is a new one.
+ *
+ * Called by the cinematics task only, never blocks. A trajectory still being
+ * written is ignored until the next call.
+ */
+static void arm_take_published_trajectory(arm_t *arm)
+{
+    int changed = 0;
+    ARM_ENTER_CRITICAL();
+
+    if (arm->trajectory_seq != arm->consumed_seq && (arm->trajectory_seq & 1) == 0) {
+        arm->active_trajectory = arm->published_trajectory;
+        arm->consumed_seq = arm->trajectory_seq;
+        changed = 1;
+    }
+
+    ARM_EXIT_CRITICAL();
+
+    if (changed) {
+        arm->cursor = 0;
+        arm->table_transform_valid = 0;
+    }
+}
+
 void arm_do_trajectory(arm_t *arm, arm_trajectory_t *traj)
 {
+    arm_trajectory_t *back;
+
+    platform_take_semaphore(&arm->trajectory_semaphore);
+
+    back = arm_begin_trajectory_write(arm);
+    arm_trajectory_copy(back, traj);
+    arm_compile_trajectory(arm, back);
+    arm_end_trajectory_write(arm, back);
+
+    platform_signal_semaphore(&arm->trajectory_semaphore);
+}
+
+int arm_is_trajectory_finished(arm_t *arm)
+{
+    int finished;
+
+    /* Writers cannot modify the published buffer while we hold this. */
     platform_take_semaphore(&arm->trajectory_semaphore);
-    arm_trajectory_copy(&arm->trajectory, traj);
+    finished = arm_trajectory_finished(&arm->trajectory_buffers[arm->published_trajectory]);
     platform_signal_semaphore(&arm->trajectory_semaphore);
+
+    return finished;
+}
+
+/** Disables the joints, when there is nothing to track. */
+static void arm_disable_loops(arm_t *arm)
+{
+    arm_cs_disable(&arm->shoulder);
+    arm_cs_disable(&arm->elbow);
+    arm_cs_disable(&arm->z_axis);
+    arm_cs_disable(&arm->hand);
 }
 
-void arm_manage(arm_t *arm)
+int arm_manage(arm_t *arm)
 {
-    arm_keyframe_t frame;
-    point_t target, p1, p2;
+    arm_keyframe_t frame, next_frame;
+    arm_keyframe_derivatives_t derivatives;
+    point_t target;
     int32_t current_date = uptime_get();
-    int position_count;
+    shoulder_mode_t mode;
     float alpha, beta;
+    float joint_velocity[2], joint_acceleration[2];
+    arm_trajectory_t *traj;
+    int finished;
 
-    platform_take_semaphore(&arm->trajectory_semaphore);
+    arm_take_published_trajectory(arm);
+    traj = &arm->trajectory_buffers[arm->active_trajectory];
+
+    /* Only this task changes the active buffer, so no lock is needed. A
+     * trajectory published since the take is not finished either. */
+    finished = arm_trajectory_finished(traj) && arm->trajectory_seq == arm->consumed_seq;
 
-    if (arm->trajectory.frame_count == 0) {
-        cs_disable(&arm->shoulder.manager);
-        cs_disable(&arm->elbow.manager);
-        cs_disable(&arm->z_axis.manager);
-        cs_disable(&arm->hand.manager);
+    if (traj->frame_count == 0) {
+        arm_disable_loops(arm);
         arm->last_loop = current_date;
-        platform_signal_semaphore(&arm->trajectory_semaphore);
-        return;
+        return finished;
+    }
+
+    if (arm_keyframes_for_date(arm, traj, current_date, &frame, &next_frame)) {
+        derivatives = arm_trajectory_interpolate_derivatives(frame, next_frame, current_date);
+        frame = arm_trajectory_interpolate_keyframes(frame, next_frame, current_date);
+    } else {
+        memset(&derivatives, 0, sizeof(derivatives));
     }
 
-    frame = arm_position_for_date(arm, uptime_get());
     target.x = frame.position[0];
     target.y = frame.position[1];
 
-    position_count = compute_possible_elbow_positions(target, frame.length[0], frame.length[1], &p1, &p2);
+    mode = mode_for_orientation(arm->shoulder_mode, arm->offset_rotation);
 
-    if (position_count == 0) {
-        cs_disable(&arm->shoulder.manager);
-        cs_disable(&arm->elbow.manager);
-        cs_disable(&arm->z_axis.manager);
-        cs_disable(&arm->hand.manager);
+    /* beta is relative to the first segment, due to the mecanical
+     * construction of the arms. */
+    if (!arm_inverse_cinematics(target, frame.length, mode, &alpha, &beta)) {
+        arm_disable_loops(arm);
         arm->last_loop = current_date;
-        platform_signal_semaphore(&arm->trajectory_semaphore);
-        return;
-    } else if (position_count == 2) {
-        shoulder_mode_t mode;
-        mode = mode_for_orientation(arm->shoulder_mode, arm->offset_rotation);
-        p1 = choose_shoulder_solution(target, p1, p2, mode);
+        return finished;
     }
 
-    /* p1 now contains the correct elbow pos. */
-    alpha = compute_shoulder_angle(p1, target);
-    beta  = compute_elbow_angle(p1, target);
+    /* Feedforward, so the tracking error does not grow with the speed. */
+    arm_inverse_cinematics_derivatives(alpha, beta, frame.length,
+                                       derivatives.velocity, derivatives.acceleration,
+                                       joint_velocity, joint_acceleration);
+
+    arm_cs_set_reference_derivatives(&arm->shoulder,
+                                     joint_velocity[0] * arm->shoulder_imp_per_rad,
+                                     joint_acceleration[0] * arm->shoulder_imp_per_rad);
+    arm_cs_set_reference_derivatives(&arm->elbow,
+                                     joint_velocity[1] * arm->elbow_imp_per_rad,
+                                     joint_acceleration[1] * arm->elbow_imp_per_rad);
+    arm_cs_set_reference_derivatives(&arm->z_axis,
+                                     derivatives.velocity[2] * arm->z_axis_imp_per_mm,
+                                     derivatives.acceleration[2] * arm->z_axis_imp_per_mm);
+    arm_cs_set_reference_derivatives(&arm->hand,
+                                     derivatives.hand_velocity * arm->hand_imp_per_deg,
+                                     derivatives.hand_acceleration * arm->hand_imp_per_deg);
+
+    cs_set_consign(&arm->shoulder.manager, alpha * arm->shoulder_imp_per_rad);
+    cs_set_consign(&arm->elbow.manager, beta * arm->elbow_imp_per_rad);
+    cs_set_consign(&arm->z_axis.manager, frame.position[2] * arm->z_axis_imp_per_mm);
+    cs_set_consign(&arm->hand.manager, frame.hand_angle * arm->hand_imp_per_deg);
+
+    /* Enabled last, so the control task never runs a loop with the consign
+     * or feedforward of the previous period. */
+    cs_enable(&arm->shoulder.manager);
+    cs_enable(&arm->elbow.manager);
+    cs_enable(&arm->z_axis.manager);
+    cs_enable(&arm->hand.manager);
 
+    arm->last_loop = uptime_get();
 
-    /* This is due to mecanical construction of the arms. */
-    beta = beta - alpha;
+    return finished;
+}
 
+int32_t arm_get_manage_period(arm_t *arm)
+{
+    if (arm->trajectory_buffers[arm->active_trajectory].frame_count == 0 &&
+        arm->trajectory_seq == arm->consumed_seq)
+        return 0;
 
-    /* The arm cannot make one full turn. */
+    return arm->manage_period;
+}
 
-    if (beta < -M_PI)
-        beta = 2 * M_PI + beta;
+void arm_set_manage_period(arm_t *arm, int32_t period)
+{
+    arm->manage_period = period;
+}
 
-    if (beta > M_PI)
-        beta = beta - 2 * M_PI;
+/** Updates the table to arm transform if the robot moved since it was computed. */
+static void arm_update_table_transform(arm_t *arm)
+{
+    point_t robot_pos;
+    float robot_a_rad;
 
-    cs_enable(&arm->shoulder.manager);
-    cs_enable(&arm->elbow.manager);
-    cs_enable(&arm->z_axis.manager);
-    cs_enable(&arm->hand.manager);
+    robot_pos.x = position_get_x_float(arm->robot_pos);
+    robot_pos.y = position_get_y_float(arm->robot_pos);
+    robot_a_rad = position_get_a_rad_float(arm->robot_pos);
 
-    cs_set_consign(&arm->shoulder.manager, alpha * arm->shoulder_imp_per_rad);
-    cs_set_consign(&arm->elbow.manager, beta * arm->elbow_imp_per_rad);
-    cs_set_consign(&arm->z_axis.manager, frame.position[2] * arm->z_axis_imp_per_mm);
-    cs_set_consign(&arm->hand.manager, frame.hand_angle * arm->hand_imp_per_deg);
+    if (arm->table_transform_valid &&
+        arm->table_transform_pose[0] == robot_pos.x &&
+        arm->table_transform_pose[1] == robot_pos.y &&
+        arm->table_transform_pose[2] == robot_a_rad)
+        return;
 
-    arm->last_loop = uptime_get();
+    arm_transform_table2arm(&arm->table_transform, robot_pos, robot_a_rad,
+                            arm->offset_xy, arm->offset_rotation);
 
-    platform_signal_semaphore(&arm->trajectory_semaphore);
+    arm->table_transform_pose[0] = robot_pos.x;
+    arm->table_transform_pose[1] = robot_pos.y;
+    arm->table_transform_pose[2] = robot_a_rad;
+    arm->table_transform_valid = 1;
 }
 
+/** Converts a keyframe to arm coordinates.
+ * @note Robot coordinates were already converted by arm_compile_trajectory.
+ */
 static arm_keyframe_t arm_convert_keyframe_coordinate(arm_t *arm, arm_keyframe_t key)
 {
     point_t pos;
+
+    if (key.coordinate_type != COORDINATE_TABLE)
+        return key;
+
+    arm_update_table_transform(arm);
+
     pos.x = key.position[0];
     pos.y = key.position[1];
-    if (key.coordinate_type == COORDINATE_TABLE) {
-        point_t robot_pos;
-        float robot_a_rad;
-
-        robot_pos.x = position_get_x_float(arm->robot_pos);
-        robot_pos.y = position_get_y_float(arm->robot_pos);
-        robot_a_rad = position_get_a_rad_float(arm->robot_pos);
-        pos = arm_coordinate_table2robot(pos, robot_pos, robot_a_rad);
-        pos = arm_coordinate_robot2arm(pos, arm->offset_xy, arm->offset_rotation);
-    } else if (key.coordinate_type == COORDINATE_ROBOT) {
-        pos = arm_coordinate_robot2arm(pos, arm->offset_xy, arm->offset_rotation);
-    }
+    pos = arm_transform_apply(&arm->table_transform, pos);
 
     key.position[0] = pos.x;
     key.position[1] = pos.y;
     return key;
 }
 
-arm_keyframe_t arm_position_for_date(arm_t *arm, int32_t date)
+/** Finds the segment of the trajectory containing the given date.
+ *
+ * @returns The index i of the keyframe such as frames[i-1].date < date <= frames[i].date.
+ * @note The date must be strictly after the first keyframe and not after the
+ * last one.
+ *
+ * Time usually goes forward between two calls, so we first walk from the
+ * segment found by the previous lookup, which is amortized O(1). If the date
+ * went backward we fall back to a binary search.
+ */
+static int arm_find_segment(arm_t *arm, arm_trajectory_t *traj, int32_t date)
 {
-    int i=0;
-    arm_keyframe_t k1, k2;
-    point_t pos1, pos2;
+    arm_keyframe_t *frames = traj->frames;
+    int i = arm->cursor;
+    int low, high, mid;
+
+    if (i >= 1 && i < traj->frame_count && frames[i-1].date < date) {
+        while (frames[i].date < date)
+            i++;
+
+        arm->cursor = i;
+        return i;
+    }
+
+    low = 1;
+    high = traj->frame_count - 1;
+
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (frames[mid].date < date)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    arm->cursor = low;
+    return low;
+}
+
+/** Finds the keyframes around a date, converted to arm coordinates.
+ *
+ * @param [in] traj The active trajectory, already taken by the caller and not
+ * empty.
+ * @returns 1 if the date is inside a segment, 0 if it is before the start or
+ * after the end of the trajectory. In the latter case k1 is the closest
+ * keyframe and k2 is left untouched.
+ */
+static int arm_keyframes_for_date(arm_t *arm, arm_trajectory_t *traj, int32_t date,
+                                  arm_keyframe_t *k1, arm_keyframe_t *k2)
+{
+    int i, last_frame;
+
+    last_frame = traj->frame_count - 1;
 
     /* If we are past last keyframe, simply return last frame. */
-    if (arm->trajectory.frames[arm->trajectory.frame_count-1].date < date) {
-        k1 = arm->trajectory.frames[arm->trajectory.frame_count-1];
-        return arm_convert_keyframe_coordinate(arm, k1);
+    if (traj->frames[last_frame].date < date) {
+        *k1 = arm_convert_keyframe_coordinate(arm, traj->frames[last_frame]);
+        return 0;
+    }
+
+    /* Same thing if we are before the first keyframe. */
+    if (date <= traj->frames[0].date) {
+        *k1 = arm_convert_keyframe_coordinate(arm, traj->frames[0]);
+        return 0;
     }
 
-    while (arm->trajectory.frames[i].date < date)
-        i++;
+    i = arm_find_segment(arm, traj, date);
+
+    *k1 = arm_convert_keyframe_coordinate(arm, traj->frames[i-1]);
+    *k2 = arm_convert_keyframe_coordinate(arm, traj->frames[i]);
+
+    return 1;
+}
+
+arm_keyframe_t arm_position_for_date(arm_t *arm, int32_t date)
+{
+    arm_keyframe_t k1, k2;
+    arm_trajectory_t *traj;
+
+    /* Taking a new trajectory is left to arm_manage. */
+    traj = &arm->trajectory_buffers[arm->active_trajectory];
+
+    if (traj->frame_count == 0) {
+        memset(&k1, 0, sizeof(k1));
+        return k1;
+    }
 
-    k1 = arm_convert_keyframe_coordinate(arm, arm->trajectory.frames[i-1]);
-    k2 = arm_convert_keyframe_coordinate(arm, arm->trajectory.frames[i]);
+    if (!arm_keyframes_for_date(arm, traj, date, &k1, &k2))
+        return k1;
 
     return arm_trajectory_interpolate_keyframes(k1, k2, date);
 }
@@ -198,7 +437,14 @@ void arm_set_related_robot_pos(arm_t *arm, struct robot_position *pos)
 
 void arm_shutdown(arm_t *arm)
 {
+    arm_trajectory_t *back;
+
+    /* Publishes an empty trajectory, which disables the arm. */
     platform_take_semaphore(&arm->trajectory_semaphore);
-    arm_trajectory_delete(&arm->trajectory);
+
+    back = arm_begin_trajectory_write(arm);
+    arm_trajectory_delete(back);
+    arm_end_trajectory_write(arm, back);
+
     platform_signal_semaphore(&arm->trajectory_semaphore);
 }
@@ -12,9 +12,13 @@
 #include "arm_cs.h"
 #include "arm_cinematics.h"
 #include "keyframe.h"
+#include "arm_utils.h"
 #include "2wheels/position_manager.h"
 #include <vect2.h>
 
+/** Default period of arm_manage while a trajectory is running, in us. */
+#define ARM_DEFAULT_MANAGE_PERIOD 10000
+
 
 typedef struct {
     vect2_cart offset_xy; /**< Offset vector between center of robot and shoulder. */
@@ -33,26 +37,75 @@ typedef struct {
     int32_t hand_imp_per_deg;
     float length[2];                  /**< Length of the 2 arms elements. */
 
-    /* Path informations */
-    arm_trajectory_t trajectory;    /**< Current trajectory of the arm. */
-    semaphore_t trajectory_semaphore;
+    /* Path informations
+     *
+     * arm_manage reads trajectory_buffers[active_trajectory] and new
+     * trajectories are written to the other buffer, then published.
+     * trajectory_seq is incremented before and after each write, so it is
+     * odd while a write is in progress. */
+    arm_trajectory_t trajectory_buffers[2];
+    int active_trajectory;          /**< Buffer used by arm_manage, only changed by the cinematics task. */
+    int published_trajectory;       /**< Last buffer published by arm_do_trajectory. */
+    volatile uint32_t trajectory_seq;
+    uint32_t consumed_seq;          /**< Value of trajectory_seq when active_trajectory was taken. */
+    semaphore_t trajectory_semaphore; /**< Serializes writers, never taken by arm_manage. */
+    int cursor;                     /**< Index of the keyframe ending the segment found by the last lookup. */
     int32_t last_loop;              /**< Timestamp of the last loop execution, in us since boot. */
+    int32_t manage_period;          /**< Period of arm_manage while a trajectory is running, in us. */
     struct robot_position *robot_pos;
 
+    /* Cache for table coordinates, only updated when the robot moves. */
+    arm_transform_t table_transform;
+    float table_transform_pose[3];  /**< Robot x, y, a used to compute table_transform. */
+    int table_transform_valid;
+
     shoulder_mode_t shoulder_mode;
 } arm_t;
 
 void arm_init(arm_t *arm);
 
+/** Starts a new trajectory.
+ *
+ * The trajectory is copied and published, it will be used by arm_manage from
+ * its next run on. This never waits for arm_manage.
+ */
 void arm_do_trajectory(arm_t *arm, arm_trajectory_t *traj);
 
+/** Returns non zero if the last trajectory given to the arm is finished.
+ *
+ * This takes the trajectory semaphore, which writers hold during a whole
+ * copy. The cinematics task uses the value returned by arm_manage instead.
+ */
+int arm_is_trajectory_finished(arm_t *arm);
+
 void arm_set_physical_parameters(arm_t *arm);
 
-void arm_manage(arm_t *arm);
+/** Runs the cinematics of the arm once.
+ *
+ * @returns Non zero if the last published trajectory is finished, computed
+ * without locking.
+ */
+int arm_manage(arm_t *arm);
+
+/** Returns how often arm_manage should be called, in us.
+ *
+ * This is 0 if the arm is idle, i.e. it has no trajectory and no new one was
+ * published. arm_manage does not need to run in this case.
+ */
+int32_t arm_get_manage_period(arm_t *arm);
+
+/** Sets the period of arm_manage while a trajectory is running, in us. */
+void arm_set_manage_period(arm_t *arm, int32_t period);
 
 
 void arm_get_position(arm_t *arm, float *x, float *y, float *z);
 
+/** Returns the position of the trajectory arm_manage runs at the given date.
+ *
+ * @note Only for the task calling arm_manage, since it moves the same lookup
+ * cursor and table coordinates cache. A trajectory published since the last
+ * arm_manage is not seen yet.
+ */
 arm_keyframe_t arm_position_for_date(arm_t *arm, int32_t date);
 
 void arm_set_related_robot_pos(arm_t *arm, struct robot_position *pos);
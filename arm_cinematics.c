@@ -2,6 +2,7 @@
 #include <math.h>
 #include <circles.h>
 #include "arm_cinematics.h"
+#include "trig.h"
 
 
 int compute_possible_elbow_positions(point_t target, float l1, float l2,
@@ -59,7 +60,7 @@ point_t choose_shoulder_solution(point_t target, point_t elbow1,
 
 float compute_shoulder_angle(point_t elbow, point_t hand)
 {
-    return atan2f(elbow.y, elbow.x);
+    return trig_atan2(elbow.y, elbow.x);
 }
 
 float compute_elbow_angle(point_t elbow, point_t hand)
@@ -67,14 +68,110 @@ float compute_elbow_angle(point_t elbow, point_t hand)
     float dx, dy;
     dx = hand.x - elbow.x;
     dy = hand.y - elbow.y;
-    return atan2f(dy, dx); // tres tres sensible aux erreurs d'arrondis
+    return trig_atan2(dy, dx); // tres tres sensible aux erreurs d'arrondis
 }
 
 point_t arm_forward_cinematics(float alpha, float beta, float length[2])
 {
     point_t result;
-    result.x = cos(alpha) * length[0] + cos(alpha + beta) * length[1];
-    result.y = sin(alpha) * length[0] + sin(alpha + beta) * length[1];
+    float sin_a, cos_a, sin_ab, cos_ab;
+
+    trig_sincos(alpha, &sin_a, &cos_a);
+    trig_sincos(alpha + beta, &sin_ab, &cos_ab);
+
+    result.x = cos_a * length[0] + cos_ab * length[1];
+    result.y = sin_a * length[0] + sin_ab * length[1];
 
     return result;
 }
+
+int arm_inverse_cinematics(point_t target, float length[2], shoulder_mode_t mode,
+                           float *alpha, float *beta)
+{
+    float l1 = length[0], l2 = length[1];
+    float d2, d, a, h2, h, cos_beta;
+    point_t elbow;
+    int elbow_left; /* Elbow on the left of the shoulder to hand line. */
+
+    d2 = target.x * target.x + target.y * target.y;
+    d = sqrtf(d2);
+
+    if (d == 0. || d > l1 + l2 || d < fabsf(l1 - l2))
+        return 0;
+
+    /* Projection of the elbow on the shoulder to hand line, and distance
+     * between the elbow and this line. */
+    a = (l1 * l1 - l2 * l2 + d2) / (2 * d);
+    h2 = l1 * l1 - a * a;
+    h = h2 > 0. ? sqrtf(h2) : 0.;
+
+    /* Same choice as choose_shoulder_solution. The left elbow has the
+     * greatest x when target.y < 0 and the greatest y when target.x > 0. */
+    if (target.x < 0)
+        elbow_left = target.y < 0;
+    else if (mode == SHOULDER_BACK)
+        elbow_left = target.x > 0;
+    else
+        elbow_left = !(target.x > 0);
+
+    if (!elbow_left)
+        h = -h;
+
+    elbow.x = (a * target.x - h * target.y) / d;
+    elbow.y = (a * target.y + h * target.x) / d;
+
+    *alpha = trig_atan2(elbow.y, elbow.x);
+
+    /* trig_acos clamps cos_beta to [-1, 1]. */
+    cos_beta = (d2 - l1 * l1 - l2 * l2) / (2 * l1 * l2);
+
+    /* A left elbow means the forearm turns clockwise. */
+    *beta = elbow_left ? -trig_acos(cos_beta) : trig_acos(cos_beta);
+
+    return 1;
+}
+
+/** Minimum value of |sin(beta)| for which the jacobian is inverted. */
+#define ARM_JACOBIAN_MIN_SIN_BETA 0.05
+
+int arm_inverse_cinematics_derivatives(float alpha, float beta, float length[2],
+                                       const float velocity[2], const float acceleration[2],
+                                       float joint_velocity[2], float joint_acceleration[2])
+{
+    float l1 = length[0], l2 = length[1];
+    float sin_a, cos_a, sin_ab, cos_ab, sin_b;
+    float det, ax, ay, da, dab;
+
+    trig_sincos(alpha, &sin_a, &cos_a);
+    trig_sincos(alpha + beta, &sin_ab, &cos_ab);
+    sin_b = trig_sin(beta);
+
+    if (fabsf(sin_b) < ARM_JACOBIAN_MIN_SIN_BETA) {
+        joint_velocity[0] = joint_velocity[1] = 0;
+        joint_acceleration[0] = joint_acceleration[1] = 0;
+        return 0;
+    }
+
+    /* The jacobian is
+     * J = | -l1 sin(a) - l2 sin(a+b)  -l2 sin(a+b) |
+     *     |  l1 cos(a) + l2 cos(a+b)   l2 cos(a+b) |
+     * and its determinant is l1 l2 sin(b). */
+    det = l1 * l2 * sin_b;
+
+    joint_velocity[0] = (l2 * cos_ab * velocity[0] + l2 * sin_ab * velocity[1]) / det;
+    joint_velocity[1] = (-(l1 * cos_a + l2 * cos_ab) * velocity[0]
+                         - (l1 * sin_a + l2 * sin_ab) * velocity[1]) / det;
+
+    /* The hand acceleration is J * q'' + J' * q', so we remove the centripetal
+     * part J' * q' before inverting. */
+    da = joint_velocity[0];
+    dab = joint_velocity[0] + joint_velocity[1];
+    ax = acceleration[0] + l1 * cos_a * da * da + l2 * cos_ab * dab * dab;
+    ay = acceleration[1] + l1 * sin_a * da * da + l2 * sin_ab * dab * dab;
+
+    joint_acceleration[0] = (l2 * cos_ab * ax + l2 * sin_ab * ay) / det;
+    joint_acceleration[1] = (-(l1 * cos_a + l2 * cos_ab) * ax
+                             - (l1 * sin_a + l2 * sin_ab) * ay) / det;
+
+    return 1;
+}
@@ -32,6 +32,40 @@ point_t choose_shoulder_solution(point_t target, point_t elbow1, point_t elbow2,
 
 point_t arm_forward_cinematics(float alpha, float beta, float length[2]);
 
+/** Computes the joint angles needed to reach a given point.
+ *
+ * This gives the same solution as compute_possible_elbow_positions followed by
+ * choose_shoulder_solution, compute_shoulder_angle and compute_elbow_angle,
+ * but uses the law of cosines directly. It only needs one acos and one atan2,
+ * computed by the trig backend.
+ *
+ * @param [in] target The position of the hand, in arm coordinates.
+ * @param [in] length The length of the two parts of the arm.
+ * @param [in] mode The shoulder mode, already corrected by mode_for_orientation.
+ * @param [out] alpha The shoulder angle in rad.
+ * @param [out] beta The elbow angle in rad, relative to the first arm segment,
+ * between -pi and pi.
+ * @returns 1 if the target is reachable, 0 otherwise.
+ */
+int arm_inverse_cinematics(point_t target, float length[2], shoulder_mode_t mode,
+                           float *alpha, float *beta);
+
+/** Converts the hand velocity and acceleration to joint velocities and
+ * accelerations, using the inverse of the jacobian.
+ *
+ * @param [in] alpha, beta The joint angles, as given by arm_inverse_cinematics.
+ * @param [in] length The length of the two parts of the arm.
+ * @param [in] velocity The hand velocity (x, y) in mm/s.
+ * @param [in] acceleration The hand acceleration (x, y) in mm/s^2.
+ * @param [out] joint_velocity Velocity of alpha and beta in rad/s.
+ * @param [out] joint_acceleration Acceleration of alpha and beta in rad/s^2.
+ * @returns 0 if the arm is too close to a singularity (fully extended or
+ * folded), in which case the outputs are set to zero, 1 otherwise.
+ */
+int arm_inverse_cinematics_derivatives(float alpha, float beta, float length[2],
+                                       const float velocity[2], const float acceleration[2],
+                                       float joint_velocity[2], float joint_acceleration[2]);
+
 float compute_shoulder_angle(point_t elbow, point_t hand);
 float compute_elbow_angle(point_t elbow, point_t hand);
 
@@ -1,10 +1,26 @@
+#include <stddef.h>
 #include "arm_cs.h"
 
+/** Sends the PID output plus the feedforward to the motor. */
+static void arm_cs_process_in(void *p, int32_t value)
+{
+    arm_control_loop_t *loop = (arm_control_loop_t *)p;
+
+    if (loop->pwm)
+        loop->pwm(loop->pwm_param, value + loop->feedforward);
+}
+
 void arm_cs_init_loop(arm_control_loop_t *loop)
 {
     cs_init(&loop->manager);
     pid_init(&loop->pid);
     cs_set_correct_filter(&loop->manager, pid_do_filter, &loop->pid);
+
+    loop->pwm = NULL;
+    loop->pwm_param = NULL;
+    loop->velocity_gain = 0;
+    loop->acceleration_gain = 0;
+    loop->feedforward = 0;
 }
 
 void arm_cs_manage(arm_control_loop_t *loop)
@@ -12,9 +28,17 @@ void arm_cs_manage(arm_control_loop_t *loop)
     cs_manage(&loop->manager);
 }
 
+void arm_cs_disable(arm_control_loop_t *loop)
+{
+    loop->feedforward = 0;
+    cs_disable(&loop->manager);
+}
+
 void arm_cs_connect_motor(arm_control_loop_t *loop,  void (*pwm)(void *, int32_t), void *pwm_param)
 {
-    cs_set_process_in(&loop->manager, pwm, pwm_param);
+    loop->pwm = pwm;
+    loop->pwm_param = pwm_param;
+    cs_set_process_in(&loop->manager, arm_cs_process_in, loop);
 }
 
 void arm_cs_connect_encoder(arm_control_loop_t *loop,  int32_t (*encoder)(void *), void *encoder_param)
@@ -22,3 +46,13 @@ void arm_cs_connect_encoder(arm_control_loop_t *loop,  int32_t (*encoder)(void *
     cs_set_process_out(&loop->manager, encoder, encoder_param);
 }
 
+void arm_cs_set_feedforward_gains(arm_control_loop_t *loop, float velocity_gain, float acceleration_gain)
+{
+    loop->velocity_gain = velocity_gain;
+    loop->acceleration_gain = acceleration_gain;
+}
+
+void arm_cs_set_reference_derivatives(arm_control_loop_t *loop, float velocity, float acceleration)
+{
+    loop->feedforward = loop->velocity_gain * velocity + loop->acceleration_gain * acceleration;
+}
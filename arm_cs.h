@@ -7,6 +7,15 @@
 typedef struct {
     struct pid_filter pid;
     struct cs manager;
+
+    /* Motor output, the control system calls it through arm_cs_process_in to
+     * add the feedforward. */
+    void (*pwm)(void *, int32_t);
+    void *pwm_param;
+
+    float velocity_gain;        /**< Feedforward PWM per impulsion/s of the reference. */
+    float acceleration_gain;    /**< Feedforward PWM per impulsion/s^2 of the reference. */
+    int32_t feedforward;        /**< Value added to the PID output. */
 } arm_control_loop_t;
 
 void arm_cs_init_loop(arm_control_loop_t *loop);
@@ -15,4 +24,18 @@ void arm_cs_connect_motor(arm_control_loop_t *loop,  void (*pwm)(void *, int32_t
 void arm_cs_connect_encoder(arm_control_loop_t *loop,  int32_t (*encoder)(void *), void *encoder_param);
 void arm_cs_manage(arm_control_loop_t *loop);
 
+/** Disables the loop and clears its feedforward, which would otherwise still
+ * be sent to the motor. */
+void arm_cs_disable(arm_control_loop_t *loop);
+
+/** Sets the feedforward gains of a loop. Both are zero after init. */
+void arm_cs_set_feedforward_gains(arm_control_loop_t *loop, float velocity_gain, float acceleration_gain);
+
+/** Gives the velocity and acceleration of the reference, used to compute the
+ * feedforward term.
+ * @param [in] velocity In impulsions per second.
+ * @param [in] acceleration In impulsions per second squared.
+ */
+void arm_cs_set_reference_derivatives(arm_control_loop_t *loop, float velocity, float acceleration);
+
 #endif
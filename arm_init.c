@@ -1,7 +1,12 @@
 #include <platform.h>
 #include <stdlib.h>
+#include <uptime.h>
 #include <cvra_dc.h>
 #include "arm.h"
+#include "arm_keyframe_pool.h"
+#include "motor_io.h"
+#include "periodic.h"
+#include "robot_events.h"
 #include "cvra_cs.h"
 #include <2wheels/trajectory_manager_utils.h>
 
@@ -11,19 +16,80 @@ OS_STK    control_task_stk[2048];
 OS_STK    cinematics_task_stk[2048];
 #define   CINEMATICS_TASK_PRIORITY 25
 
-void arm_cinematics_manage_task(void *dummy)
+/** Storage shared by all arm trajectories, to avoid using the heap at runtime. */
+#define   ARM_KEYFRAME_POOL_SIZE (64 * ARM_KEYFRAME_POOL_SLAB_FRAMES)
+static arm_keyframe_t keyframe_pool_buffer[ARM_KEYFRAME_POOL_SIZE];
+
+/** Period at which idle arms are checked for new trajectories, in us. */
+#define   ARM_IDLE_POLL_PERIOD 20000
+
+/** Period of the arm control loops, in us. */
+#define   ARM_CONTROL_PERIOD 10000
+
+static task_stats_t control_task_stats;
+static task_stats_t cinematics_task_stats;
+
+/** Encoders and PWMs of the arm joints. The z axes are on the base controller,
+ * whose other channels belong to the base control task. */
+static motor_io_t arms_io;
+static motor_io_t hex_io;
+
+void arm_cinematics_manage_task(__attribute__((unused)) void *dummy)
 {
-    dummy;
+    arm_t *arms[] = {&robot.right_arm, &robot.left_arm};
+    const uint32_t done_events[] = {ROBOT_EVENT_RIGHT_ARM_DONE, ROBOT_EVENT_LEFT_ARM_DONE};
+    periodic_t periodic[2];
+    int32_t now, sleep, left, wake_up;
+    int i, finished;
+
+    /* Runs once to put idle arms in a known state. */
+    for (i = 0; i < 2; i++) {
+        arm_manage(arms[i]);
+        periodic_init(&periodic[i], 0);
+    }
+
+    wake_up = uptime_get();
+
     while (1) {
-        arm_manage(&robot.right_arm);
-        arm_manage(&robot.left_arm);
-        OSTimeDlyHMSM(0, 0, 0, 20);
+        task_stats_begin(&cinematics_task_stats, wake_up, uptime_get());
+        sleep = ARM_IDLE_POLL_PERIOD;
+
+        /* Each arm runs at its own rate, and not at all when idle. */
+        for (i = 0; i < 2; i++) {
+            now = uptime_get();
+            periodic_set_period(&periodic[i], arm_get_manage_period(arms[i]), now);
+
+            if (periodic_is_due(&periodic[i], now)) {
+                finished = arm_manage(arms[i]);
+                periodic_advance(&periodic[i], uptime_get());
+
+                if (finished)
+                    robot_events_post(done_events[i]);
+            }
+
+            left = periodic_time_left(&periodic[i], uptime_get());
+            if (left >= 0 && left < sleep)
+                sleep = left;
+        }
+
+        task_stats_end(&cinematics_task_stats, uptime_get());
+
+        wake_up = uptime_get() + sleep;
+        periodic_sleep_us(sleep);
     }
 }
 
 void arm_control_manage_task(__attribute__((unused)) void *dummy)
 {
+    periodic_t periodic;
+
+    periodic_init(&periodic, ARM_CONTROL_PERIOD);
+    periodic_set_stats(&periodic, &control_task_stats);
+
     while (1) {
+        motor_io_read(&arms_io);
+        motor_io_read(&hex_io);
+
         arm_cs_manage(&robot.right_arm.z_axis);
         arm_cs_manage(&robot.left_arm.z_axis);
         arm_cs_manage(&robot.right_arm.shoulder);
@@ -32,7 +98,11 @@ void arm_control_manage_task(__attribute__((unused)) void *dummy)
         arm_cs_manage(&robot.left_arm.elbow);
         arm_cs_manage(&robot.right_arm.hand);
         arm_cs_manage(&robot.left_arm.hand);
-        OSTimeDlyHMSM(0, 0, 0, 10);
+
+        motor_io_write(&arms_io);
+        motor_io_write(&hex_io);
+
+        periodic_wait(&periodic);
     }
 }
 
@@ -45,33 +115,41 @@ void arm_highlevel_init(void)
         cvra_dc_set_encoder(ARMSMOTORCONTROLLER_BASE, i, 0);
 
     }
+
+    arm_keyframe_pool_init(keyframe_pool_buffer, ARM_KEYFRAME_POOL_SIZE);
+
+    task_stats_init(&control_task_stats, "arm_control");
+    task_stats_init(&cinematics_task_stats, "arm_cinematics");
+
     arm_init(&robot.right_arm);
     arm_init(&robot.left_arm);
 
+    motor_io_init(&arms_io, ARMSMOTORCONTROLLER_BASE);
+    motor_io_init(&hex_io, HEXMOTORCONTROLLER_BASE);
 
-    arm_cs_connect_motor(&robot.right_arm.z_axis, cvra_dc_set_pwm5, HEXMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.right_arm.z_axis, cvra_dc_get_encoder5, HEXMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.right_arm.z_axis, motor_io_set_pwm, motor_io_channel(&hex_io, 5));
+    arm_cs_connect_encoder(&robot.right_arm.z_axis, motor_io_get_encoder, motor_io_channel(&hex_io, 5));
 
-    arm_cs_connect_motor(&robot.left_arm.z_axis, cvra_dc_set_pwm0, HEXMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.left_arm.z_axis, cvra_dc_get_encoder0, HEXMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.left_arm.z_axis, motor_io_set_pwm, motor_io_channel(&hex_io, 0));
+    arm_cs_connect_encoder(&robot.left_arm.z_axis, motor_io_get_encoder, motor_io_channel(&hex_io, 0));
 
-    arm_cs_connect_motor(&robot.right_arm.shoulder, cvra_dc_set_pwm4, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.right_arm.shoulder, cvra_dc_get_encoder4, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.right_arm.shoulder, motor_io_set_pwm, motor_io_channel(&arms_io, 4));
+    arm_cs_connect_encoder(&robot.right_arm.shoulder, motor_io_get_encoder, motor_io_channel(&arms_io, 4));
 
-    arm_cs_connect_motor(&robot.right_arm.elbow, cvra_dc_set_pwm5, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.right_arm.elbow, cvra_dc_get_encoder5, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.right_arm.elbow, motor_io_set_pwm, motor_io_channel(&arms_io, 5));
+    arm_cs_connect_encoder(&robot.right_arm.elbow, motor_io_get_encoder, motor_io_channel(&arms_io, 5));
 
-    arm_cs_connect_motor(&robot.right_arm.hand, cvra_dc_set_pwm3, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.right_arm.hand, cvra_dc_get_encoder3, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.right_arm.hand, motor_io_set_pwm, motor_io_channel(&arms_io, 3));
+    arm_cs_connect_encoder(&robot.right_arm.hand, motor_io_get_encoder, motor_io_channel(&arms_io, 3));
 
-    arm_cs_connect_motor(&robot.left_arm.elbow, cvra_dc_set_pwm0, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.left_arm.elbow, cvra_dc_get_encoder0, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.left_arm.elbow, motor_io_set_pwm, motor_io_channel(&arms_io, 0));
+    arm_cs_connect_encoder(&robot.left_arm.elbow, motor_io_get_encoder, motor_io_channel(&arms_io, 0));
 
-    arm_cs_connect_motor(&robot.left_arm.hand, cvra_dc_set_pwm2, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.left_arm.hand, cvra_dc_get_encoder2, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.left_arm.hand, motor_io_set_pwm, motor_io_channel(&arms_io, 2));
+    arm_cs_connect_encoder(&robot.left_arm.hand, motor_io_get_encoder, motor_io_channel(&arms_io, 2));
 
-    arm_cs_connect_motor(&robot.left_arm.shoulder, cvra_dc_set_pwm1, ARMSMOTORCONTROLLER_BASE);
-    arm_cs_connect_encoder(&robot.left_arm.shoulder, cvra_dc_get_encoder1, ARMSMOTORCONTROLLER_BASE);
+    arm_cs_connect_motor(&robot.left_arm.shoulder, motor_io_set_pwm, motor_io_channel(&arms_io, 1));
+    arm_cs_connect_encoder(&robot.left_arm.shoulder, motor_io_get_encoder, motor_io_channel(&arms_io, 1));
 
     arm_set_physical_parameters(&robot.right_arm);
     arm_set_physical_parameters(&robot.left_arm);
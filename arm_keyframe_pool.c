@@ -0,0 +1,224 @@
+#include <platform.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arm_keyframe_pool.h"
+
+static struct {
+    arm_keyframe_t *buffer;
+    int slab_count;
+    int used_slabs;
+    int high_water_mark;
+    int heap_fallbacks;
+
+    /** Non zero if the slab is allocated. */
+    unsigned char used[ARM_KEYFRAME_POOL_MAX_SLABS];
+
+    /** Length in slabs of the allocation starting at this slab, 0 otherwise. */
+    unsigned char run[ARM_KEYFRAME_POOL_MAX_SLABS];
+
+    semaphore_t lock;
+} pool;
+
+static int slabs_for_frames(int frame_count)
+{
+    return (frame_count + ARM_KEYFRAME_POOL_SLAB_FRAMES - 1) / ARM_KEYFRAME_POOL_SLAB_FRAMES;
+}
+
+/** Returns the index of the slab containing frames, or -1 if it is not from the pool. */
+static int slab_index(arm_keyframe_t *frames)
+{
+    if (pool.buffer == NULL)
+        return -1;
+
+    if (frames < pool.buffer || frames >= pool.buffer + pool.slab_count * ARM_KEYFRAME_POOL_SLAB_FRAMES)
+        return -1;
+
+    return (frames - pool.buffer) / ARM_KEYFRAME_POOL_SLAB_FRAMES;
+}
+
+/** Returns the number of free slabs starting at index, up to max. */
+static int free_run_length(int index, int max)
+{
+    int len = 0;
+
+    while (index + len < pool.slab_count && len < max && !pool.used[index + len])
+        len++;
+
+    return len;
+}
+
+static void mark_slabs(int index, int count, int used)
+{
+    memset(&pool.used[index], used, count);
+    pool.used_slabs += used ? count : -count;
+
+    if (pool.used_slabs > pool.high_water_mark)
+        pool.high_water_mark = pool.used_slabs;
+}
+
+/** First fit search of count contiguous slabs. Must be called with the lock held. */
+static arm_keyframe_t *pool_alloc_locked(int count)
+{
+    int i, len;
+
+    for (i = 0; i + count <= pool.slab_count; i += len + 1) {
+        len = free_run_length(i, count);
+        if (len == count) {
+            mark_slabs(i, count, 1);
+            pool.run[i] = count;
+            return &pool.buffer[i * ARM_KEYFRAME_POOL_SLAB_FRAMES];
+        }
+    }
+
+    return NULL;
+}
+
+static void pool_free_locked(int index)
+{
+    mark_slabs(index, pool.run[index], 0);
+    pool.run[index] = 0;
+}
+
+void arm_keyframe_pool_init(arm_keyframe_t *buffer, int frame_count)
+{
+    memset(&pool, 0, sizeof(pool));
+
+    if (buffer == NULL)
+        return;
+
+    pool.buffer = buffer;
+    pool.slab_count = frame_count / ARM_KEYFRAME_POOL_SLAB_FRAMES;
+
+    if (pool.slab_count > ARM_KEYFRAME_POOL_MAX_SLABS)
+        pool.slab_count = ARM_KEYFRAME_POOL_MAX_SLABS;
+
+    platform_create_semaphore(&pool.lock, 1);
+}
+
+arm_keyframe_t *arm_keyframe_pool_alloc(int frame_count)
+{
+    return arm_keyframe_pool_realloc(NULL, frame_count);
+}
+
+arm_keyframe_t *arm_keyframe_pool_realloc(arm_keyframe_t *frames, int frame_count)
+{
+    arm_keyframe_t *result = NULL;
+    int index, count, old_count;
+
+    if (pool.buffer == NULL) {
+        result = realloc(frames, frame_count * sizeof(arm_keyframe_t));
+        if (result == NULL)
+            panic();
+        return result;
+    }
+
+    count = slabs_for_frames(frame_count);
+    if (count == 0)
+        count = 1;
+
+    platform_take_semaphore(&pool.lock);
+
+    index = frames == NULL ? -1 : slab_index(frames);
+
+    if (index >= 0) {
+        old_count = pool.run[index];
+
+        if (count <= old_count) {
+            result = frames;
+        } else if (free_run_length(index + old_count, count - old_count) == count - old_count) {
+            /* Slabs right after the block are free, grow it in place. */
+            mark_slabs(index + old_count, count - old_count, 1);
+            pool.run[index] = count;
+            result = frames;
+        } else {
+            result = pool_alloc_locked(count);
+            if (result != NULL) {
+                memcpy(result, frames, old_count * ARM_KEYFRAME_POOL_SLAB_FRAMES * sizeof(arm_keyframe_t));
+                pool_free_locked(index);
+            }
+        }
+    } else if (frames == NULL && count <= ARM_KEYFRAME_POOL_MAX_SLABS) {
+        result = pool_alloc_locked(count);
+    }
+
+    if (result == NULL)
+        pool.heap_fallbacks++;
+
+    platform_signal_semaphore(&pool.lock);
+
+    if (result != NULL)
+        return result;
+
+    /* Does not fit in the pool, use the heap instead. */
+    if (index >= 0) {
+        result = malloc(frame_count * sizeof(arm_keyframe_t));
+        if (result == NULL)
+            panic();
+
+        memcpy(result, frames, old_count * ARM_KEYFRAME_POOL_SLAB_FRAMES * sizeof(arm_keyframe_t));
+
+        platform_take_semaphore(&pool.lock);
+        pool_free_locked(index);
+        platform_signal_semaphore(&pool.lock);
+    } else {
+        result = realloc(frames, frame_count * sizeof(arm_keyframe_t));
+        if (result == NULL)
+            panic();
+    }
+
+    return result;
+}
+
+void arm_keyframe_pool_free(arm_keyframe_t *frames)
+{
+    int index;
+
+    if (frames == NULL)
+        return;
+
+    index = slab_index(frames);
+
+    if (index < 0) {
+        free(frames);
+        return;
+    }
+
+    platform_take_semaphore(&pool.lock);
+    pool_free_locked(index);
+    platform_signal_semaphore(&pool.lock);
+}
+
+void arm_keyframe_pool_get_stats(arm_keyframe_pool_stats_t *stats)
+{
+    int i, len;
+
+    memset(stats, 0, sizeof(arm_keyframe_pool_stats_t));
+
+    if (pool.buffer == NULL)
+        return;
+
+    platform_take_semaphore(&pool.lock);
+
+    stats->slab_count = pool.slab_count;
+    stats->used_slabs = pool.used_slabs;
+    stats->high_water_mark = pool.high_water_mark;
+    stats->heap_fallbacks = pool.heap_fallbacks;
+
+    for (i = 0; i < pool.slab_count; i += len + 1) {
+        len = free_run_length(i, pool.slab_count);
+        if (len > stats->largest_free_run)
+            stats->largest_free_run = len;
+    }
+
+    platform_signal_semaphore(&pool.lock);
+}
+
+int arm_keyframe_pool_fragmentation(arm_keyframe_pool_stats_t *stats)
+{
+    int free_slabs = stats->slab_count - stats->used_slabs;
+
+    if (free_slabs == 0)
+        return 0;
+
+    return 100 - (100 * stats->largest_free_run) / free_slabs;
+}
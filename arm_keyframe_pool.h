@@ -0,0 +1,60 @@
+#ifndef _ARM_KEYFRAME_POOL_H_
+#define _ARM_KEYFRAME_POOL_H_
+
+#include "keyframe.h"
+
+/** Number of keyframes in a slab, which is the allocation granularity of the pool. */
+#define ARM_KEYFRAME_POOL_SLAB_FRAMES 8
+
+/** Maximum number of slabs the pool can manage. */
+#define ARM_KEYFRAME_POOL_MAX_SLABS 128
+
+/** Usage statistics of the keyframe pool. */
+typedef struct {
+    int slab_count;         /**< Total number of slabs in the pool. */
+    int used_slabs;         /**< Number of slabs currently allocated. */
+    int high_water_mark;    /**< Maximum of used_slabs since init. */
+    int largest_free_run;   /**< Largest number of contiguous free slabs. */
+    int heap_fallbacks;     /**< Number of allocations that did not fit in the pool. */
+} arm_keyframe_pool_stats_t;
+
+/** Inits the keyframe pool on a given buffer.
+ *
+ * Until this function is called, every allocation is forwarded to the heap.
+ * @param [in] buffer The storage for the pool. It must stay valid forever.
+ * @param [in] frame_count The number of keyframes the buffer can hold.
+ * @note Passing a NULL buffer disables the pool.
+ * @warning Must be called before any trajectory is allocated from the pool.
+ */
+void arm_keyframe_pool_init(arm_keyframe_t *buffer, int frame_count);
+
+/** Allocates a contiguous array of keyframes.
+ *
+ * The memory is taken from the pool if possible, from the heap otherwise.
+ * @param [in] frame_count The number of frames to allocate.
+ * @return A pointer to the frames. Panics if no memory is available.
+ */
+arm_keyframe_t *arm_keyframe_pool_alloc(int frame_count);
+
+/** Resizes an array of keyframes, like realloc().
+ *
+ * The array is grown in place if the slabs after it are free.
+ * @param [in] frames The array to resize, may be NULL.
+ * @param [in] frame_count The new number of frames.
+ */
+arm_keyframe_t *arm_keyframe_pool_realloc(arm_keyframe_t *frames, int frame_count);
+
+/** Releases an array of keyframes. NULL is accepted. */
+void arm_keyframe_pool_free(arm_keyframe_t *frames);
+
+/** Gets the pool usage statistics. */
+void arm_keyframe_pool_get_stats(arm_keyframe_pool_stats_t *stats);
+
+/** Returns the pool fragmentation in percents.
+ *
+ * It is zero when all free slabs are contiguous, and increases as the free
+ * space gets split into small runs.
+ */
+int arm_keyframe_pool_fragmentation(arm_keyframe_pool_stats_t *stats);
+
+#endif
@@ -1,8 +1,12 @@
 #include "arm_trajectories.h"
+#include "arm_keyframe_pool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <uptime.h>
 
+/** Number of keyframes allocated for a trajectory when the first point is added. */
+#define ARM_TRAJECTORY_MIN_CAPACITY 8
+
 static float smoothstep(float t)
 {
     if(t < 0.0f) return 0.0f;
@@ -10,6 +14,20 @@ static float smoothstep(float t)
     return t*t*t*(t*(6.0f*t-15.0f)+10.0f);
 }
 
+/** First derivative of smoothstep with respect to t. */
+static float smoothstep_velocity(float t)
+{
+    if(t < 0.0f || t > 1.0f) return 0.0f;
+    return 30.0f*t*t*(t-1.0f)*(t-1.0f);
+}
+
+/** Second derivative of smoothstep with respect to t. */
+static float smoothstep_acceleration(float t)
+{
+    if(t < 0.0f || t > 1.0f) return 0.0f;
+    return 60.0f*t*(t-1.0f)*(2.0f*t-1.0f);
+}
+
 static float interpolate(float t, float a, float b)
 {
     return (1 - t) * a + t * b;
@@ -19,17 +37,44 @@ void arm_trajectory_init(arm_trajectory_t *traj) {
     memset(traj, 0, sizeof(arm_trajectory_t));
 }
 
+void arm_trajectory_init_static(arm_trajectory_t *traj, arm_keyframe_t *buffer, int capacity)
+{
+    arm_trajectory_init(traj);
+    traj->frames = buffer;
+    traj->capacity = capacity;
+    traj->is_static = 1;
+}
 
-void arm_trajectory_append_point(arm_trajectory_t *traj, const float x, const float y, const float z,
-                                   arm_coordinate_t system, const float duration)
+/** Makes sure the trajectory can hold at least count frames.
+ *
+ * The capacity is doubled every time, so building a trajectory of n points
+ * only needs O(log n) allocations.
+ */
+static void arm_trajectory_reserve(arm_trajectory_t *traj, int count)
 {
+    int capacity;
 
-    traj->frame_count += 1;
-    traj->frames = realloc(traj->frames, traj->frame_count*sizeof(arm_keyframe_t));
+    if (count <= traj->capacity)
+        return;
 
-    if (traj->frames == NULL)
+    if (traj->is_static)
         panic();
 
+    capacity = traj->capacity > 0 ? traj->capacity : ARM_TRAJECTORY_MIN_CAPACITY;
+    while (capacity < count)
+        capacity *= 2;
+
+    traj->frames = arm_keyframe_pool_realloc(traj->frames, capacity);
+    traj->capacity = capacity;
+}
+
+
+void arm_trajectory_append_point(arm_trajectory_t *traj, const float x, const float y, const float z,
+                                   arm_coordinate_t system, const float duration)
+{
+    arm_trajectory_reserve(traj, traj->frame_count + 1);
+    traj->frame_count += 1;
+
     traj->frames[traj->frame_count-1].position[0] = x;
     traj->frames[traj->frame_count-1].position[1] = y;
     traj->frames[traj->frame_count-1].position[2] = z;
@@ -60,18 +105,24 @@ void arm_trajectory_append_point_with_length(arm_trajectory_t *traj, const float
 
 void arm_trajectory_delete(arm_trajectory_t *traj)
 {
-    if (traj->frame_count != 0) {
-        free(traj->frames);
-        traj->frames = NULL;
-        traj->frame_count = 0;
-    }
+    traj->frame_count = 0;
+
+    if (traj->is_static)
+        return;
+
+    arm_keyframe_pool_free(traj->frames);
+    traj->frames = NULL;
+    traj->capacity = 0;
 }
 
 void arm_trajectory_copy(arm_trajectory_t *dest, arm_trajectory_t *src)
 {
+    /* No need to keep the old frames while growing. */
+    dest->frame_count = 0;
+    arm_trajectory_reserve(dest, src->frame_count);
+
+    memcpy(dest->frames, src->frames, src->frame_count * sizeof(arm_keyframe_t));
     dest->frame_count = src->frame_count;
-    dest->frames = malloc(dest->frame_count * sizeof(arm_keyframe_t));
-    memcpy(dest->frames, src->frames, dest->frame_count * sizeof(arm_keyframe_t));
 }
 
 int arm_trajectory_finished(arm_trajectory_t *traj)
@@ -118,3 +169,32 @@ arm_keyframe_t arm_trajectory_interpolate_keyframes(arm_keyframe_t k1, arm_keyfr
 
     return result;
 }
+
+arm_keyframe_derivatives_t arm_trajectory_interpolate_derivatives(arm_keyframe_t k1, arm_keyframe_t k2, int32_t date)
+{
+    arm_keyframe_derivatives_t result;
+    float t, duration, ds, dds;
+    int i;
+
+    /* Duration of the segment in seconds. */
+    duration = (k2.date - k1.date) / 1000000.f;
+
+    if (duration <= 0) {
+        ds = 0;
+        dds = 0;
+    } else {
+        t = (date - k1.date) / (float)(k2.date - k1.date);
+        ds = smoothstep_velocity(t) / duration;
+        dds = smoothstep_acceleration(t) / (duration * duration);
+    }
+
+    for (i=0; i<3; i++) {
+        result.velocity[i] = ds * (k2.position[i] - k1.position[i]);
+        result.acceleration[i] = dds * (k2.position[i] - k1.position[i]);
+    }
+
+    result.hand_velocity = ds * (k2.hand_angle - k1.hand_angle);
+    result.hand_acceleration = dds * (k2.hand_angle - k1.hand_angle);
+
+    return result;
+}
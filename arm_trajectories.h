@@ -21,14 +21,31 @@ void arm_trajectory_set_hand_angle(arm_trajectory_t *traj, float angle);
  */
 void arm_trajectory_init(arm_trajectory_t *traj);
 
+/** Inits a trajectory storing its frames in a caller provided buffer.
+ *
+ * Such a trajectory never allocates memory.
+ * @param traj The trajectory to init.
+ * @param [in] buffer Storage for the keyframes. It must outlive the trajectory.
+ * @param [in] capacity The number of keyframes the buffer can hold.
+ * @warning Adding more points than the buffer can hold will panic.
+ */
+void arm_trajectory_init_static(arm_trajectory_t *traj, arm_keyframe_t *buffer, int capacity);
+
 
 /** same as arm_trajectory_append_point but with a custom length. */
 void arm_trajectory_append_point_with_length(arm_trajectory_t *traj, const float x, const float y, const float z,
                                    arm_coordinate_t system, const float duration, const float l1, const float l2);
 
 
+/** Removes all points from a trajectory and frees its storage if it was
+ * allocated on the heap. */
 void arm_trajectory_delete(arm_trajectory_t *traj);
 
+/** Copies a trajectory.
+ *
+ * The destination buffer is reused if it is large enough.
+ * @note dest must have been initialized before.
+ */
 void arm_trajectory_copy(arm_trajectory_t *dest, arm_trajectory_t *src);
 
 int arm_trajectory_finished(arm_trajectory_t *traj);
@@ -39,4 +56,11 @@ int arm_trajectory_finished(arm_trajectory_t *traj);
  */
 arm_keyframe_t arm_trajectory_interpolate_keyframes(arm_keyframe_t k1, arm_keyframe_t k2, int32_t date);
 
+/** Computes the velocity and acceleration of the interpolation between two
+ * keyframes, using the analytic derivatives of the smoothstep.
+ *
+ * Both are zero outside of [k1.date, k2.date].
+ */
+arm_keyframe_derivatives_t arm_trajectory_interpolate_derivatives(arm_keyframe_t k1, arm_keyframe_t k2, int32_t date);
+
 #endif
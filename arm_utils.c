@@ -1,42 +1,56 @@
-
+#include <math.h>
 #include "arm_utils.h"
+#include "trig.h"
 
 
-point_t arm_coordinate_robot2arm(point_t target_point, vect2_cart offset_xy, float offset_angle)
+/** Rotates a point by -angle around the origin. */
+static point_t rotate_backward(float x, float y, float angle)
 {
-    vect2_cart target;
-    vect2_pol target_pol;
-    target.x = target_point.x;
-    target.y = target_point.y;
-
-    vect2_sub_cart(&target, &offset_xy, &target);
-    vect2_cart2pol(&target, &target_pol);
+    point_t result;
+    float s, c;
 
-    target_pol.theta -= offset_angle;
+    trig_sincos(angle, &s, &c);
 
-    vect2_pol2cart(&target_pol, &target);
+    result.x =  c * x + s * y;
+    result.y = -s * x + c * y;
 
-    target_point.x = target.x;
-    target_point.y = target.y;
+    return result;
+}
 
-    return target_point;
+point_t arm_coordinate_robot2arm(point_t target_point, vect2_cart offset_xy, float offset_angle)
+{
+    return rotate_backward(target_point.x - offset_xy.x,
+                           target_point.y - offset_xy.y, offset_angle);
 }
 
 point_t arm_coordinate_table2robot(point_t target_point, point_t robot_pos, float robot_a_rad)
 {
-    vect2_cart target;
-    vect2_pol target_pol;
+    return rotate_backward(target_point.x - robot_pos.x,
+                           target_point.y - robot_pos.y, robot_a_rad);
+}
+
+void arm_transform_table2arm(arm_transform_t *t, point_t robot_pos, float robot_a_rad,
+                             vect2_cart offset_xy, float offset_angle)
+{
+    float cos_o, sin_o;
 
-    target.x = target_point.x - robot_pos.x;
-    target.y = target_point.y - robot_pos.y;
+    trig_sincos(robot_a_rad + offset_angle, &t->sin_a, &t->cos_a);
+    trig_sincos(offset_angle, &sin_o, &cos_o);
 
-    vect2_cart2pol(&target, &target_pol);
-    /* XXX Not sure if it is -= or += here. */
-    target_pol.theta -= robot_a_rad;
-    vect2_pol2cart(&target_pol, &target);
+    /* Rotation of -(robot angle + offset angle) applied to the robot
+     * position, plus rotation of -offset angle applied to the shoulder offset. */
+    t->offset.x = -(t->cos_a * robot_pos.x + t->sin_a * robot_pos.y)
+                  - (cos_o * offset_xy.x + sin_o * offset_xy.y);
+    t->offset.y = -(-t->sin_a * robot_pos.x + t->cos_a * robot_pos.y)
+                  - (-sin_o * offset_xy.x + cos_o * offset_xy.y);
+}
+
+point_t arm_transform_apply(arm_transform_t *t, point_t p)
+{
+    point_t result;
 
-    target_point.x = target.x;
-    target_point.y = target.y;
+    result.x =  t->cos_a * p.x + t->sin_a * p.y + t->offset.x;
+    result.y = -t->sin_a * p.x + t->cos_a * p.y + t->offset.y;
 
-    return target_point;
+    return result;
 }
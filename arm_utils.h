@@ -11,4 +11,22 @@ point_t arm_coordinate_robot2arm(point_t target_point, vect2_cart offset_xy, flo
 
 point_t arm_coordinate_table2robot(point_t target_point, point_t robot_pos, float robot_a_rad);
 
+/** Rigid transform from table coordinates to arm coordinates. */
+typedef struct {
+    float cos_a, sin_a; /**< Rotation between table and arm frames. */
+    point_t offset;     /**< Translation, expressed in arm frame. */
+} arm_transform_t;
+
+/** Computes the transform equivalent to arm_coordinate_table2robot followed
+ * by arm_coordinate_robot2arm.
+ *
+ * This is where all the trigonometry happens, so the result should be kept as
+ * long as the robot does not move.
+ */
+void arm_transform_table2arm(arm_transform_t *t, point_t robot_pos, float robot_a_rad,
+                             vect2_cart offset_xy, float offset_angle);
+
+/** Applies a transform computed by arm_transform_table2arm to a point. */
+point_t arm_transform_apply(arm_transform_t *t, point_t p);
+
 #endif
@@ -0,0 +1,266 @@
+#include <string.h>
+#include <math.h>
+#include <platform.h>
+#include "beacon_tracker.h"
+#include "trig.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Critically damped alpha-beta filter : beta = alpha^2 / (2 - alpha). */
+#define DEFAULT_ALPHA 0.5f
+#define DEFAULT_BETA 0.15f
+
+void beacon_tracker_init(beacon_tracker_t *t)
+{
+    int i;
+
+    memset(t->tracks, 0, sizeof(t->tracks));
+    memset(t->published, 0, sizeof(t->published));
+    memset(t->previous, 0, sizeof(t->previous));
+
+    for (i = 0; i < BEACON_TRACKER_MAX_TRACKS; i++)
+        t->previous_track[i] = -1;
+
+    t->alpha = DEFAULT_ALPHA;
+    t->beta = DEFAULT_BETA;
+}
+
+void beacon_tracker_set_gains(beacon_tracker_t *t, float alpha, float beta)
+{
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+
+    OS_ENTER_CRITICAL();
+#endif
+    t->alpha = alpha;
+    t->beta = beta;
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+static void beacon_track_predict(beacon_track_t *track, int32_t date, float *x, float *y)
+{
+    float dt = (date - track->date) / 1e6f;
+
+    *x = track->x + track->vx * dt;
+    *y = track->y + track->vy * dt;
+}
+
+/** Returns the nearest active track not used yet in this update, or -1. */
+static int beacon_tracker_associate(beacon_tracker_t *t, float x, float y, int32_t date, uint32_t used)
+{
+    float px, py, d, best_d = (float)BEACON_TRACKER_GATE * BEACON_TRACKER_GATE;
+    int i, best = -1;
+
+    for (i = 0; i < BEACON_TRACKER_MAX_TRACKS; i++) {
+        if (!t->tracks[i].active || (used & (1 << i)))
+            continue;
+
+        beacon_track_predict(&t->tracks[i], date, &px, &py);
+        d = (px - x) * (px - x) + (py - y) * (py - y);
+
+        if (d < best_d) {
+            best_d = d;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+static int beacon_tracker_new_track(beacon_tracker_t *t, float x, float y, int32_t date)
+{
+    beacon_track_t *track;
+    int i;
+
+    for (i = 0; i < BEACON_TRACKER_MAX_TRACKS; i++) {
+        if (!t->tracks[i].active)
+            break;
+    }
+
+    if (i == BEACON_TRACKER_MAX_TRACKS)
+        return -1;
+
+    track = &t->tracks[i];
+    track->x = x;
+    track->y = y;
+    track->vx = 0;
+    track->vy = 0;
+    track->date = date;
+    track->last_seen = date;
+    track->hits = 1;
+    track->active = 1;
+
+    return i;
+}
+
+static void beacon_track_filter(beacon_track_t *track, float alpha, float beta,
+                                float x, float y, int32_t date)
+{
+    float px, py, dt = (date - track->date) / 1e6f;
+
+    beacon_track_predict(track, date, &px, &py);
+
+    track->x = px + alpha * (x - px);
+    track->y = py + alpha * (y - py);
+
+    if (dt > 0) {
+        track->vx += beta * (x - px) / dt;
+        track->vy += beta * (y - py) / dt;
+    }
+
+    track->date = date;
+    track->last_seen = date;
+    track->hits++;
+}
+
+void beacon_tracker_update(beacon_tracker_t *t, const beacon_tracker_reading_t *readings, int count,
+                           float robot_x, float robot_y, float robot_a, int32_t date)
+{
+    uint32_t used = 0;
+    float s, c, x, y, alpha, beta;
+    int i, id;
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+#endif
+
+    if (count > BEACON_TRACKER_MAX_TRACKS)
+        count = BEACON_TRACKER_MAX_TRACKS;
+
+#ifdef COMPILE_ON_ROBOT
+    OS_ENTER_CRITICAL();
+#endif
+    alpha = t->alpha;
+    beta = t->beta;
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+
+    for (i = 0; i < count; i++) {
+        if (readings[i].distance <= 0) {
+            t->previous_track[i] = -1;
+            continue;
+        }
+
+        /* The beacon did not refresh, the opponent is still there but this
+         * is not a new measure. */
+        if (readings[i].direction == t->previous[i].direction &&
+            readings[i].distance == t->previous[i].distance) {
+            id = t->previous_track[i];
+            if (id >= 0 && t->tracks[id].active) {
+                t->tracks[id].last_seen = date;
+                used |= 1 << id;
+            }
+            continue;
+        }
+
+        t->previous[i] = readings[i];
+
+        trig_sincos(robot_a + readings[i].direction * (float)M_PI / 180.f, &s, &c);
+        x = robot_x + readings[i].distance * c;
+        y = robot_y + readings[i].distance * s;
+
+        id = beacon_tracker_associate(t, x, y, date, used);
+
+        if (id >= 0)
+            beacon_track_filter(&t->tracks[id], alpha, beta, x, y, date);
+        else
+            id = beacon_tracker_new_track(t, x, y, date);
+
+        t->previous_track[i] = id;
+        if (id >= 0)
+            used |= 1 << id;
+    }
+
+    for (i = 0; i < BEACON_TRACKER_MAX_TRACKS; i++) {
+        if (t->tracks[i].active && date - t->tracks[i].last_seen > BEACON_TRACKER_TIMEOUT)
+            t->tracks[i].active = 0;
+    }
+
+#ifdef COMPILE_ON_ROBOT
+    OS_ENTER_CRITICAL();
+#endif
+    memcpy(t->published, t->tracks, sizeof(t->published));
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+int beacon_tracker_get_tracks(beacon_tracker_t *t, beacon_track_t *tracks, int max, int32_t date)
+{
+    beacon_track_t copy[BEACON_TRACKER_MAX_TRACKS];
+    int i, n = 0;
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+#endif
+
+#ifdef COMPILE_ON_ROBOT
+    OS_ENTER_CRITICAL();
+#endif
+    memcpy(copy, t->published, sizeof(copy));
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+
+    for (i = 0; i < BEACON_TRACKER_MAX_TRACKS && n < max; i++) {
+        if (!copy[i].active)
+            continue;
+
+        tracks[n] = copy[i];
+        beacon_track_predict(&copy[i], date, &tracks[n].x, &tracks[n].y);
+        tracks[n].date = date;
+        n++;
+    }
+
+    return n;
+}
+
+int32_t beacon_tracker_time_to_collision(beacon_tracker_t *t, float x, float y, float vx, float vy,
+                                         float radius, int32_t date)
+{
+    beacon_track_t tracks[BEACON_TRACKER_MAX_TRACKS];
+    float px, py, rvx, rvy, a, b, c, disc, time;
+    int32_t result = BEACON_TRACKER_NO_COLLISION, ms;
+    int i, n;
+
+    n = beacon_tracker_get_tracks(t, tracks, BEACON_TRACKER_MAX_TRACKS, date);
+
+    for (i = 0; i < n; i++) {
+        px = tracks[i].x - x;
+        py = tracks[i].y - y;
+
+        /* Only the opponents ahead of the robot. */
+        if (px * vx + py * vy <= 0)
+            continue;
+
+        c = px * px + py * py - radius * radius;
+
+        if (c <= 0) {
+            ms = 0;
+        } else {
+            /* Solves |p + (v_opp - v) * t| = radius for the first t > 0. */
+            rvx = tracks[i].vx - vx;
+            rvy = tracks[i].vy - vy;
+            a = rvx * rvx + rvy * rvy;
+            b = px * rvx + py * rvy;
+
+            if (a == 0 || b >= 0)
+                continue;
+
+            disc = b * b - a * c;
+            if (disc < 0)
+                continue;
+
+            time = (-b - sqrtf(disc)) / a;
+            ms = time * 1000 + 0.5f;
+        }
+
+        if (result == BEACON_TRACKER_NO_COLLISION || ms < result)
+            result = ms;
+    }
+
+    return result;
+}
@@ -0,0 +1,103 @@
+/** @file beacon_tracker.h
+ * @brief Tracks the opponents seen by the beacon in the table frame.
+ *
+ * The beacon gives the direction and distance of each opponent relative to
+ * the robot. Those readings are converted to the table frame using the
+ * odometry pose, then associated to the nearest track and filtered with an
+ * alpha-beta filter, which estimates both position and velocity.
+ *
+ * Tracks can then be predicted to any date, and checked for a collision
+ * with the robot along its current motion.
+ *
+ * Only one task, the control one, may call beacon_tracker_update. It
+ * filters a private copy of the tracks, then publishes it for the readers.
+ * Publishing and reading are short copies done with the interrupts
+ * disabled: a semaphore would let a low priority reader, such as the
+ * console, delay the control task.
+ */
+#ifndef _BEACON_TRACKER_H_
+#define _BEACON_TRACKER_H_
+
+#include <stdint.h>
+
+/** Maximum number of tracked opponents. */
+#define BEACON_TRACKER_MAX_TRACKS 4
+
+/** A reading further than this (in mm) from every track starts a new one. */
+#define BEACON_TRACKER_GATE 400
+
+/** Tracks without reading for this long (in us) are dropped. */
+#define BEACON_TRACKER_TIMEOUT 500000
+
+/** Returned by beacon_tracker_time_to_collision when there is no collision. */
+#define BEACON_TRACKER_NO_COLLISION -1
+
+/** A beacon reading, relative to the robot. */
+typedef struct {
+    float direction;        /**< Direction in degrees, 0 is the robot front. */
+    float distance;         /**< Distance in mm, 0 or less if nothing is seen. */
+} beacon_tracker_reading_t;
+
+typedef struct {
+    float x, y;             /**< Position in the table frame in mm. */
+    float vx, vy;           /**< Velocity in mm/s. */
+    int32_t date;           /**< Date of the filtered estimate in us. */
+    int32_t last_seen;      /**< Date the opponent was last seen, even without new reading. */
+    int hits;               /**< Number of readings used by this track. */
+    int active;
+} beacon_track_t;
+
+typedef struct {
+    beacon_track_t tracks[BEACON_TRACKER_MAX_TRACKS]; /**< Only used by the updating task. */
+    beacon_track_t published[BEACON_TRACKER_MAX_TRACKS]; /**< Copy given to the readers. */
+    beacon_tracker_reading_t previous[BEACON_TRACKER_MAX_TRACKS]; /**< Last readings, to skip repeats. */
+    int previous_track[BEACON_TRACKER_MAX_TRACKS]; /**< Track of each last reading, -1 if none. */
+    float alpha, beta;      /**< Filter gains, between 0 and 1. */
+} beacon_tracker_t;
+
+/** Inits a tracker, without any track. */
+void beacon_tracker_init(beacon_tracker_t *t);
+
+/** Sets the filter gains.
+ *
+ * @param [in] alpha Weight of a reading in the position estimate.
+ * @param [in] beta Weight of a reading in the velocity estimate. Must be
+ * smaller than alpha, lower values give smoother but slower estimates.
+ */
+void beacon_tracker_set_gains(beacon_tracker_t *t, float alpha, float beta);
+
+/** Feeds the beacon readings to the tracker.
+ *
+ * The beacon refreshes slower than the odometry, so readings identical to
+ * the previous ones are ignored instead of being counted as new measures.
+ *
+ * @param [in] readings The beacon readings, indexed like the beacon ones.
+ * @param [in] count The number of readings.
+ * @param [in] robot_x, robot_y Robot position in mm.
+ * @param [in] robot_a Robot heading in rad.
+ * @param [in] date Date of the readings in us.
+ */
+void beacon_tracker_update(beacon_tracker_t *t, const beacon_tracker_reading_t *readings, int count,
+                           float robot_x, float robot_y, float robot_a, int32_t date);
+
+/** Copies the active tracks, predicted to the given date.
+ * @returns The number of tracks copied.
+ */
+int beacon_tracker_get_tracks(beacon_tracker_t *t, beacon_track_t *tracks, int max, int32_t date);
+
+/** Computes when an opponent will get closer than radius to the robot,
+ * assuming everybody keeps the same velocity.
+ *
+ * Only the opponents the robot moves toward are considered, since stopping
+ * does not help against the others.
+ *
+ * @param [in] x, y Robot position in mm.
+ * @param [in] vx, vy Robot velocity in mm/s.
+ * @param [in] radius Minimal distance between the robot and an opponent center, in mm.
+ * @param [in] date Current date in us.
+ * @returns The time to collision in ms, or BEACON_TRACKER_NO_COLLISION.
+ */
+int32_t beacon_tracker_time_to_collision(beacon_tracker_t *t, float x, float y, float vx, float vy,
+                                         float radius, int32_t date);
+
+#endif
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "../arm.h"
+
+#define GRID_STEP 2.
+#define REPEAT 20
+
+/** Inverse cinematics the way arm_manage used to do it, for comparison. */
+static int circle_inverse_cinematics(point_t target, float length[2], shoulder_mode_t mode,
+                                     float *alpha, float *beta)
+{
+    point_t p1, p2;
+    int count;
+
+    count = compute_possible_elbow_positions(target, length[0], length[1], &p1, &p2);
+    if (count == 0)
+        return 0;
+
+    if (count == 2)
+        p1 = choose_shoulder_solution(target, p1, p2, mode);
+
+    *alpha = compute_shoulder_angle(p1, target);
+    *beta = compute_elbow_angle(p1, target) - *alpha;
+
+    if (*beta < -M_PI)
+        *beta += 2 * M_PI;
+    if (*beta > M_PI)
+        *beta -= 2 * M_PI;
+
+    return 1;
+}
+
+typedef int (*inverse_cinematics_t)(point_t, float *, shoulder_mode_t, float *, float *);
+
+/** Runs the given implementation over the whole workspace and prints the
+ * mean time per call and the worst position error. */
+static void benchmark(const char *name, inverse_cinematics_t ik, float length[2])
+{
+    point_t target, reached;
+    float alpha, beta, error, max_error = 0.;
+    float max_reach = length[0] + length[1];
+    long calls = 0;
+    clock_t start, duration;
+    int i;
+
+    start = clock();
+
+    for (i = 0; i < REPEAT; i++) {
+        for (target.x = -max_reach; target.x <= max_reach; target.x += GRID_STEP) {
+            for (target.y = -max_reach; target.y <= max_reach; target.y += GRID_STEP) {
+                if (!ik(target, length, SHOULDER_BACK, &alpha, &beta))
+                    continue;
+
+                calls++;
+
+                if (i == 0) {
+                    reached = arm_forward_cinematics(alpha, beta, length);
+                    error = hypotf(reached.x - target.x, reached.y - target.y);
+                    if (error > max_error)
+                        max_error = error;
+                }
+            }
+        }
+    }
+
+    duration = clock() - start;
+
+    printf("%s: %ld calls, %.1f ns/call, max error %g mm\n", name, calls,
+           1e9 * duration / CLOCKS_PER_SEC / calls, max_error);
+}
+
+int main(void)
+{
+    arm_t arm;
+
+    arm_init(&arm);
+    arm_set_physical_parameters(&arm);
+
+    benchmark("circle_intersect", circle_inverse_cinematics, arm.length);
+    benchmark("arm_inverse_cinematics", arm_inverse_cinematics, arm.length);
+
+    return 0;
+}
@@ -9,6 +9,7 @@
 
 #include <netif/slipif.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <uptime.h>
 #include "lua/lua.h"
 #include "lua/lauxlib.h"
@@ -16,11 +17,15 @@
 #include "cvra_cs.h"
 #include "strat_utils.h"
 #include "arm_trajectories.h"
+#include "arm_keyframe_pool.h"
+#include "task_stats.h"
+#include "console_output.h"
 #include "arm_init.h"
 #include <2wheels/trajectory_manager_utils.h>
 #include "2wheels/trajectory_manager.h"
 #include "strat_utils.h"
 #include "obstacle_avoidance_protocol.h"
+#include "pathplanner.h"
 #include <cvra_beacon.h>
 
 int cmd_pio_read(lua_State *l)
@@ -439,12 +444,70 @@ int cmd_arm_is_traj_finished(lua_State *l)
     else
         arm = &robot.right_arm;
 
-    lua_pushboolean(l, arm_trajectory_finished(&arm->trajectory));
+    lua_pushboolean(l, arm_is_trajectory_finished(arm));
 
     return 1;
 }
 
 
+/** Sets the rate of the cinematics of an arm while it moves.
+ * Usage : arm_set_rate("left", 100) for 100 Hz. */
+int cmd_arm_set_rate(lua_State *l)
+{
+    arm_t *arm;
+    int frequency;
+
+    if (lua_gettop(l) < 2)
+        return 0;
+
+    if (!strcmp(lua_tostring(l, -2), "left"))
+        arm = &robot.left_arm;
+    else
+        arm = &robot.right_arm;
+
+    frequency = lua_tointeger(l, -1);
+    if (frequency <= 0)
+        return 0;
+
+    arm_set_manage_period(arm, 1000000 / frequency);
+
+    return 0;
+}
+
+/** Sets the feedforward gains of an arm joint, shoulder, elbow, z or hand.
+ * Usage : arm_feedforward("left", "shoulder", kv, ka). */
+int cmd_arm_feedforward(lua_State *l)
+{
+    arm_t *arm;
+    arm_control_loop_t *loop;
+    const char *joint;
+
+    if (lua_gettop(l) < 4)
+        return 0;
+
+    if (!strcmp(lua_tostring(l, -4), "left"))
+        arm = &robot.left_arm;
+    else
+        arm = &robot.right_arm;
+
+    joint = lua_tostring(l, -3);
+
+    if (!strcmp(joint, "shoulder"))
+        loop = &arm->shoulder;
+    else if (!strcmp(joint, "elbow"))
+        loop = &arm->elbow;
+    else if (!strcmp(joint, "z"))
+        loop = &arm->z_axis;
+    else if (!strcmp(joint, "hand"))
+        loop = &arm->hand;
+    else
+        return 0;
+
+    arm_cs_set_feedforward_gains(loop, lua_tonumber(l, -2), lua_tonumber(l, -1));
+
+    return 0;
+}
+
 int cmd_arm_trajectory_create(lua_State *l)
 {
     arm_trajectory_t *t;
@@ -466,11 +529,110 @@ int cmd_arm_trajectory_delete(lua_State *l)
         return 0;
 
     t = lua_touserdata(l, -1);
+    if (t == NULL)
+        return 0;
+
+    arm_trajectory_delete(t);
     free(t);
 
     return 0;
 }
 
+/** Prints the usage of the keyframe pool and returns the used slab count,
+ * the high water mark and the fragmentation in percents. */
+int cmd_arm_pool_stats(lua_State *l)
+{
+    arm_keyframe_pool_stats_t stats;
+    int fragmentation;
+
+    arm_keyframe_pool_get_stats(&stats);
+    fragmentation = arm_keyframe_pool_fragmentation(&stats);
+
+    printf("keyframe pool: %d/%d slabs used (high water mark %d)\n",
+            stats.used_slabs, stats.slab_count, stats.high_water_mark);
+    printf("largest free run: %d slabs, fragmentation: %d%%, heap fallbacks: %d\n",
+            stats.largest_free_run, fragmentation, stats.heap_fallbacks);
+
+    lua_pushinteger(l, stats.used_slabs);
+    lua_pushinteger(l, stats.high_water_mark);
+    lua_pushinteger(l, fragmentation);
+
+    return 3;
+}
+
+/** Prints to the console which runs the command, or to the serial port if
+ * it does not come from the TCP console. */
+static void console_printf(lua_State *l, const char *format, ...)
+{
+    console_output_t *output;
+    char buffer[128];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buffer, sizeof(buffer), format, ap);
+    va_end(ap);
+
+    lua_getglobal(l, "__output");
+    output = lua_touserdata(l, -1);
+    lua_pop(l, 1);
+
+    if (output != NULL)
+        console_output_puts(output, buffer);
+    else
+        printf("%s", buffer);
+}
+
+/** Prints the execution time and lateness of the periodic tasks, in us. */
+int cmd_task_stats(lua_State *l)
+{
+    task_stats_t *s;
+    int i, j;
+
+    console_printf(l, "%-16s %8s %6s %6s %6s %8s %8s %8s\r\n", "task", "count", "min",
+            "mean", "max", "late min", "late avg", "late max");
+
+    for (i = 0; i < task_stats_count(); i++) {
+        s = task_stats_get(i);
+        if (s->count == 0) {
+            console_printf(l, "%-16s %8d\r\n", s->name, 0);
+            continue;
+        }
+
+        console_printf(l, "%-16s %8d %6d %6d %6d %8d %8d %8d\r\n", s->name, s->count,
+                s->min_time, task_stats_mean_time(s), s->max_time,
+                s->min_lateness, task_stats_mean_lateness(s), s->max_lateness);
+
+        /* Histogram of the execution times, log2 buckets. */
+        console_printf(l, "%-16s", "");
+        for (j = 0; j < TASK_STATS_HISTOGRAM_SIZE; j++) {
+            if (s->histogram[j])
+                console_printf(l, " <%d:%d", 2 << j, s->histogram[j]);
+        }
+        console_printf(l, "\r\n");
+    }
+
+    return 0;
+}
+
+/** Resets the stats of the task given as argument, or of all tasks. */
+int cmd_task_stats_reset(lua_State *l)
+{
+    task_stats_t *s;
+    int i;
+
+    if (lua_gettop(l) > 0) {
+        s = task_stats_find(lua_tostring(l, -1));
+        if (s != NULL)
+            task_stats_request_reset(s);
+        return 0;
+    }
+
+    for (i = 0; i < task_stats_count(); i++)
+        task_stats_request_reset(task_stats_get(i));
+
+    return 0;
+}
+
 int cmd_arm_trajectory_append(lua_State *l)
 {
     float x,y,z, duration;
@@ -568,15 +730,17 @@ int cmd_arm_do_traj(lua_State *l)
 
 int cmd_arm_shutdown(lua_State *l)
 {
-    arm_trajectory_t *traj;
+    arm_t *arm;
 
     if (lua_gettop(l) < 1)
         return 0;
 
     if (!strcmp(lua_tostring(l, -1), "left"))
-        traj = &robot.left_arm.trajectory;
+        arm = &robot.left_arm;
     else
-        traj = &robot.right_arm.trajectory;
+        arm = &robot.right_arm;
+
+    arm_shutdown(arm);
 
     return 0;
 }
@@ -621,7 +785,7 @@ int cmd_generate_distance_data(lua_State *l)
     static int data[SAMPLE_POINTS][3];
 
     int i;
-    struct netconn *conn;
+    console_output_t *output;
     int pwm_val=0;
     int divider;
 
@@ -632,8 +796,8 @@ int cmd_generate_distance_data(lua_State *l)
     else
         divider = 3;
 
-    lua_getglobal(l, "__conn");
-    conn = lua_touserdata(l, -1);
+    lua_getglobal(l, "__output");
+    output = lua_touserdata(l, -1);
 
     srand(uptime_get());
 
@@ -657,7 +821,7 @@ int cmd_generate_distance_data(lua_State *l)
     for (i=0;i<SAMPLE_POINTS;i++)
     {
         sprintf(buffer, "%d;%d;%d\r\n", data[i][0], data[i][1], data[i][2]);
-        netconn_write(conn, buffer, strlen(buffer), NETCONN_COPY);
+        console_output_puts(output, buffer);
     }
 
     return 0;
@@ -669,61 +833,167 @@ int cmd_start(lua_State *l)
     return 0;
 }
 
-int cmd_pathplanner_test(lua_State *l)
-{
-    obstacle_avoidance_request_t request;
-    obstacle_avoidance_path_t path;
-    struct ip_addr server;
+/** Maximum number of points asked to the path planner. */
+#define PATHPLANNER_MAX_POINTS 1000
 
-//    IP4
+/** Number of points asked for each goal compared by pp_eval. */
+#define PATHPLANNER_EVAL_POINTS 100
 
-    if (lua_gettop(l) < 2)
-        return 0;
+/** Time between two points of the paths, in ms. The follower interpolates
+ * between them. */
+#define PATHPLANNER_SAMPLERATE 200
+
+/** Time after which a path planner request is given up, in ms. */
+#define PATHPLANNER_TIMEOUT 2000
+
+/** Period at which pp_go asks for a new path while following the current one, in us. */
+#define PATHPLANNER_REPLAN_PERIOD 1000000
 
-    obstacle_avoidance_request_create(&request, 0);
+/** Period at which pp_go checks for a new path, in ms. */
+#define PATHPLANNER_POLL_PERIOD 50
 
-    request.end.x = lua_tointeger(l, -2);
-    request.end.y = lua_tointeger(l, -1);
+/** Submits a request from the robot position to the given goal.
+ * @returns The handle of the request, or an error. */
+static int pathplanner_submit(int x, int y, obstacle_avoidance_point_t *points, int max_points)
+{
+    obstacle_avoidance_request_t request;
+    beacon_track_t tracks[BEACON_TRACKER_MAX_TRACKS];
+    float vx, vy;
+    int count, i, handle;
+
+    /* Sends the opponents with their velocity, so the server can predict them. */
+    count = beacon_tracker_get_tracks(&robot.tracker, tracks, BEACON_TRACKER_MAX_TRACKS, uptime_get());
+    obstacle_avoidance_request_create(&request, count);
+
+    for (i = 0; i < count; i++) {
+        request.obstacles[i].x = tracks[i].x;
+        request.obstacles[i].y = tracks[i].y;
+        request.obstacles[i].vx = tracks[i].vx;
+        request.obstacles[i].vy = tracks[i].vy;
+        request.obstacles[i].r = 300; /* mm */
+    }
+
+    request.end.x = x;
+    request.end.y = y;
 
     request.start.x = position_get_x_float(&robot.pos);
     request.start.y = position_get_y_float(&robot.pos);
+    strat_get_velocity(&vx, &vy);
+    request.start.vx = vx;
+    request.start.vy = vy;
 
-    request.desired_samplerate = 200;
-    request.desired_datapoints = 1000;
+    request.desired_samplerate = PATHPLANNER_SAMPLERATE;
+    request.desired_datapoints = max_points;
 
-    IP4_ADDR(&server, 192,168,1,10);
+    handle = obstacle_avoidance_client_submit(&pathplanner, &request, points, max_points, PATHPLANNER_TIMEOUT);
+    obstacle_avoidance_request_delete(&request);
 
-    int ret = obstacle_avoidance_send_request(&request, server, 1337, &path);
-//    obstacle_avoidance_request_delete(&request);
-//
+    return handle;
+}
 
-    int i;
+int cmd_pathplanner_test(lua_State *l)
+{
+    /* The next path is received in one buffer while the other is followed. */
+    static obstacle_avoidance_point_t points[2][PATHPLANNER_MAX_POINTS];
+    obstacle_avoidance_path_t path, next;
+    timestamp_t replan_date;
+    int x, y, current = 0, handle, ret;
+
+    if (lua_gettop(l) < 2)
+        return 0;
+
+    x = lua_tointeger(l, -2);
+    y = lua_tointeger(l, -1);
+
+    ret = handle = pathplanner_submit(x, y, points[current], PATHPLANNER_MAX_POINTS);
+
+    if (handle >= 0) {
+        ret = obstacle_avoidance_client_wait(&pathplanner, handle, &path);
+        obstacle_avoidance_client_release(&pathplanner, handle);
+    }
 
-    if (ret == ERR_OK) {
+    if (ret == ERR_OK && path.len > 0) {
         lua_pushinteger(l, path.len);
     } else {
         lua_pushinteger(l, ret);
         return 1;
     }
 
-    timestamp_t start_date = uptime_get();
+    /* The follower drives the consigns at the control rate from now on. */
+    trajectory_hardstop(&robot.traj);
+    replan_date = uptime_get();
+    path_follower_start(&robot.follower, &path, replan_date);
+    handle = -1;
+
+    while (path_follower_is_active(&robot.follower)) {
+        /* Asks for a new path in the background, the current one is followed meanwhile. */
+        if (handle < 0 && uptime_get() - replan_date > PATHPLANNER_REPLAN_PERIOD) {
+            replan_date = uptime_get();
+            handle = pathplanner_submit(x, y, points[!current], PATHPLANNER_MAX_POINTS);
+        }
+
+        if (handle >= 0) {
+            ret = obstacle_avoidance_client_poll(&pathplanner, handle, &next);
+
+            if (ret != OBSTACLE_AVOIDANCE_PENDING) {
+                obstacle_avoidance_client_release(&pathplanner, handle);
+                handle = -1;
+
+                /* Its timestamps start when it was asked for. */
+                if (ret == ERR_OK && next.len > 0) {
+                    path_follower_start(&robot.follower, &next, replan_date);
+                    current = !current;
+                }
+            }
+        }
+
+        OSTimeDlyHMSM(0,0,0,PATHPLANNER_POLL_PERIOD);
+    }
 
-    int delta;
+    /* The worker must be done with the buffer before the next call. */
+    if (handle >= 0) {
+        obstacle_avoidance_client_wait(&pathplanner, handle, NULL);
+        obstacle_avoidance_client_release(&pathplanner, handle);
+    }
 
-    do {
-        delta = uptime_get() - start_date;
-        delta = delta / 1000; // us to ms
+    return 1;
+}
 
-        for (i=0;delta > path.points[i].timestamp;i++);
+/** Asks the path planner for several goals at once, given as x, y pairs.
+ * Returns, for each goal, the time to reach it in ms or a negative error. */
+int cmd_pathplanner_eval(lua_State *l)
+{
+    static obstacle_avoidance_point_t points[OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS][PATHPLANNER_EVAL_POINTS];
+    obstacle_avoidance_path_t path;
+    int handle[OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS];
+    int count = lua_gettop(l) / 2, i, ret;
 
-        i--;
+    if (count > OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS)
+        count = OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS;
 
-        trajectory_goto_forward_xy_abs(&robot.traj, path.points[i].x, path.points[i].y);
-        OSTimeDlyHMSM(0,0,0,request.desired_samplerate);
-    } while (delta < path.points[path.len-1].timestamp);
+    /* All the requests are submitted before waiting, so they are planned in parallel. */
+    for (i = 0; i < count; i++) {
+        handle[i] = pathplanner_submit(lua_tointeger(l, 2 * i + 1), lua_tointeger(l, 2 * i + 2),
+                                       points[i], PATHPLANNER_EVAL_POINTS);
+    }
 
+    for (i = 0; i < count; i++) {
+        ret = handle[i];
 
-    return 1;
+        if (ret >= 0) {
+            ret = obstacle_avoidance_client_wait(&pathplanner, handle[i], &path);
+            obstacle_avoidance_client_release(&pathplanner, handle[i]);
+        }
+
+        if (ret == ERR_OK && path.len > 0)
+            ret = path.points[path.len - 1].timestamp;
+        else if (ret == ERR_OK)
+            ret = ERR_VAL;
+
+        lua_pushinteger(l, ret);
+    }
+
+    return count;
 }
 
 int cmd_beacon_test(lua_State *l)
@@ -822,6 +1092,12 @@ void commands_register(lua_State *l)
     lua_pushcfunction(l, cmd_arm_is_traj_finished);
     lua_setglobal(l, "arm_traj_finished");
 
+    lua_pushcfunction(l, cmd_arm_set_rate);
+    lua_setglobal(l, "arm_set_rate");
+
+    lua_pushcfunction(l, cmd_arm_feedforward);
+    lua_setglobal(l, "arm_feedforward");
+
     lua_pushcfunction(l, cmd_arm_trajectory_create);
     lua_setglobal(l, "arm_traj_create");
 
@@ -831,6 +1107,15 @@ void commands_register(lua_State *l)
     lua_pushcfunction(l, cmd_arm_trajectory_append);
     lua_setglobal(l, "arm_traj_append");
 
+    lua_pushcfunction(l, cmd_arm_pool_stats);
+    lua_setglobal(l, "arm_pool_stats");
+
+    lua_pushcfunction(l, cmd_task_stats);
+    lua_setglobal(l, "task_stats");
+
+    lua_pushcfunction(l, cmd_task_stats_reset);
+    lua_setglobal(l, "task_stats_reset");
+
     lua_pushcfunction(l, cmd_arm_trajectory_set_hand_angle);
     lua_setglobal(l, "arm_traj_set_hand_angle");
 
@@ -855,6 +1140,9 @@ void commands_register(lua_State *l)
     lua_pushcfunction(l, cmd_pathplanner_test);
     lua_setglobal(l, "pp_go");
 
+    lua_pushcfunction(l, cmd_pathplanner_eval);
+    lua_setglobal(l, "pp_eval");
+
     lua_pushcfunction(l, cmd_beacon_test);
     lua_setglobal(l, "beacon");
 
@@ -879,6 +1167,9 @@ void commands_register(lua_State *l)
     lua_pushinteger(l, END_TIMER);
     lua_setglobal(l, "END_TIMER");
 
+    lua_pushinteger(l, END_TIMEOUT);
+    lua_setglobal(l, "END_TIMEOUT");
+
     lua_pushinteger(l, COORDINATE_ARM);
     lua_setglobal(l, "COORDINATE_ARM");
 
@@ -0,0 +1,91 @@
+#include <string.h>
+#include <uptime.h>
+#include "console_output.h"
+
+void console_output_init(console_output_t *o, void (*send)(void *, const char *, int), void *send_arg)
+{
+    o->len = 0;
+    o->first_write = 0;
+    o->send = send;
+    o->send_arg = send_arg;
+    platform_create_semaphore(&o->lock, 1);
+}
+
+void console_output_open(console_output_t *o, void (*send)(void *, const char *, int), void *send_arg)
+{
+    platform_take_semaphore(&o->lock);
+    o->len = 0;
+    o->send = send;
+    o->send_arg = send_arg;
+    platform_signal_semaphore(&o->lock);
+}
+
+void console_output_close(console_output_t *o)
+{
+    platform_take_semaphore(&o->lock);
+    o->len = 0;
+    o->send = NULL;
+    platform_signal_semaphore(&o->lock);
+}
+
+/** Sends the buffered data, the lock must be taken. */
+static void output_flush(console_output_t *o)
+{
+    if (o->len > 0 && o->send != NULL)
+        o->send(o->send_arg, o->data, o->len);
+
+    o->len = 0;
+}
+
+void console_output_flush(console_output_t *o)
+{
+    platform_take_semaphore(&o->lock);
+    output_flush(o);
+    platform_signal_semaphore(&o->lock);
+}
+
+void console_output_poll(console_output_t *o)
+{
+    platform_take_semaphore(&o->lock);
+
+    if (o->len > 0 && uptime_get() - o->first_write >= CONSOLE_OUTPUT_FLUSH_DELAY)
+        output_flush(o);
+
+    platform_signal_semaphore(&o->lock);
+}
+
+void console_output_write(console_output_t *o, const char *data, int len)
+{
+    if (len <= 0)
+        return;
+
+    platform_take_semaphore(&o->lock);
+
+    if (o->len + len > CONSOLE_OUTPUT_SIZE)
+        output_flush(o);
+
+    /* Copying would only split it in more segments. */
+    if (len > CONSOLE_OUTPUT_SIZE) {
+        if (o->send != NULL)
+            o->send(o->send_arg, data, len);
+        platform_signal_semaphore(&o->lock);
+        return;
+    }
+
+    if (o->len == 0)
+        o->first_write = uptime_get();
+
+    memcpy(&o->data[o->len], data, len);
+    o->len += len;
+
+    if (o->len == CONSOLE_OUTPUT_SIZE
+        || uptime_get() - o->first_write >= CONSOLE_OUTPUT_FLUSH_DELAY)
+        output_flush(o);
+
+    platform_signal_semaphore(&o->lock);
+}
+
+void console_output_puts(console_output_t *o, const char *s)
+{
+    console_output_write(o, s, strlen(s));
+}
@@ -0,0 +1,69 @@
+/** @file console_output.h
+ * @brief Coalesces the small writes of the Lua console.
+ *
+ * Each print used to be sent on its own, followed by another write for the
+ * line ending, so a chatty script produced a flood of tiny TCP segments over
+ * the serial line. The console now appends its output to a per connection
+ * buffer instead, which is sent :
+ * - when it is full,
+ * - when the console waits for the next command, after the prompt,
+ * - when the oldest buffered byte is older than CONSOLE_OUTPUT_FLUSH_DELAY.
+ *
+ * The age is checked on each write, and by console_output_poll, which the
+ * console calls periodically from another task. The output printed before a
+ * long blocking command is then sent without waiting for the prompt.
+ *
+ * The buffer is protected by a semaphore. It is only shared by the console
+ * tasks, never by the control ones.
+ */
+#ifndef _CONSOLE_OUTPUT_H_
+#define _CONSOLE_OUTPUT_H_
+
+#include <stdint.h>
+#include <platform.h>
+
+/** Size of the buffer, a bit less than the default TCP segment. */
+#define CONSOLE_OUTPUT_SIZE 512
+
+/** Maximum time data stays in the buffer while the script prints, in us. */
+#define CONSOLE_OUTPUT_FLUSH_DELAY 50000
+
+typedef struct {
+    char data[CONSOLE_OUTPUT_SIZE];
+    int len;
+    int32_t first_write;        /**< Uptime of the oldest buffered byte. */
+
+    /** Sends the buffered data, for example with netconn_write. */
+    void (*send)(void *arg, const char *data, int len);
+    void *send_arg;
+
+    semaphore_t lock;
+} console_output_t;
+
+/** Inits an empty buffer. Must only be called once per buffer. */
+void console_output_init(console_output_t *o, void (*send)(void *, const char *, int), void *send_arg);
+
+/** Empties the buffer and sends the following data with another function,
+ * for example to the next connection. */
+void console_output_open(console_output_t *o, void (*send)(void *, const char *, int), void *send_arg);
+
+/** Drops the buffered data, nothing is sent until the buffer is opened again. */
+void console_output_close(console_output_t *o);
+
+/** Appends data to the buffer.
+ *
+ * Data which does not fit in an empty buffer is sent directly, after what
+ * was buffered.
+ */
+void console_output_write(console_output_t *o, const char *data, int len);
+
+/** Appends a null terminated string. */
+void console_output_puts(console_output_t *o, const char *s);
+
+/** Sends the buffered data, if any. */
+void console_output_flush(console_output_t *o);
+
+/** Sends the buffered data if it is older than CONSOLE_OUTPUT_FLUSH_DELAY. */
+void console_output_poll(console_output_t *o);
+
+#endif
@@ -14,6 +14,14 @@
  PID is then applied to the motor via the PWM.
  The others functions computed here are the position manager, the trajectory
  manager and the blocking detection system.
+
+ The trajectory manager keeps its own task, which sets the targets of the
+ ramps. Everything else runs in a single task, in the order of the data
+ flow : encoders are read, the position is computed from this reading, the
+ consigns are updated from the new position, then the regulators write the
+ PWMs. This way each stage works on the data of the current period, and the
+ time from the encoder reading to the PWM writing is bounded by the execution
+ time of the stages. It is measured in the "cs_latency" task stats.
  */
 
 #include <2wheels/trajectory_manager.h>
@@ -26,6 +34,7 @@
 #include <2wheels/trajectory_manager_utils.h>
 
 #include <aversive/error.h>
+#include <uptime.h>
 #include "error_numbers.h"
 
 #include <string.h>
@@ -33,17 +42,34 @@
 
 #include "cvra_cs.h"
 #include "hardware.h"
+#include "motor_io.h"
+#include "periodic.h"
+#include "robot_events.h"
 
 
 struct _rob robot;
 
 OS_STK    cs_task_stk[2048];
-OS_STK    odometry_task_stk[2048];
 #define   CS_TASK_PRIORITY            21
-#define   ODOMETRY_TASK_PRIORITY      22
+
+/** The beacon readings do not change as often, so the tracker runs at a
+ * fraction of the control rate. */
+#define BEACON_TRACKER_FREQUENCY 50
 
 static void cvra_cs_manage_task(void * dummy);
-static void odometry_manage_task(void *dummy);
+
+static task_stats_t cs_task_stats;
+
+/** Encoders and PWMs of the wheels, on the base controller. */
+static motor_io_t base_io;
+
+/** Time from the encoder reading to the PWM writing, and lateness of the
+ * encoder reading. */
+static task_stats_t cs_latency_stats;
+
+static void beacon_tracker_manage(void);
+
+static void path_follower_manage(void);
 
 void cvra_cs_init(void)
 {
@@ -69,12 +95,13 @@ void cvra_cs_init(void)
     /*                         Encoders & PWMs                                  */
     /****************************************************************************/
 #ifdef COMPILE_ON_ROBOT
-    rs_set_left_pwm(&robot.rs, cvra_dc_set_pwm1, HEXMOTORCONTROLLER_BASE);
-    rs_set_right_pwm(&robot.rs, cvra_dc_set_pwm2_negative, HEXMOTORCONTROLLER_BASE);
-    rs_set_left_ext_encoder(&robot.rs, cvra_dc_get_encoder4, HEXMOTORCONTROLLER_BASE, 1.);
-    rs_set_right_ext_encoder(&robot.rs, cvra_dc_get_encoder3, HEXMOTORCONTROLLER_BASE,-1.);
-    rs_set_left_mot_encoder(&robot.rs, cvra_dc_get_encoder1, HEXMOTORCONTROLLER_BASE, -1.);
-    rs_set_right_mot_encoder(&robot.rs, cvra_dc_get_encoder2, HEXMOTORCONTROLLER_BASE,-1.);
+    motor_io_init(&base_io, HEXMOTORCONTROLLER_BASE);
+    rs_set_left_pwm(&robot.rs, motor_io_set_pwm, motor_io_channel(&base_io, 1));
+    rs_set_right_pwm(&robot.rs, motor_io_set_pwm_negative, motor_io_channel(&base_io, 2));
+    rs_set_left_ext_encoder(&robot.rs, motor_io_get_encoder, motor_io_channel(&base_io, 4), 1.);
+    rs_set_right_ext_encoder(&robot.rs, motor_io_get_encoder, motor_io_channel(&base_io, 3),-1.);
+    rs_set_left_mot_encoder(&robot.rs, motor_io_get_encoder, motor_io_channel(&base_io, 1), -1.);
+    rs_set_right_mot_encoder(&robot.rs, motor_io_get_encoder, motor_io_channel(&base_io, 2),-1.);
 
     rs_set_flags(&robot.rs, RS_USE_EXT);
 
@@ -148,10 +175,16 @@ void cvra_cs_init(void)
 
     robot.is_aligning = 0;
 
+    beacon_tracker_init(&robot.tracker);
+    path_follower_init(&robot.follower);
+
     // Initialisation deplacement:
     position_set(&robot.pos, 0, 0, 0);
 
 
+    task_stats_init(&cs_task_stats, "cs");
+    task_stats_init(&cs_latency_stats, "cs_latency");
+
 #if 1
     /* Creates the control task. */
     OSTaskCreateExt(cvra_cs_manage_task,
@@ -162,23 +195,29 @@ void cvra_cs_init(void)
                     &cs_task_stk[0],
                     2048, /* stack size */
                     NULL, NULL);
-
-    /* Creates the control task. */
-    OSTaskCreateExt(odometry_manage_task,
-                    NULL,
-                    &odometry_task_stk[2047],
-                    ODOMETRY_TASK_PRIORITY,
-                    ODOMETRY_TASK_PRIORITY,
-                    &odometry_task_stk[0],
-                    2048, /* stack size */
-                    NULL, NULL);
 #endif
 }
 
 void cvra_cs_manage_task(__attribute__((unused)) void * dummy)
 {
+    periodic_t periodic;
+    int32_t wake_up;
+    int beacon_divider = 0;
+
+    periodic_init(&periodic, 1000000 / ASSERV_FREQUENCY);
+    periodic_set_stats(&periodic, &cs_task_stats);
+    wake_up = uptime_get();
+
     while(1) {
+        task_stats_begin(&cs_latency_stats, wake_up, uptime_get());
+
+        /* Reads the encoders, then computes the position from this reading. */
+        motor_io_read(&base_io);
         rs_update(&robot.rs);
+        position_manage(&robot.pos);
+
+        if (path_follower_is_active(&robot.follower))
+            path_follower_manage();
 
         /* Gestion de l'asservissement. */
         if (robot.mode != BOARD_MODE_SET_PWM) {
@@ -195,21 +234,69 @@ void cvra_cs_manage_task(__attribute__((unused)) void * dummy)
             }
         }
 
+        motor_io_write(&base_io);
+        task_stats_end(&cs_latency_stats, uptime_get());
+
         /* Gestion du blocage */
         bd_manage(&robot.angle_bd);
         bd_manage(&robot.distance_bd);
 
-        /* Wait 10 milliseconds (100 Hz) */
-        OSTimeDlyHMSM(0, 0, 0, 1000 / ASSERV_FREQUENCY);
+        /* Wakes up the strategy if it waits for one of those. */
+        robot_events_post(ROBOT_EVENT_POSITION);
+
+        if (trajectory_finished(&robot.traj))
+            robot_events_post(ROBOT_EVENT_TRAJ_END);
+
+        if (bd_get(&robot.angle_bd) || bd_get(&robot.distance_bd))
+            robot_events_post(ROBOT_EVENT_BLOCKING);
+
+        if (++beacon_divider >= ASSERV_FREQUENCY / BEACON_TRACKER_FREQUENCY) {
+            beacon_divider = 0;
+            beacon_tracker_manage();
+        }
+
+        /* Wait until the next period */
+        periodic_wait(&periodic);
+        wake_up = periodic.next_deadline;
     }
 }
 
-void odometry_manage_task(__attribute__((unused)) void *dummy)
+/** Moves the consigns at the speeds computed by the path follower. */
+static void path_follower_manage(void)
 {
-    while(1) {
-        position_manage(&robot.pos);
+    float v, w;
+
+    path_follower_update(&robot.follower, uptime_get(),
+                         position_get_x_float(&robot.pos), position_get_y_float(&robot.pos),
+                         position_get_a_rad_float(&robot.pos), &v, &w);
 
-        /* Wait 20 milliseconds (50 Hz) */
-        OSTimeDlyHMSM(0, 0, 0, 20);
+    /* The speeds are integrated over one control period. */
+    cs_set_consign(&robot.distance_cs, cs_get_consign(&robot.distance_cs)
+                   + pos_mm2imp(&robot.traj, v / ASSERV_FREQUENCY));
+    cs_set_consign(&robot.angle_cs, cs_get_consign(&robot.angle_cs)
+                   + pos_rd2imp(&robot.traj, w / ASSERV_FREQUENCY));
+}
+
+/** Feeds the beacon readings to the tracker, with the current pose. */
+static void beacon_tracker_manage(void)
+{
+    beacon_tracker_reading_t readings[BEACON_TRACKER_MAX_TRACKS];
+    int i, count;
+    OS_CPU_SR cpu_sr;
+
+    /* The beacon is written from its interrupt. */
+    OS_ENTER_CRITICAL();
+    count = robot.beacon.nb_beacon;
+    if (count > BEACON_TRACKER_MAX_TRACKS)
+        count = BEACON_TRACKER_MAX_TRACKS;
+
+    for (i = 0; i < count; i++) {
+        readings[i].direction = robot.beacon.beacon[i].direction;
+        readings[i].distance = robot.beacon.beacon[i].distance * 10; /* cm */
     }
+    OS_EXIT_CRITICAL();
+
+    beacon_tracker_update(&robot.tracker, readings, count,
+                          position_get_x_float(&robot.pos), position_get_y_float(&robot.pos),
+                          position_get_a_rad_float(&robot.pos), uptime_get());
 }
@@ -24,6 +24,8 @@
 #include <obstacle_avoidance.h>
 
 #include "arm.h"
+#include "beacon_tracker.h"
+#include "path_follower.h"
 #include "strat.h"
 
 
@@ -37,8 +39,10 @@
 /** Number of ipulsions on a rotation of the wheel */
 #define IMP_PER_TURN 32000.0
 
-/** Frequency of the regulation loop (in Hz) */
+/** Frequency of the regulation loop (in Hz), odometry included. */
+#ifndef ASSERV_FREQUENCY
 #define ASSERV_FREQUENCY 100
+#endif
 
 /**
  @brief Type of the regulators
@@ -98,6 +102,8 @@ struct _rob {
     struct blocking_detection distance_bd;  ///< Distance blocking detection manager.
 
     volatile cvra_beacon_t beacon;
+    beacon_tracker_t tracker;               ///< Opponents seen by the beacon, in the table frame.
+    path_follower_t follower;               ///< Drives the consigns along a timed path instead of the trajectory manager.
 
     enum board_mode_t mode;                 ///< The current board mode. @deprecated
 
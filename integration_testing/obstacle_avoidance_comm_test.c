@@ -5,6 +5,7 @@
 #include <netif/slipif.h>
 
 #include "obstacle_avoidance_protocol.h"
+#include "obstacle_avoidance_session.h"
 
 struct netif slipf;
 /** Shared semaphore to signal when lwIP init is done. */
@@ -76,10 +77,50 @@ void send_request(void)
     obstacle_avoidance_request_delete(&request);
 }
 
+/** Sends two requests on a session before waiting for any answer. */
+void send_pipelined_requests(void)
+{
+    static obstacle_avoidance_point_t points[2][10];
+    obstacle_avoidance_session_t session;
+    obstacle_avoidance_request_t request;
+    obstacle_avoidance_path_t path[2];
+    struct ip_addr server;
+    int id[2];
+    int i, j, err;
+
+    IP4_ADDR(&server, 10,0,0,1);
+    obstacle_avoidance_session_init(&session, server, 2048);
+
+    obstacle_avoidance_request_create(&request, 0);
+    request.desired_datapoints = 3;
+    request.desired_samplerate = 300;
+
+    for (i = 0; i < 2; i++) {
+        request.end.x = 1000 * (i + 1);
+        id[i] = obstacle_avoidance_session_submit(&session, &request, &path[i], points[i], 10, 1000);
+        printf("Submitted request %d\n", id[i]);
+    }
+
+    obstacle_avoidance_request_delete(&request);
+
+    for (i = 0; i < 2; i++) {
+        if (id[i] < 0)
+            continue;
+
+        err = obstacle_avoidance_session_wait(&session, id[i]);
+        printf("Request %d returned %d\n", id[i], err);
+
+        for (j = 0; err == ERR_OK && j < path[i].len; j++)
+            printf("x = %d, y = %d\n", path[i].points[j].x, path[i].points[j].y);
+    }
+
+    obstacle_avoidance_session_close(&session);
+}
 
 void main(void)
 {
     printf("Testing communication\n");
     ip_stack_init();
     send_request();
+    send_pipelined_requests();
 }
@@ -0,0 +1,244 @@
+/** @file obstacle_avoidance_server.c
+ * @brief Stand-in path planner server, for integration testing on Linux.
+ *
+ * Answers each request with a straight line from start to end, sampled as
+ * asked. The answer uses the encoding of the request, binary or JSON, so it
+ * can test both sides of the negotiation. Obstacles are ignored.
+ *
+ * A connection carrying session requests is kept open, and each request is
+ * answered with its id, until the client closes it.
+ *
+ * Usage : obstacle_avoidance_server [port] [--json-only]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <json.h>
+#include "obstacle_avoidance_binary.h"
+
+#define MAX_OBSTACLES 32
+#define MAX_POINTS 4096
+#define MAX_REQUEST_LEN 4096
+
+static obstacle_avoidance_point_t points[MAX_POINTS];
+static uint8_t answer[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + 4 + MAX_POINTS * OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE];
+
+static int read_all(int fd, uint8_t *buf, int len)
+{
+    int n, done = 0;
+
+    while (done < len) {
+        n = read(fd, buf + done, len - done);
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+
+    return 0;
+}
+
+static int write_all(int fd, const void *buf, int len)
+{
+    const char *p = buf;
+    int n;
+
+    while (len > 0) {
+        n = write(fd, p, len);
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/** Computes a straight line path at constant speed. */
+static void plan(obstacle_avoidance_request_t *r, obstacle_avoidance_path_t *path)
+{
+    int i, n = r->desired_datapoints;
+    int duration;
+
+    if (n > MAX_POINTS)
+        n = MAX_POINTS;
+    if (n < 2)
+        n = 2;
+
+    duration = (n - 1) * r->desired_samplerate;
+
+    for (i = 0; i < n; i++) {
+        points[i].x = r->start.x + (r->end.x - r->start.x) * i / (n - 1);
+        points[i].y = r->start.y + (r->end.y - r->start.y) * i / (n - 1);
+        points[i].vx = duration ? (r->end.x - r->start.x) * 1000 / duration : 0;
+        points[i].vy = duration ? (r->end.y - r->start.y) * 1000 / duration : 0;
+        points[i].timestamp = i * r->desired_samplerate;
+    }
+
+    path->points = points;
+    path->len = n;
+}
+
+/** Answers a binary request.
+ * @returns The request frame type, or -1 on error.
+ */
+static int serve_binary(int fd, uint8_t magic)
+{
+    static uint8_t request[MAX_REQUEST_LEN];
+    obstacle_avoidance_obstacle_t obstacles[MAX_OBSTACLES];
+    obstacle_avoidance_request_t r;
+    obstacle_avoidance_path_t path;
+    uint32_t payload_len;
+    uint16_t id;
+    int len;
+
+    request[0] = magic;
+    if (read_all(fd, request + 1, OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE - 1) < 0)
+        return -1;
+
+    payload_len = request[2] | (request[3] << 8) | (request[4] << 16) | ((uint32_t)request[5] << 24);
+    if (payload_len > MAX_REQUEST_LEN - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE)
+        return -1;
+
+    if (read_all(fd, request + OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE, payload_len) < 0)
+        return -1;
+
+    if (obstacle_avoidance_binary_decode_request(&r, &id, obstacles, MAX_OBSTACLES, request,
+                                                 OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + payload_len) != 0)
+        return -1;
+
+    plan(&r, &path);
+
+    if (request[1] == OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST) {
+        len = obstacle_avoidance_binary_encode_session_path(&path, id, answer, sizeof(answer));
+        printf("session request %d, %d obstacles, %d points, %d bytes\n", id, r.obstacle_count, path.len, len);
+    } else {
+        len = obstacle_avoidance_binary_encode_path(&path, answer, sizeof(answer));
+        printf("binary request, %d obstacles, %d points, %d bytes\n", r.obstacle_count, path.len, len);
+    }
+
+    if (write_all(fd, answer, len) < 0)
+        return -1;
+
+    return request[1];
+}
+
+static int serve_json(int fd, char first)
+{
+    static char request[MAX_REQUEST_LEN];
+    obstacle_avoidance_request_t r;
+    obstacle_avoidance_path_t path;
+    JsonNode *node, *point, *array;
+    int len = 1, depth = 1, i;
+    char *json;
+
+    /* Reads until the top level array is closed. */
+    request[0] = first;
+    while (depth > 0 && len < MAX_REQUEST_LEN - 1) {
+        if (read(fd, &request[len], 1) <= 0)
+            return -1;
+
+        if (request[len] == '[')
+            depth++;
+        else if (request[len] == ']')
+            depth--;
+        len++;
+    }
+    request[len] = '\0';
+
+    node = json_decode(request);
+    if (node == NULL)
+        return -1;
+
+    memset(&r, 0, sizeof(r));
+    r.start.x = json_find_element(json_find_element(node, 0), 0)->number_;
+    r.start.y = json_find_element(json_find_element(node, 0), 1)->number_;
+    r.end.x = json_find_element(json_find_element(node, 1), 0)->number_;
+    r.end.y = json_find_element(json_find_element(node, 1), 1)->number_;
+    r.desired_samplerate = json_find_element(node, 2)->number_;
+    r.desired_datapoints = json_find_element(node, 3)->number_;
+    json_delete(node);
+
+    plan(&r, &path);
+
+    array = json_mkarray();
+    for (i = 0; i < path.len; i++) {
+        point = json_mkarray();
+        json_append_element(point, json_mknumber(path.points[i].x));
+        json_append_element(point, json_mknumber(path.points[i].y));
+        json_append_element(point, json_mknumber(path.points[i].vx));
+        json_append_element(point, json_mknumber(path.points[i].vy));
+        json_append_element(point, json_mknumber(path.points[i].timestamp));
+        json_append_element(array, point);
+    }
+
+    json = json_encode(array);
+    json_delete(array);
+
+    printf("JSON request, %d points, %d bytes\n", path.len, (int)strlen(json));
+
+    i = write_all(fd, json, strlen(json));
+    free(json);
+
+    return i;
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_in addr;
+    int server, client, port = 2048, json_only = 0;
+    uint8_t first;
+
+    if (argc > 1)
+        port = atoi(argv[1]);
+
+    if (argc > 2 && !strcmp(argv[2], "--json-only"))
+        json_only = 1;
+
+    server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    client = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &client, sizeof(client));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(server, 4) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    printf("Listening on port %d\n", port);
+
+    while (1) {
+        client = accept(server, NULL, NULL);
+        if (client < 0)
+            continue;
+
+        if (read(client, &first, 1) == 1) {
+            if (first == OBSTACLE_AVOIDANCE_BINARY_MAGIC && !json_only) {
+                /* Session requests follow each other on the same connection. */
+                while (serve_binary(client, first) == OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST
+                       && read(client, &first, 1) == 1);
+            } else if (first == '[') {
+                serve_json(client, first);
+            } else {
+                printf("Unknown request encoding.\n");
+            }
+        }
+
+        /* The client reads until the connection is closed. */
+        close(client);
+    }
+
+    return 0;
+}
@@ -19,10 +19,20 @@ typedef struct {
     float hand_angle; /**< The angle of the hand in degree. */
 } arm_keyframe_t;
 
+/** Time derivatives of a trajectory at a given date. */
+typedef struct {
+    float velocity[3];      /**< Velocity of the hand position, in mm/s. */
+    float acceleration[3];  /**< Acceleration of the hand position, in mm/s^2. */
+    float hand_velocity;    /**< Angular velocity of the hand in degree/s. */
+    float hand_acceleration; /**< Angular acceleration of the hand in degree/s^2. */
+} arm_keyframe_derivatives_t;
+
 
 /** This structure holds the data of a single arm trajectory. */
 typedef struct {
     arm_keyframe_t *frames; /**< Trajectory keyframes. */
     int frame_count;        /**< Number of frames. */
+    int capacity;           /**< Number of frames the frames buffer can hold. */
+    int is_static;          /**< Non zero if the buffer belongs to the caller and must never be freed. */
 } arm_trajectory_t;
 #endif
@@ -1,6 +1,8 @@
 #include <lwip/sockets.h>
 #include <lwip/api.h>
 #include <lwip/inet.h>
+#include <lwip/sys.h>
+#include <platform.h>
 
 #ifdef __unix__
 #include <stdlib.h>
@@ -11,9 +13,31 @@
 #include "lua/lauxlib.h"
 #include "lua/lualib.h"
 
+#include "console_output.h"
+
 #define MAX_COMMAND_LEN 200
 #define PROMPT ">> "
 
+/** Below the console, so that it only flushes while a command blocks. */
+#define LUA_CONSOLE_FLUSH_PRIO 35
+
+/** Number of shells kept ready for the next connections. */
+#define LUA_STATE_POOL_SIZE 1
+
+/** Below the console, so the pool is refilled while nobody waits. */
+#define LUA_CONSOLE_POOL_PRIO 36
+
+/* Embedded scripts, compiled to bytecode at build time, see the Makefile. */
+extern unsigned char commands_luac[];
+extern long int commands_luac_size;
+extern unsigned char settings_luac[];
+extern long int settings_luac_size;
+
+static lua_State *state_pool[LUA_STATE_POOL_SIZE];
+
+/** Signaled when a shell was taken from the pool. */
+static sys_sem_t pool_refill;
+
 // simple example of function binding from C to lua
 int mysum(lua_State *l)
 {
@@ -31,73 +55,129 @@ int mysum(lua_State *l)
     return 1; // return value count
 }
 
+/** Output of the connection being served. There is only one at a time. */
+static console_output_t output;
+
+static void console_send(void *conn, const char *data, int len)
+{
+    netconn_write(conn, data, len, NETCONN_COPY);
+}
+
 int print_func(lua_State *l)
 {
-    struct netconn *conn;
-    const char *to_print;
+    console_output_t *out;
 
     if (lua_gettop(l) == 0)
         return 0;
 
-    lua_getglobal(l, "__conn");
-    conn = lua_touserdata(l, -1);
+    lua_getglobal(l, "__output");
+    out = lua_touserdata(l, -1);
     lua_pop(l, 1);
 
     if (lua_isstring(l, -1)) {
-        to_print = lua_tostring(l, -1);
-        netconn_write(conn, to_print, strlen(to_print), NETCONN_COPY);
-        netconn_write(conn, "\r\n", 2, NETCONN_COPY);
+        console_output_puts(out, lua_tostring(l, -1));
+        console_output_write(out, "\r\n", 2);
     } else {
-        const char *error = "ERROR : cannot print that\r\n";
-        netconn_write(conn, error, strlen(error), NETCONN_COPY);
+        console_output_puts(out, "ERROR : cannot print that\r\n");
     }
     return 0;
 }
 
-void lua_do_rom_script(lua_State *l, char *buffer, int size)
+/** Runs an embedded script. It can be either bytecode or source code.
+ *
+ * A script which cannot be loaded means that its bytecode does not match the
+ * firmware, for example because luac was built with another configuration.
+ * The shells would then miss their commands, so the robot does not boot.
+ */
+void lua_do_rom_script(lua_State *l, const unsigned char *buffer, long int size, const char *name)
 {
-    int i;
     int ret;
 
-    unsigned char *command = malloc(size + 1);
+    ret = luaL_loadbuffer(l, (const char *)buffer, size, name);
+    if (ret) {
+        printf("ERROR cannot load %s : %s\n", name, lua_tostring(l, -1));
+        panic();
+    }
 
+    ret = lua_pcall(l, 0, 0, 0);
 
-    for (i=0;i<size;i++) {
-        command[i] = buffer[i];
+    if (ret) {
+        printf("ERROR %d in %s : %s\n", ret, name, lua_tostring(l, -1));
+        lua_pop(l, 1);
     }
-    command[i] = 0;
+}
 
-    luaL_loadstring(l, command);
-    ret = lua_pcall(l, 0, LUA_MULTRET, 0);
+/** Creates a state with the robot commands and commands.lua loaded. */
+lua_State *lua_new_shell(void)
+{
+    lua_State *l = luaL_newstate();
+    luaL_openlibs(l);
 
-    if (ret)
-        snprintf(command, MAX_COMMAND_LEN, "ERROR %d : %s\n", ret, lua_tostring(l, -1));
+    commands_register(l);
+
+    lua_do_rom_script(l, commands_luac, commands_luac_size, "commands.lua");
 
-    free(command);
+    return l;
 }
 
-void lua_prepare_shell(lua_State *l)
+void lua_do_settings(void)
 {
-    extern unsigned char commands_lua[];
-    extern long int commands_lua_size;
+    lua_State *l = lua_new_shell();
 
+    lua_do_rom_script(l, settings_luac, settings_luac_size, "settings.lua");
+}
+
+/** Takes a ready shell from the pool, or creates one if it is empty. */
+static lua_State *lua_pool_take(void)
+{
+    lua_State *l = NULL;
+    int i;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for (i = 0; i < LUA_STATE_POOL_SIZE && l == NULL; i++) {
+        l = state_pool[i];
+        state_pool[i] = NULL;
+    }
+    SYS_ARCH_UNPROTECT(lev);
 
-    lua_do_rom_script(l, commands_lua, commands_lua_size);
+    sys_sem_signal(&pool_refill);
+
+    if (l == NULL)
+        l = lua_new_shell();
+
+    return l;
 }
 
-void lua_do_settings(void)
+/** Prepares shells for the next connections. Only the pool task fills it. */
+static void lua_pool_fill(void)
 {
-    extern unsigned char settings_lua[];
-    extern long int settings_lua_size;
+    lua_State *l;
+    int i;
+    SYS_ARCH_DECL_PROTECT(lev);
 
-    lua_State *l = luaL_newstate();
-    luaL_openlibs(l);
+    for (i = 0; i < LUA_STATE_POOL_SIZE; i++) {
+        if (state_pool[i] != NULL)
+            continue;
 
-    commands_register(l);
+        l = lua_new_shell();
 
-    lua_prepare_shell(l);
+        SYS_ARCH_PROTECT(lev);
+        state_pool[i] = l;
+        SYS_ARCH_UNPROTECT(lev);
+    }
+}
+
+/** Refills the pool after each connection, so the console goes back to
+ * accepting clients at once. */
+static void luaconsole_pool_thread(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
 
-    lua_do_rom_script(l, settings_lua, settings_lua_size);
+    while (1) {
+        lua_pool_fill();
+        sys_arch_sem_wait(&pool_refill, 0);
+    }
 }
 
 
@@ -113,20 +193,28 @@ void serve_conn(struct netconn *conn)
     char command[MAX_COMMAND_LEN], real_command[MAX_COMMAND_LEN];
     int ret;
 
-    l = luaL_newstate();
-    luaL_openlibs(l);
-    
+    console_output_open(&output, console_send, conn);
+
+    /* The shell is ready, only the connection globals are missing. */
+    l = lua_pool_take();
+
     lua_pushlightuserdata(l, conn);
     lua_setglobal(l, "__conn");
 
+    lua_pushlightuserdata(l, &output);
+    lua_setglobal(l, "__output");
+
     lua_pushcfunction(l, print_func);
     lua_setglobal(l, "print");
-    
-    commands_register(l);
-    lua_prepare_shell(l);
 
+    /* The shell was loaded before the connection, so commands.lua did not
+     * greet the user itself. */
+    lua_getglobal(l, "greet");
+    if (lua_pcall(l, 0, 0, 0))
+        lua_pop(l, 1);
 
-    netconn_write(conn, PROMPT, strlen(PROMPT), NETCONN_COPY);
+    console_output_puts(&output, PROMPT);
+    console_output_flush(&output);
     while((err = netconn_recv(conn, &buf)) == ERR_OK) {
         do {
             /* Copies the buffer data into a string. */
@@ -144,19 +232,35 @@ void serve_conn(struct netconn *conn)
                 ret = lua_pcall(l, 0, LUA_MULTRET, 0);
                 if (ret) {
                     snprintf(command, MAX_COMMAND_LEN, "ERROR %d : %s\n", ret, lua_tostring(l, -1));
-                    netconn_write(conn, command, strlen(command), NETCONN_COPY);
+                    console_output_puts(&output, command);
 
                     lua_pop(l, 1);
                 }
             }
-            netconn_write(conn, PROMPT, strlen(PROMPT), NETCONN_COPY);
+            console_output_puts(&output, PROMPT);
+            console_output_flush(&output);
         } while (netbuf_next(buf) >= 0);
         netbuf_delete(buf);
     }
 
+    /* The connection is deleted after this, the flush task must not use it. */
+    console_output_close(&output);
+
     lua_close(l);
 }
 
+/** Sends the output which waited too long, for example while a command
+ * sleeps before printing its next line. */
+static void luaconsole_flush_thread(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    while (1) {
+        sys_msleep(CONSOLE_OUTPUT_FLUSH_DELAY / 1000);
+        console_output_poll(&output);
+    }
+}
+
 static void luaconsole_thread(void *arg)
 {
     struct netconn *conn, *newconn;
@@ -189,5 +293,9 @@ static void luaconsole_thread(void *arg)
 
 void luaconsole_init(void)
 {
+    console_output_init(&output, NULL, NULL);
+    sys_sem_new(&pool_refill, 0);
+    sys_thread_new("luapool", luaconsole_pool_thread, NULL, DEFAULT_THREAD_STACKSIZE, LUA_CONSOLE_POOL_PRIO);
+    sys_thread_new("luaflush", luaconsole_flush_thread, NULL, DEFAULT_THREAD_STACKSIZE, LUA_CONSOLE_FLUSH_PRIO);
     sys_thread_new("luaconsole",luaconsole_thread , NULL, DEFAULT_THREAD_STACKSIZE, 32);
 }
@@ -30,6 +30,9 @@
 #define LWIP_HAVE_LOOPIF 1
 #define LWIP_NETIF_LOOPBACK 1
 
+/* Needed by the path planner session, which waits with a timeout. */
+#define LWIP_SO_RCVTIMEO 1
+
 
 #ifdef __unix__
 /* <sys/time.h> is included in cc.h! */
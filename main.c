@@ -29,6 +29,9 @@
 #include "cvra_cs.h"
 #include "arm_init.h"
 #include "strat_utils.h"
+#include "robot_events.h"
+#include "strat_planner.h"
+#include "pathplanner.h"
 
 
 #define   TASK_STACKSIZE          2048
@@ -147,6 +150,9 @@ void init_task(void *pdata)
     ip_stack_init();
     list_netifs();
 
+    /* Owns the connection to the path planner. */
+    pathplanner_init();
+
     /* If the logic power supply is off, kindly ask the user to turn it on. */
     if ((IORD(PIO_BASE, 0) & 0xff) == 0) {
         printf("Hey sac a pain, la commande c'est en option ?\n");
@@ -156,6 +162,9 @@ void init_task(void *pdata)
         printf("Merci bien !\n");
     }
 
+    /* Must exist before the control tasks start posting events. */
+    robot_events_init();
+
     /* Inits all the trajectory stuff, PID, odometry, etc... */
 #if 1
     NOTICE(0, "Main control system init.");
@@ -164,9 +173,11 @@ void init_task(void *pdata)
 
 
 
-    /* Sets the bounding box for the avoidance module. */
+    /* Sets the bounding box for the path planner. */
     const int robot_size = 150;
-    polygon_set_boundingbox(robot_size, robot_size, 3000-robot_size, 2000-robot_size);
+    strat_planner_init();
+    strat_planner_set_bounding_box(robot_size, robot_size, 3000-robot_size, 2000-robot_size);
+    strat_add_table_obstacles();
 
     arm_highlevel_init();
 
@@ -0,0 +1,81 @@
+#include <stddef.h>
+#include <string.h>
+#include <platform.h>
+#include <cvra_dc.h>
+#include "motor_io.h"
+
+void motor_io_init(motor_io_t *io, void *base)
+{
+    int i;
+
+    memset(io, 0, sizeof(motor_io_t));
+    io->base = base;
+
+    for (i = 0; i < MOTOR_IO_MAX_CHANNELS; i++) {
+        io->channels[i].io = io;
+        io->channels[i].index = i;
+    }
+}
+
+motor_io_channel_t *motor_io_channel(motor_io_t *io, int index)
+{
+    if (index < 0 || index >= MOTOR_IO_MAX_CHANNELS)
+        return NULL;
+
+    io->used |= 1 << index;
+    io->encoders[index] = cvra_dc_get_encoder(io->base, index);
+
+    return &io->channels[index];
+}
+
+void motor_io_read(motor_io_t *io)
+{
+    int i;
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+
+    /* Keeps a higher priority task from delaying part of the samples. */
+    OS_ENTER_CRITICAL();
+#endif
+
+    for (i = 0; i < MOTOR_IO_MAX_CHANNELS; i++) {
+        if (io->used & (1 << i))
+            io->encoders[i] = cvra_dc_get_encoder(io->base, i);
+    }
+
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+void motor_io_write(motor_io_t *io)
+{
+    int i;
+
+    for (i = 0; i < MOTOR_IO_MAX_CHANNELS; i++) {
+        if (io->written & (1 << i))
+            cvra_dc_set_pwm(io->base, i, io->pwms[i]);
+    }
+
+    io->written = 0;
+}
+
+int32_t motor_io_get_encoder(void *channel)
+{
+    motor_io_channel_t *c = (motor_io_channel_t *)channel;
+
+    return c->io->encoders[c->index];
+}
+
+void motor_io_set_pwm(void *channel, int32_t value)
+{
+    motor_io_channel_t *c = (motor_io_channel_t *)channel;
+
+    c->io->pwms[c->index] = value;
+    c->io->written |= 1 << c->index;
+}
+
+void motor_io_set_pwm_negative(void *channel, int32_t value)
+{
+    motor_io_set_pwm(channel, -value);
+}
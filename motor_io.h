@@ -0,0 +1,80 @@
+/** @file motor_io.h
+ * @brief Batched access to the encoders and PWMs of a motor controller.
+ *
+ * The control loops read their encoder and write their PWM through
+ * callbacks, each one doing its own bus access in the middle of the
+ * regulation. This module gives them callbacks working on a copy instead :
+ * the encoders of all the used channels are sampled together by
+ * motor_io_read, before the loops run, and the PWMs they set are sent
+ * together by motor_io_write, once they are all done.
+ *
+ * This way every loop of a task works on samples taken at the same time.
+ *
+ * @code
+ * motor_io_t io;
+ * motor_io_init(&io, ARMSMOTORCONTROLLER_BASE);
+ * arm_cs_connect_motor(&loop, motor_io_set_pwm, motor_io_channel(&io, 3));
+ * arm_cs_connect_encoder(&loop, motor_io_get_encoder, motor_io_channel(&io, 3));
+ *
+ * while (1) {
+ *     motor_io_read(&io);
+ *     arm_cs_manage(&loop);
+ *     motor_io_write(&io);
+ * }
+ * @endcode
+ *
+ * @note A controller can be shared by several tasks, as long as each one
+ * uses its own motor_io_t and its own channels.
+ */
+#ifndef _MOTOR_IO_H_
+#define _MOTOR_IO_H_
+
+#include <stdint.h>
+
+/** Number of channels of a motor controller. */
+#define MOTOR_IO_MAX_CHANNELS 8
+
+typedef struct motor_io_s motor_io_t;
+
+/** Parameter given to the callbacks, to know which channel they work on. */
+typedef struct {
+    motor_io_t *io;
+    int index;
+} motor_io_channel_t;
+
+struct motor_io_s {
+    void *base;                 /**< Base address of the controller. */
+    unsigned used;              /**< Mask of the channels sampled by motor_io_read. */
+    unsigned written;           /**< Mask of the PWMs set since the last motor_io_write. */
+    int32_t encoders[MOTOR_IO_MAX_CHANNELS];
+    int32_t pwms[MOTOR_IO_MAX_CHANNELS];
+    motor_io_channel_t channels[MOTOR_IO_MAX_CHANNELS];
+};
+
+/** Inits a batch without any channel. */
+void motor_io_init(motor_io_t *io, void *base);
+
+/** Adds a channel to the batch.
+ *
+ * Its encoder is sampled at once, so the loops never see a zero reading.
+ * @returns The parameter to give to the callbacks, or NULL if the channel
+ * does not exist.
+ */
+motor_io_channel_t *motor_io_channel(motor_io_t *io, int index);
+
+/** Samples the encoders of all the channels of the batch. */
+void motor_io_read(motor_io_t *io);
+
+/** Sends the PWMs set since the last call. */
+void motor_io_write(motor_io_t *io);
+
+/** Encoder callback, returns the value sampled by the last motor_io_read. */
+int32_t motor_io_get_encoder(void *channel);
+
+/** PWM callback, the value is sent by the next motor_io_write. */
+void motor_io_set_pwm(void *channel, int32_t value);
+
+/** Same as motor_io_set_pwm, for motors mounted the other way round. */
+void motor_io_set_pwm_negative(void *channel, int32_t value);
+
+#endif
@@ -0,0 +1,336 @@
+#include <string.h>
+#include <lwip/err.h>
+#include "obstacle_avoidance_binary.h"
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t *put_header(uint8_t *p, int type, uint32_t payload_len)
+{
+    *p++ = OBSTACLE_AVOIDANCE_BINARY_MAGIC;
+    *p++ = type;
+    return put_u32(p, payload_len);
+}
+
+/** Checks a frame header. @returns The payload length, or -1. */
+static int get_header(const uint8_t *p, int type)
+{
+    if (p[0] != OBSTACLE_AVOIDANCE_BINARY_MAGIC || p[1] != type)
+        return -1;
+
+    return get_u32(p + 2);
+}
+
+int obstacle_avoidance_binary_request_size(const obstacle_avoidance_request_t *r)
+{
+    return OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE
+           + r->obstacle_count * OBSTACLE_AVOIDANCE_BINARY_OBSTACLE_SIZE;
+}
+
+/** Encodes a request frame, with a request id for the session frames. */
+static int encode_request(const obstacle_avoidance_request_t *r, int type, uint16_t id, uint8_t *buf, int size)
+{
+    int len = obstacle_avoidance_binary_request_size(r);
+    uint8_t *p = buf;
+    int i;
+
+    if (type == OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST)
+        len += OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+
+    if (len > size)
+        return -1;
+
+    p = put_header(p, type, len - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE);
+
+    if (type == OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST)
+        p = put_u16(p, id);
+
+    p = put_u16(p, r->start.x);
+    p = put_u16(p, r->start.y);
+    p = put_u16(p, r->start.vx);
+    p = put_u16(p, r->start.vy);
+    p = put_u16(p, r->end.x);
+    p = put_u16(p, r->end.y);
+    p = put_u32(p, r->desired_samplerate);
+    p = put_u32(p, r->desired_datapoints);
+    p = put_u16(p, r->obstacle_count);
+
+    for (i = 0; i < r->obstacle_count; i++) {
+        p = put_u16(p, r->obstacles[i].x);
+        p = put_u16(p, r->obstacles[i].y);
+        p = put_u16(p, r->obstacles[i].vx);
+        p = put_u16(p, r->obstacles[i].vy);
+        p = put_u16(p, r->obstacles[i].r);
+    }
+
+    return len;
+}
+
+int obstacle_avoidance_binary_encode_request(const obstacle_avoidance_request_t *r, uint8_t *buf, int size)
+{
+    return encode_request(r, OBSTACLE_AVOIDANCE_BINARY_REQUEST, 0, buf, size);
+}
+
+int obstacle_avoidance_binary_encode_session_request(const obstacle_avoidance_request_t *r, uint16_t id,
+                                                     uint8_t *buf, int size)
+{
+    return encode_request(r, OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST, id, buf, size);
+}
+
+int obstacle_avoidance_binary_decode_request(obstacle_avoidance_request_t *r, uint16_t *id,
+                                             obstacle_avoidance_obstacle_t *obstacles, int max_obstacles,
+                                             const uint8_t *buf, int len)
+{
+    const uint8_t *p = buf + OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE;
+    uint16_t request_id = 0;
+    int payload_len, i;
+
+    if (len < OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE)
+        return ERR_VAL;
+
+    payload_len = get_header(buf, OBSTACLE_AVOIDANCE_BINARY_REQUEST);
+    if (payload_len < 0) {
+        payload_len = get_header(buf, OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST);
+        if (payload_len < OBSTACLE_AVOIDANCE_BINARY_ID_SIZE
+            || len < OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE
+                     + OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE)
+            return ERR_VAL;
+
+        request_id = get_u16(p);
+        p += OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+        payload_len -= OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+        len -= OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+    }
+
+    if (payload_len > len - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE)
+        return ERR_VAL;
+
+    if (id != NULL)
+        *id = request_id;
+
+    memset(r, 0, sizeof(obstacle_avoidance_request_t));
+    r->start.x = (int16_t)get_u16(p);
+    r->start.y = (int16_t)get_u16(p + 2);
+    r->start.vx = (int16_t)get_u16(p + 4);
+    r->start.vy = (int16_t)get_u16(p + 6);
+    r->end.x = (int16_t)get_u16(p + 8);
+    r->end.y = (int16_t)get_u16(p + 10);
+    r->desired_samplerate = (int32_t)get_u32(p + 12);
+    r->desired_datapoints = (int32_t)get_u32(p + 16);
+    r->obstacle_count = get_u16(p + 20);
+    p += OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE;
+
+    if (payload_len != OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE
+                       + r->obstacle_count * OBSTACLE_AVOIDANCE_BINARY_OBSTACLE_SIZE)
+        return ERR_VAL;
+
+    if (r->obstacle_count > max_obstacles)
+        return ERR_BUF;
+
+    r->obstacles = obstacles;
+
+    for (i = 0; i < r->obstacle_count; i++) {
+        obstacles[i].x = (int16_t)get_u16(p);
+        obstacles[i].y = (int16_t)get_u16(p + 2);
+        obstacles[i].vx = (int16_t)get_u16(p + 4);
+        obstacles[i].vy = (int16_t)get_u16(p + 6);
+        obstacles[i].r = (int16_t)get_u16(p + 8);
+        p += OBSTACLE_AVOIDANCE_BINARY_OBSTACLE_SIZE;
+    }
+
+    return ERR_OK;
+}
+
+/** Encodes a path frame, with a request id for the session frames. */
+static int encode_path(const obstacle_avoidance_path_t *path, int type, uint16_t id, uint8_t *buf, int size)
+{
+    int len = OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + 4 + path->len * OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE;
+    uint8_t *p = buf;
+    int i;
+
+    if (type == OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH)
+        len += OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+
+    if (len > size)
+        return -1;
+
+    p = put_header(p, type, len - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE);
+
+    if (type == OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH)
+        p = put_u16(p, id);
+
+    p = put_u32(p, path->len);
+
+    for (i = 0; i < path->len; i++) {
+        p = put_u16(p, path->points[i].x);
+        p = put_u16(p, path->points[i].y);
+        p = put_u16(p, path->points[i].vx);
+        p = put_u16(p, path->points[i].vy);
+        p = put_u32(p, path->points[i].timestamp);
+    }
+
+    return len;
+}
+
+int obstacle_avoidance_binary_encode_path(const obstacle_avoidance_path_t *path, uint8_t *buf, int size)
+{
+    return encode_path(path, OBSTACLE_AVOIDANCE_BINARY_PATH, 0, buf, size);
+}
+
+int obstacle_avoidance_binary_encode_session_path(const obstacle_avoidance_path_t *path, uint16_t id,
+                                                  uint8_t *buf, int size)
+{
+    return encode_path(path, OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH, id, buf, size);
+}
+
+int obstacle_avoidance_binary_decode_header(const uint8_t *buf, int *type, uint32_t *payload_len)
+{
+    if (buf[0] != OBSTACLE_AVOIDANCE_BINARY_MAGIC)
+        return ERR_VAL;
+
+    *type = buf[1];
+    *payload_len = get_u32(buf + 2);
+
+    return ERR_OK;
+}
+
+void obstacle_avoidance_binary_decoder_init(obstacle_avoidance_binary_decoder_t *d,
+                                            obstacle_avoidance_point_t *points, int max_points)
+{
+    memset(d, 0, sizeof(obstacle_avoidance_binary_decoder_t));
+    d->points = points;
+    d->max_points = max_points;
+    d->count = -1;
+}
+
+/** Checks the payload length of a path, and deduces its number of points. */
+static int payload_points(obstacle_avoidance_binary_decoder_t *d, uint32_t payload_len)
+{
+    if (payload_len < 4 || (payload_len - 4) % OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE)
+        return ERR_VAL;
+
+    d->header_done = 1;
+    d->expected = (payload_len - 4) / OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE;
+
+    return ERR_OK;
+}
+
+void obstacle_avoidance_binary_decoder_init_payload(obstacle_avoidance_binary_decoder_t *d,
+                                                    obstacle_avoidance_point_t *points, int max_points,
+                                                    uint32_t payload_len)
+{
+    obstacle_avoidance_binary_decoder_init(d, points, max_points);
+    d->error = payload_points(d, payload_len);
+}
+
+int obstacle_avoidance_binary_decoder_done(obstacle_avoidance_binary_decoder_t *d)
+{
+    return d->error == ERR_OK && d->len == d->count;
+}
+
+/** Handles a complete field, header, point count or point. */
+static int decoder_field(obstacle_avoidance_binary_decoder_t *d)
+{
+    const uint8_t *p = d->partial;
+    obstacle_avoidance_point_t *point;
+
+    if (!d->header_done) {
+        if (p[0] != OBSTACLE_AVOIDANCE_BINARY_MAGIC || p[1] != OBSTACLE_AVOIDANCE_BINARY_PATH)
+            return ERR_VAL;
+
+        return payload_points(d, get_u32(p + 2));
+    } else if (d->count < 0) {
+        /* The count must match the payload length given in the header. */
+        if (get_u32(p) != (uint32_t)d->expected)
+            return ERR_VAL;
+
+        if (d->expected > d->max_points)
+            return ERR_BUF;
+
+        d->count = d->expected;
+    } else {
+        point = &d->points[d->len++];
+        point->x = (int16_t)get_u16(p);
+        point->y = (int16_t)get_u16(p + 2);
+        point->vx = (int16_t)get_u16(p + 4);
+        point->vy = (int16_t)get_u16(p + 6);
+        point->timestamp = (int32_t)get_u32(p + 8);
+    }
+
+    return ERR_OK;
+}
+
+int obstacle_avoidance_binary_decoder_feed(obstacle_avoidance_binary_decoder_t *d, const uint8_t *data, int len)
+{
+    int needed, n;
+
+    while (len > 0 && d->error == ERR_OK && !obstacle_avoidance_binary_decoder_done(d)) {
+        if (!d->header_done)
+            needed = OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE;
+        else if (d->count < 0)
+            needed = 4;
+        else
+            needed = OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE;
+
+        n = needed - d->partial_len;
+        if (n > len)
+            n = len;
+
+        memcpy(d->partial + d->partial_len, data, n);
+        d->partial_len += n;
+        data += n;
+        len -= n;
+
+        if (d->partial_len == needed) {
+            d->partial_len = 0;
+            d->error = decoder_field(d);
+        }
+    }
+
+    return d->error;
+}
+
+int obstacle_avoidance_binary_decode_path(obstacle_avoidance_path_t *path,
+                                          obstacle_avoidance_point_t *points, int max_points,
+                                          const uint8_t *buf, int len)
+{
+    obstacle_avoidance_binary_decoder_t d;
+    int err;
+
+    obstacle_avoidance_binary_decoder_init(&d, points, max_points);
+    err = obstacle_avoidance_binary_decoder_feed(&d, buf, len);
+
+    if (err != ERR_OK)
+        return err;
+
+    if (!obstacle_avoidance_binary_decoder_done(&d))
+        return ERR_VAL;
+
+    path->points = points;
+    path->len = d.len;
+
+    return ERR_OK;
+}
@@ -0,0 +1,142 @@
+/** @file obstacle_avoidance_binary.h
+ * @brief Compact binary encoding of the path planner link.
+ *
+ * The JSON encoding needs a tree of nodes for every message, and the whole
+ * answer to be buffered before decoding, which is slow on the robot for long
+ * paths. This encoding needs no allocation, and paths are decoded as bytes
+ * arrive, straight into an array given by the caller.
+ *
+ * Every message is a frame made of :
+ *  - the magic byte OBSTACLE_AVOIDANCE_BINARY_MAGIC, which cannot start a
+ *    JSON message, so a server can accept both encodings,
+ *  - the frame type,
+ *  - the payload length as an uint32,
+ *  - the payload.
+ *
+ * A request payload is start x, y, vx, vy and end x, y as int16, sample rate
+ * and number of datapoints as int32, the number of obstacles as uint16,
+ * then x, y, vx, vy, r of each obstacle as int16.
+ *
+ * A path payload is the number of points as uint32, then x, y, vx, vy as
+ * int16 and timestamp as int32 for each point.
+ *
+ * On a persistent session (see obstacle_avoidance_session.h), the session
+ * frame types are used instead, whose payload starts with the request id as
+ * an uint16, so answers can be matched to pipelined requests.
+ *
+ * Integers are little endian. Positions are in mm, speeds in mm/s and times
+ * in ms, like in obstacle_avoidance_protocol.h.
+ */
+#ifndef OBSTACLE_AVOIDANCE_BINARY_H_
+#define OBSTACLE_AVOIDANCE_BINARY_H_
+
+#include <stdint.h>
+#include "obstacle_avoidance_protocol.h"
+
+#define OBSTACLE_AVOIDANCE_BINARY_MAGIC 0xCA
+
+/* Frame types. The session ones start their payload with a request id. */
+#define OBSTACLE_AVOIDANCE_BINARY_REQUEST         1
+#define OBSTACLE_AVOIDANCE_BINARY_PATH            2
+#define OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST 3
+#define OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH    4
+
+#define OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE 6
+#define OBSTACLE_AVOIDANCE_BINARY_ID_SIZE 2
+#define OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE 22
+#define OBSTACLE_AVOIDANCE_BINARY_OBSTACLE_SIZE 10
+#define OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE 12
+
+/** Maximum number of obstacles sent by the robot, whose requests are built
+ * on the stack. */
+#define OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES 16
+
+#define OBSTACLE_AVOIDANCE_BINARY_MAX_REQUEST_SIZE \
+    (OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE \
+     + OBSTACLE_AVOIDANCE_BINARY_REQUEST_SIZE \
+     + OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES * OBSTACLE_AVOIDANCE_BINARY_OBSTACLE_SIZE)
+
+/** Streaming decoder of path frames. */
+typedef struct {
+    obstacle_avoidance_point_t *points;
+    int max_points;
+    int len;                /**< Number of points decoded so far. */
+    int count;              /**< Number of points in the frame, -1 until known. */
+    int expected;           /**< Number of points given by the frame length. */
+    uint8_t partial[OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE];
+    int partial_len;        /**< Bytes of the current field received so far. */
+    int header_done;
+    int error;              /**< First error met, sticky. */
+} obstacle_avoidance_binary_decoder_t;
+
+/** @returns The size of the frame encoding the request. */
+int obstacle_avoidance_binary_request_size(const obstacle_avoidance_request_t *r);
+
+/** Encodes a request frame.
+ * @returns The frame size, or -1 if it does not fit in size bytes.
+ */
+int obstacle_avoidance_binary_encode_request(const obstacle_avoidance_request_t *r, uint8_t *buf, int size);
+
+/** Same as obstacle_avoidance_binary_encode_request, for a session request. */
+int obstacle_avoidance_binary_encode_session_request(const obstacle_avoidance_request_t *r, uint16_t id,
+                                                     uint8_t *buf, int size);
+
+/** Decodes a request frame, used by the planner.
+ *
+ * @param [out] r The request, its obstacles point to the given array.
+ * @param [out] id The request id for a session request, 0 otherwise. May be NULL.
+ * @param [in] obstacles, max_obstacles The array receiving the obstacles.
+ * @returns ERR_OK, ERR_VAL if the frame is invalid, or ERR_BUF if there are
+ * too many obstacles.
+ */
+int obstacle_avoidance_binary_decode_request(obstacle_avoidance_request_t *r, uint16_t *id,
+                                             obstacle_avoidance_obstacle_t *obstacles, int max_obstacles,
+                                             const uint8_t *buf, int len);
+
+/** Encodes a path frame, used by the planner.
+ * @returns The frame size, or -1 if it does not fit in size bytes.
+ */
+int obstacle_avoidance_binary_encode_path(const obstacle_avoidance_path_t *path, uint8_t *buf, int size);
+
+/** Same as obstacle_avoidance_binary_encode_path, answering a session request. */
+int obstacle_avoidance_binary_encode_session_path(const obstacle_avoidance_path_t *path, uint16_t id,
+                                                  uint8_t *buf, int size);
+
+/** Reads a frame header.
+ * @returns ERR_OK, or ERR_VAL if it is not a binary frame.
+ */
+int obstacle_avoidance_binary_decode_header(const uint8_t *buf, int *type, uint32_t *payload_len);
+
+/** Inits a decoder writing the points to the given array. */
+void obstacle_avoidance_binary_decoder_init(obstacle_avoidance_binary_decoder_t *d,
+                                            obstacle_avoidance_point_t *points, int max_points);
+
+/** Inits a decoder for the payload of a path, whose header was already read.
+ * @param [in] payload_len The length of the payload, without request id.
+ */
+void obstacle_avoidance_binary_decoder_init_payload(obstacle_avoidance_binary_decoder_t *d,
+                                                    obstacle_avoidance_point_t *points, int max_points,
+                                                    uint32_t payload_len);
+
+/** Feeds received bytes to the decoder. Bytes after the end of the frame are
+ * ignored.
+ *
+ * @returns ERR_OK, ERR_VAL if the frame is invalid, or ERR_BUF if the path
+ * does not fit in the point array.
+ */
+int obstacle_avoidance_binary_decoder_feed(obstacle_avoidance_binary_decoder_t *d, const uint8_t *data, int len);
+
+/** @returns 1 if the whole frame was decoded. */
+int obstacle_avoidance_binary_decoder_done(obstacle_avoidance_binary_decoder_t *d);
+
+/** Decodes a complete path frame.
+ *
+ * @param [out] path The path, its points point to the given array.
+ * @returns ERR_OK, ERR_VAL if the frame is invalid or incomplete, or ERR_BUF
+ * if the path does not fit in the point array.
+ */
+int obstacle_avoidance_binary_decode_path(obstacle_avoidance_path_t *path,
+                                          obstacle_avoidance_point_t *points, int max_points,
+                                          const uint8_t *buf, int len);
+
+#endif
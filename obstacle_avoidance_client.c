@@ -0,0 +1,231 @@
+#include <string.h>
+#include <lwip/err.h>
+#include "obstacle_avoidance_client.h"
+
+enum {
+    JOB_FREE,
+    JOB_QUEUED,             /* Submitted, not sent yet. */
+    JOB_SENT,               /* Owned by the worker until it completes. */
+    JOB_DONE
+};
+
+void obstacle_avoidance_client_init(obstacle_avoidance_client_t *c, struct ip_addr remote_ip, int port)
+{
+    int i;
+
+    memset(c, 0, sizeof(obstacle_avoidance_client_t));
+    obstacle_avoidance_session_init(&c->session, remote_ip, port);
+
+    platform_create_semaphore(&c->lock, 1);
+    platform_create_semaphore(&c->work, 0);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++) {
+        c->jobs[i].state = JOB_FREE;
+        platform_create_semaphore(&c->jobs[i].done, 0);
+    }
+}
+
+/** @returns The job of a handle, or NULL if the handle is not in use. */
+static obstacle_avoidance_job_t *get_job(obstacle_avoidance_client_t *c, int handle)
+{
+    if (handle < 0 || handle >= OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS)
+        return NULL;
+
+    if (c->jobs[handle].state == JOB_FREE)
+        return NULL;
+
+    return &c->jobs[handle];
+}
+
+int obstacle_avoidance_client_submit(obstacle_avoidance_client_t *c, obstacle_avoidance_request_t *request,
+                                     obstacle_avoidance_point_t *points, int max_points, int timeout_ms)
+{
+    obstacle_avoidance_job_t *job = NULL;
+    int i;
+
+    if (request->obstacle_count > OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES)
+        return ERR_BUF;
+
+    platform_take_semaphore(&c->lock);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS && job == NULL; i++) {
+        if (c->jobs[i].state == JOB_FREE)
+            job = &c->jobs[i];
+    }
+
+    if (job == NULL) {
+        platform_signal_semaphore(&c->lock);
+        return ERR_MEM;
+    }
+
+    job->request = *request;
+    job->request.obstacles = job->obstacles;
+    memcpy(job->obstacles, request->obstacles, request->obstacle_count * sizeof(obstacle_avoidance_obstacle_t));
+
+    job->points = points;
+    job->max_points = max_points;
+    job->timeout = timeout_ms;
+    job->path.points = NULL;
+    job->path.len = 0;
+    job->status = OBSTACLE_AVOIDANCE_PENDING;
+    job->waited = 0;
+    job->released = 0;
+    job->state = JOB_QUEUED;
+
+    platform_signal_semaphore(&c->lock);
+
+    platform_signal_semaphore(&c->work);
+
+    return job - c->jobs;
+}
+
+int obstacle_avoidance_client_poll(obstacle_avoidance_client_t *c, int handle, obstacle_avoidance_path_t *path)
+{
+    obstacle_avoidance_job_t *job;
+    int status;
+
+    platform_take_semaphore(&c->lock);
+
+    job = get_job(c, handle);
+
+    if (job == NULL) {
+        status = ERR_VAL;
+    } else {
+        status = job->status;
+        if (status == ERR_OK && path != NULL)
+            *path = job->path;
+    }
+
+    platform_signal_semaphore(&c->lock);
+
+    return status;
+}
+
+int obstacle_avoidance_client_wait(obstacle_avoidance_client_t *c, int handle, obstacle_avoidance_path_t *path)
+{
+    obstacle_avoidance_job_t *job = get_job(c, handle);
+
+    if (job == NULL)
+        return ERR_VAL;
+
+    if (!job->waited) {
+        platform_take_semaphore(&job->done);
+
+        platform_take_semaphore(&c->lock);
+        job->waited = 1;
+        platform_signal_semaphore(&c->lock);
+    }
+
+    return obstacle_avoidance_client_poll(c, handle, path);
+}
+
+void obstacle_avoidance_client_release(obstacle_avoidance_client_t *c, int handle)
+{
+    obstacle_avoidance_job_t *job;
+
+    platform_take_semaphore(&c->lock);
+
+    job = get_job(c, handle);
+
+    if (job == NULL) {
+        /* Nothing to do. */
+    } else if (job->state == JOB_SENT) {
+        job->released = 1;
+    } else {
+        /* Leaves the done semaphore at zero for the next request. */
+        if (job->state == JOB_DONE && !job->waited)
+            platform_take_semaphore(&job->done);
+
+        job->state = JOB_FREE;
+    }
+
+    platform_signal_semaphore(&c->lock);
+}
+
+/** Stores the result of a job, and wakes up its submitter. */
+static void job_complete(obstacle_avoidance_client_t *c, obstacle_avoidance_job_t *job, int status)
+{
+    platform_take_semaphore(&c->lock);
+
+    job->status = status;
+
+    if (job->released) {
+        job->state = JOB_FREE;
+    } else {
+        job->state = JOB_DONE;
+        platform_signal_semaphore(&job->done);
+    }
+
+    platform_signal_semaphore(&c->lock);
+}
+
+/** @returns 1 if the worker is waiting for an answer. */
+static int has_sent_jobs(obstacle_avoidance_client_t *c)
+{
+    int i, sent = 0;
+
+    platform_take_semaphore(&c->lock);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++) {
+        if (c->jobs[i].state == JOB_SENT)
+            sent = 1;
+    }
+
+    platform_signal_semaphore(&c->lock);
+
+    return sent;
+}
+
+void obstacle_avoidance_client_work(obstacle_avoidance_client_t *c)
+{
+    obstacle_avoidance_job_t *job;
+    int i, id, queued, status;
+
+    /* Sleeps until a request is submitted. The semaphore is not taken while
+     * answers are awaited, so it may wake up for nothing later, which is
+     * harmless. */
+    if (!has_sent_jobs(c))
+        platform_take_semaphore(&c->work);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++) {
+        job = &c->jobs[i];
+
+        /* Marked as sent first, so the submitter cannot free it meanwhile. */
+        platform_take_semaphore(&c->lock);
+        queued = job->state == JOB_QUEUED;
+        if (queued)
+            job->state = JOB_SENT;
+        platform_signal_semaphore(&c->lock);
+
+        if (!queued)
+            continue;
+
+        id = obstacle_avoidance_session_submit(&c->session, &job->request, &job->path,
+                                               job->points, job->max_points, job->timeout);
+
+        if (id < 0)
+            job_complete(c, job, id);
+        else
+            job->session_id = id;
+    }
+
+    if (!has_sent_jobs(c))
+        return;
+
+    obstacle_avoidance_session_poll(&c->session, OBSTACLE_AVOIDANCE_CLIENT_POLL_PERIOD);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++) {
+        job = &c->jobs[i];
+
+        /* Only the worker changes the state of a sent job. */
+        if (job->state != JOB_SENT)
+            continue;
+
+        status = obstacle_avoidance_session_status(&c->session, job->session_id);
+
+        if (status != OBSTACLE_AVOIDANCE_PENDING) {
+            obstacle_avoidance_session_cancel(&c->session, job->session_id);
+            job_complete(c, job, status);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/** @file obstacle_avoidance_client.h
+ * @brief Asynchronous path planner client.
+ *
+ * Waiting for the path planner takes a whole network round trip, during
+ * which the strategy should keep driving the current path or moving the arms.
+ * The client lets any task submit a request and get a handle back at once.
+ * A worker task owns the planner session, sends the requests and receives
+ * the answers. The submitter can then poll the handle, or wait on it, which
+ * blocks on a semaphore signaled by the worker.
+ *
+ * The worker loop is obstacle_avoidance_client_work, the task itself is
+ * created by the robot code.
+ */
+#ifndef OBSTACLE_AVOIDANCE_CLIENT_H_
+#define OBSTACLE_AVOIDANCE_CLIENT_H_
+
+#include <platform.h>
+#include "obstacle_avoidance_protocol.h"
+#include "obstacle_avoidance_binary.h"
+#include "obstacle_avoidance_session.h"
+
+/** Maximum number of requests submitted and not released yet. */
+#define OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING
+
+/** Time the worker waits for answers before checking for new requests, in ms. */
+#define OBSTACLE_AVOIDANCE_CLIENT_POLL_PERIOD 20
+
+typedef struct {
+    int state;
+    int status;                 /**< OBSTACLE_AVOIDANCE_PENDING, ERR_OK or an error. */
+    int waited;                 /**< Set once the done semaphore was taken. */
+    int released;               /**< Released before completion, freed by the worker. */
+    int session_id;
+    int timeout;                /**< ms */
+
+    /** Copy of the request, so the submitter does not have to keep it. */
+    obstacle_avoidance_request_t request;
+    obstacle_avoidance_obstacle_t obstacles[OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES];
+
+    obstacle_avoidance_path_t path;
+    obstacle_avoidance_point_t *points;
+    int max_points;
+
+    semaphore_t done;           /**< Signaled once when the request completes. */
+} obstacle_avoidance_job_t;
+
+typedef struct {
+    obstacle_avoidance_session_t session; /**< Only used by the worker. */
+    obstacle_avoidance_job_t jobs[OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS];
+    semaphore_t lock;
+    semaphore_t work;           /**< Signaled on each submit. */
+} obstacle_avoidance_client_t;
+
+/** Inits a client for the given planner. */
+void obstacle_avoidance_client_init(obstacle_avoidance_client_t *c, struct ip_addr remote_ip, int port);
+
+/** Submits a request, returning immediately.
+ *
+ * @param [in] request The request, copied.
+ * @param [in] points, max_points The array receiving the points. The worker
+ * writes it until the request completes, even if it was released before.
+ * @param [in] timeout_ms Time after which the request fails with ERR_TIMEOUT.
+ * @returns A handle, or ERR_MEM if there are too many requests not released,
+ * or ERR_BUF if the request has too many obstacles.
+ */
+int obstacle_avoidance_client_submit(obstacle_avoidance_client_t *c, obstacle_avoidance_request_t *request,
+                                     obstacle_avoidance_point_t *points, int max_points, int timeout_ms);
+
+/** Checks a request without blocking.
+ *
+ * @param [out] path The path once the request completed successfully. May be NULL.
+ * @returns OBSTACLE_AVOIDANCE_PENDING, or the result of the request, ERR_OK
+ * or an error.
+ */
+int obstacle_avoidance_client_poll(obstacle_avoidance_client_t *c, int handle, obstacle_avoidance_path_t *path);
+
+/** Blocks until a request completes.
+ * @param [out] path The path if the request succeeded. May be NULL.
+ * @returns The result of the request, ERR_OK or an error.
+ */
+int obstacle_avoidance_client_wait(obstacle_avoidance_client_t *c, int handle, obstacle_avoidance_path_t *path);
+
+/** Frees a handle. A request still pending is forgotten. */
+void obstacle_avoidance_client_release(obstacle_avoidance_client_t *c, int handle);
+
+/** Runs the worker once : waits for requests if there is nothing to do, sends
+ * the new requests, and receives answers for at most
+ * OBSTACLE_AVOIDANCE_CLIENT_POLL_PERIOD.
+ *
+ * Must be called in a loop by the worker task, which is the only one to use
+ * the network.
+ */
+void obstacle_avoidance_client_work(obstacle_avoidance_client_t *c);
+
+#endif
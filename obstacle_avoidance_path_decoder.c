@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <string.h>
+#include <lwip/err.h>
+#include "obstacle_avoidance_path_decoder.h"
+
+/** Initial number of points allocated, doubled when full. */
+#define INITIAL_CAPACITY 16
+
+/** Digits kept in the mantissa, so it cannot overflow. */
+#define MAX_DIGITS 18
+
+enum {
+    STATE_START,            /* Before the opening bracket of the path. */
+    STATE_PATH_START,       /* After it, expecting a point or the end. */
+    STATE_POINT_START,      /* After the opening bracket of a point. */
+    STATE_VALUE,            /* After a comma inside a point. */
+    STATE_NUMBER,           /* Inside a number. */
+    STATE_AFTER_VALUE,      /* Expecting a comma or the end of the point. */
+    STATE_AFTER_POINT,      /* Expecting a comma or the end of the path. */
+    STATE_NEXT_POINT,       /* After a comma between points. */
+    STATE_DONE
+};
+
+enum {
+    PART_INTEGER,
+    PART_FRACTION,
+    PART_EXPONENT_SIGN,
+    PART_EXPONENT
+};
+
+void obstacle_avoidance_path_decoder_init(obstacle_avoidance_path_decoder_t *d, obstacle_avoidance_path_t *path)
+{
+    memset(d, 0, sizeof(obstacle_avoidance_path_decoder_t));
+    d->path = path;
+    d->state = STATE_START;
+
+    path->points = NULL;
+    path->len = 0;
+}
+
+int obstacle_avoidance_path_decoder_done(obstacle_avoidance_path_decoder_t *d)
+{
+    return d->error == ERR_OK && d->state == STATE_DONE;
+}
+
+static int is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static void number_start(obstacle_avoidance_path_decoder_t *d, char c)
+{
+    d->mantissa = 0;
+    d->digits = 0;
+    d->decimals = 0;
+    d->exponent = 0;
+    d->negative = c == '-';
+    d->exponent_negative = 0;
+    d->number_part = PART_INTEGER;
+
+    if (is_digit(c)) {
+        d->mantissa = c - '0';
+        d->digits = 1;
+    }
+
+    d->state = STATE_NUMBER;
+}
+
+static void number_digit(obstacle_avoidance_path_decoder_t *d, char c)
+{
+    if (d->digits < MAX_DIGITS) {
+        d->mantissa = d->mantissa * 10 + c - '0';
+        d->digits++;
+        if (d->number_part == PART_FRACTION)
+            d->decimals++;
+    } else if (d->number_part == PART_INTEGER) {
+        /* Ignored digits still count for the magnitude. */
+        d->decimals--;
+    }
+}
+
+/** Consumes a character of a number.
+ * @returns 1 if it was part of the number, 0 if the number ended before it. */
+static int number_char(obstacle_avoidance_path_decoder_t *d, char c)
+{
+    switch (d->number_part) {
+        case PART_INTEGER:
+        case PART_FRACTION:
+            if (is_digit(c)) {
+                number_digit(d, c);
+                return 1;
+            }
+            if (c == '.' && d->number_part == PART_INTEGER) {
+                d->number_part = PART_FRACTION;
+                return 1;
+            }
+            if (c == 'e' || c == 'E') {
+                d->number_part = PART_EXPONENT_SIGN;
+                return 1;
+            }
+            return 0;
+
+        case PART_EXPONENT_SIGN:
+            d->number_part = PART_EXPONENT;
+            if (c == '-' || c == '+') {
+                d->exponent_negative = c == '-';
+                return 1;
+            }
+            return number_char(d, c);
+
+        default:
+            if (is_digit(c)) {
+                if (d->exponent < 1000)
+                    d->exponent = d->exponent * 10 + c - '0';
+                return 1;
+            }
+            return 0;
+    }
+}
+
+/** Computes the number value, truncated toward zero like a cast. */
+static int number_end(obstacle_avoidance_path_decoder_t *d, int32_t *value)
+{
+    int64_t v = d->mantissa;
+    int e = d->exponent_negative ? -d->exponent : d->exponent;
+
+    if (d->digits == 0)
+        return ERR_VAL;
+
+    for (e -= d->decimals; e > 0 && v != 0; e--) {
+        v *= 10;
+        if (v > INT32_MAX)
+            return ERR_VAL;
+    }
+
+    for (; e < 0 && v != 0; e++)
+        v /= 10;
+
+    if (v > INT32_MAX)
+        return ERR_VAL;
+
+    *value = d->negative ? -v : v;
+
+    return ERR_OK;
+}
+
+static int append_point(obstacle_avoidance_path_decoder_t *d)
+{
+    obstacle_avoidance_path_t *path = d->path;
+    obstacle_avoidance_point_t *points, *p;
+    int capacity;
+
+    if (d->field < OBSTACLE_AVOIDANCE_POINT_FIELDS)
+        return ERR_VAL;
+
+    if (path->len == d->capacity) {
+        capacity = d->capacity ? 2 * d->capacity : INITIAL_CAPACITY;
+        points = realloc(path->points, capacity * sizeof(obstacle_avoidance_point_t));
+
+        if (points == NULL)
+            return ERR_MEM;
+
+        path->points = points;
+        d->capacity = capacity;
+    }
+
+    p = &path->points[path->len];
+    p->x = d->values[0];
+    p->y = d->values[1];
+    p->vx = d->values[2];
+    p->vy = d->values[3];
+    p->timestamp = d->values[4];
+
+    path->len++;
+
+    return ERR_OK;
+}
+
+static int feed_char(obstacle_avoidance_path_decoder_t *d, char c)
+{
+    int32_t value;
+    int err;
+
+    if (d->state == STATE_NUMBER) {
+        if (number_char(d, c))
+            return ERR_OK;
+
+        err = number_end(d, &value);
+        if (err != ERR_OK)
+            return err;
+
+        /* Extra values in a point are ignored. */
+        if (d->field < OBSTACLE_AVOIDANCE_POINT_FIELDS)
+            d->values[d->field] = value;
+        d->field++;
+        d->state = STATE_AFTER_VALUE;
+    }
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        return ERR_OK;
+
+    switch (d->state) {
+        case STATE_START:
+            if (c != '[')
+                return ERR_VAL;
+            d->state = STATE_PATH_START;
+            break;
+
+        case STATE_PATH_START:
+        case STATE_NEXT_POINT:
+            if (c == ']' && d->state == STATE_PATH_START) {
+                d->state = STATE_DONE;
+            } else if (c == '[') {
+                d->field = 0;
+                d->state = STATE_POINT_START;
+            } else {
+                return ERR_VAL;
+            }
+            break;
+
+        case STATE_POINT_START:
+        case STATE_VALUE:
+            if (c != '-' && !is_digit(c))
+                return ERR_VAL;
+            number_start(d, c);
+            break;
+
+        case STATE_AFTER_VALUE:
+            if (c == ',') {
+                d->state = STATE_VALUE;
+            } else if (c == ']') {
+                err = append_point(d);
+                if (err != ERR_OK)
+                    return err;
+                d->state = STATE_AFTER_POINT;
+            } else {
+                return ERR_VAL;
+            }
+            break;
+
+        case STATE_AFTER_POINT:
+            if (c == ',')
+                d->state = STATE_NEXT_POINT;
+            else if (c == ']')
+                d->state = STATE_DONE;
+            else
+                return ERR_VAL;
+            break;
+
+        default:
+            /* Anything after the path is ignored. */
+            break;
+    }
+
+    return ERR_OK;
+}
+
+int obstacle_avoidance_path_decoder_feed(obstacle_avoidance_path_decoder_t *d, const char *data, int len)
+{
+    int i;
+
+    for (i = 0; i < len && d->error == ERR_OK && d->state != STATE_DONE; i++)
+        d->error = feed_char(d, data[i]);
+
+    return d->error;
+}
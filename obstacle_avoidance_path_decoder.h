@@ -0,0 +1,54 @@
+/** @file obstacle_avoidance_path_decoder.h
+ * @brief Streaming decoder of the JSON paths sent by the path planner.
+ *
+ * The path is a JSON array of points, each point being an array of x, y, vx,
+ * vy and timestamp. Instead of buffering the whole answer and building a
+ * JSON tree, the decoder consumes the answer as it arrives and appends each
+ * point to the path as soon as it is complete. The path grows as needed, so
+ * there is no limit on its length.
+ *
+ * The points may move when the path grows, so the path must only be read
+ * once the decoder is done with it.
+ */
+#ifndef OBSTACLE_AVOIDANCE_PATH_DECODER_H_
+#define OBSTACLE_AVOIDANCE_PATH_DECODER_H_
+
+#include <stdint.h>
+#include "obstacle_avoidance_protocol.h"
+
+/** Number of values in a point. */
+#define OBSTACLE_AVOIDANCE_POINT_FIELDS 5
+
+typedef struct {
+    obstacle_avoidance_path_t *path;
+    int capacity;           /**< Number of points allocated in the path. */
+    int state;
+    int error;              /**< First error met, sticky. */
+
+    /* Point being decoded. */
+    int field;
+    int32_t values[OBSTACLE_AVOIDANCE_POINT_FIELDS];
+
+    /* Number being decoded, as mantissa * 10^(exponent - decimals). */
+    int64_t mantissa;
+    int digits;
+    int decimals;
+    int exponent;
+    int negative, exponent_negative;
+    int number_part;        /**< Integer, fraction or exponent. */
+} obstacle_avoidance_path_decoder_t;
+
+/** Inits a decoder filling the given path, which is emptied. */
+void obstacle_avoidance_path_decoder_init(obstacle_avoidance_path_decoder_t *d, obstacle_avoidance_path_t *path);
+
+/** Feeds a part of the answer to the decoder.
+ *
+ * @returns ERR_OK, ERR_VAL if the answer is not a valid path, or ERR_MEM if
+ * the path could not grow.
+ */
+int obstacle_avoidance_path_decoder_feed(obstacle_avoidance_path_decoder_t *d, const char *data, int len);
+
+/** @returns 1 once the whole path was decoded. */
+int obstacle_avoidance_path_decoder_done(obstacle_avoidance_path_decoder_t *d);
+
+#endif
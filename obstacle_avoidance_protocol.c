@@ -4,8 +4,13 @@
 #include <lwip/ip.h>
 #include <lwip/sys.h>
 #include "obstacle_avoidance_protocol.h"
+#include "obstacle_avoidance_binary.h"
+#include "obstacle_avoidance_path_decoder.h"
 #include "json.h"
 
+/** Set once the server answered a binary request in JSON. */
+static int server_is_json_only = 0;
+
 
 void obstacle_avoidance_request_create(obstacle_avoidance_request_t *r, int obstacle_count)
 {
@@ -67,83 +72,177 @@ char *obstacle_avoidance_request_encode(obstacle_avoidance_request_t *r)
 
 int obstacle_avoidance_decode_path(obstacle_avoidance_path_t *path,const char *json)
 {
-    JsonNode *node, *n;
-    int i;
-
-    node = json_decode(json);
-
-    if (node == NULL || node->tag != JSON_ARRAY)
-        return ERR_VAL;
+    obstacle_avoidance_path_decoder_t decoder;
+    int err;
 
-    path->len = json_get_length(node);
+    obstacle_avoidance_path_decoder_init(&decoder, path);
+    err = obstacle_avoidance_path_decoder_feed(&decoder, json, strlen(json));
 
-    path->points = malloc(sizeof(obstacle_avoidance_point_t) * path->len);
+    if (err == ERR_OK && !obstacle_avoidance_path_decoder_done(&decoder))
+        err = ERR_VAL;
 
-    i = 0;
-    json_foreach(n, node) {
-        path->points[i].x  = json_find_element(n, 0)->number_;
-        path->points[i].y  = json_find_element(n, 1)->number_;
-        path->points[i].vx = json_find_element(n, 2)->number_;
-        path->points[i].vy = json_find_element(n, 3)->number_;
-        path->points[i].timestamp = json_find_element(n, 4)->number_;
-        i++;
-    }
+    if (err != ERR_OK)
+        obstacle_avoidance_delete_path(path);
 
-    return ERR_OK;
+    return err;
 }
 
 int obstacle_avoidance_send_request(obstacle_avoidance_request_t *request, struct ip_addr remote_ip, int port, obstacle_avoidance_path_t *path)
 {
-    /* XXX find a better way to do this. */
-    #define MAX_LEN 16384
+    obstacle_avoidance_path_decoder_t decoder;
     char *data;
-    static char answer[MAX_LEN];
     void *tmp;
-    struct netconn *conn = NULL;
-
+    struct netconn *conn;
     struct netbuf *buf;
     u16_t len;
     int err;
 
-    data = obstacle_avoidance_request_encode(request);
+    obstacle_avoidance_path_decoder_init(&decoder, path);
 
     conn = netconn_new(NETCONN_TCP);
+    if (conn == NULL)
+        return ERR_MEM;
 
     err = netconn_connect(conn, &remote_ip, port);
-    if (err != ERR_OK) {
+
+    if (err == ERR_OK) {
+        data = obstacle_avoidance_request_encode(request);
+        err = netconn_write(conn, data, strlen(data), NETCONN_COPY);
         free(data);
-        netconn_delete(conn);
-        return err;
     }
 
-    err = netconn_write(conn, data, strlen(data), NETCONN_COPY);
+    /* Each part of the answer is decoded as soon as it arrives. */
+    while (err == ERR_OK && !obstacle_avoidance_path_decoder_done(&decoder)) {
+        err = netconn_recv(conn, &buf);
+        if (err != ERR_OK)
+            break;
 
-    if (err != ERR_OK) {
-        free(data);
-        netconn_delete(conn);
+        do {
+            netbuf_data(buf, &tmp, &len);
+            err = obstacle_avoidance_path_decoder_feed(&decoder, tmp, len);
+        } while (err == ERR_OK && netbuf_next(buf) >= 0);
+
+        netbuf_delete(buf);
+    }
+
+    netconn_delete(conn);
+
+    if (obstacle_avoidance_path_decoder_done(&decoder))
+        return ERR_OK;
+
+    /* The connection was closed before the end of the path. */
+    if (err == ERR_OK || err == ERR_CLSD)
+        err = ERR_VAL;
+
+    obstacle_avoidance_delete_path(path);
+
+    return err;
+}
+
+/** Same as obstacle_avoidance_send_request_static, but always in JSON. */
+static int send_request_json(obstacle_avoidance_request_t *request, struct ip_addr remote_ip, int port,
+                             obstacle_avoidance_path_t *path, obstacle_avoidance_point_t *points, int max_points)
+{
+    obstacle_avoidance_path_t json_path;
+    int err;
+
+    err = obstacle_avoidance_send_request(request, remote_ip, port, &json_path);
+    if (err != ERR_OK)
         return err;
+
+    if (json_path.len > max_points) {
+        obstacle_avoidance_delete_path(&json_path);
+        return ERR_BUF;
     }
 
-    free(data);
+    memcpy(points, json_path.points, json_path.len * sizeof(obstacle_avoidance_point_t));
+    path->points = points;
+    path->len = json_path.len;
+    obstacle_avoidance_delete_path(&json_path);
+
+    return ERR_OK;
+}
+
+int obstacle_avoidance_send_request_static(obstacle_avoidance_request_t *request, struct ip_addr remote_ip, int port,
+                                           obstacle_avoidance_path_t *path, obstacle_avoidance_point_t *points, int max_points)
+{
+    uint8_t frame[OBSTACLE_AVOIDANCE_BINARY_MAX_REQUEST_SIZE];
+    obstacle_avoidance_binary_decoder_t decoder;
+    struct netconn *conn;
+    struct netbuf *buf;
+    void *data;
+    u16_t len;
+    int frame_len, err;
+    int answered = 0, is_json = 0, closed = 0;
+
+    if (server_is_json_only)
+        return send_request_json(request, remote_ip, port, path, points, max_points);
+
+    frame_len = obstacle_avoidance_binary_encode_request(request, frame, sizeof(frame));
+    if (frame_len < 0)
+        return ERR_BUF;
+
+    conn = netconn_new(NETCONN_TCP);
+    if (conn == NULL)
+        return ERR_MEM;
+
+    err = netconn_connect(conn, &remote_ip, port);
+
+    if (err == ERR_OK)
+        err = netconn_write(conn, frame, frame_len, NETCONN_COPY);
+
+    obstacle_avoidance_binary_decoder_init(&decoder, points, max_points);
+
+    /* Points are decoded as they arrive, the answer is never buffered. */
+    while (err == ERR_OK && !obstacle_avoidance_binary_decoder_done(&decoder)) {
+        err = netconn_recv(conn, &buf);
+
+        if (err != ERR_OK) {
+            /* A server which only knows JSON may fail to parse the request,
+             * but a binary one may also have dropped the connection. */
+            if (!answered)
+                closed = 1;
+            break;
+        }
 
-    int answer_offset = 0;
-    while ((err = netconn_recv(conn, &buf)) == ERR_OK) {
         do {
-            /* Copies the buffer data into a string. */
-            netbuf_data(buf, &tmp, &len);
-            if (answer_offset + len >= MAX_LEN) {   /* >= for null-terminator */
-                return ERR_BUF;
+            netbuf_data(buf, &data, &len);
+
+            if (!answered && len > 0) {
+                answered = 1;
+                is_json = ((uint8_t *)data)[0] != OBSTACLE_AVOIDANCE_BINARY_MAGIC;
             }
-            memcpy(answer + answer_offset, tmp, len);
-            answer_offset += len;
-        } while (netbuf_next(buf) >= 0);
-        answer[answer_offset] = '\0';
+
+            if (!is_json)
+                err = obstacle_avoidance_binary_decoder_feed(&decoder, data, len);
+        } while (err == ERR_OK && !is_json && netbuf_next(buf) >= 0);
+
         netbuf_delete(buf);
+
+        if (is_json)
+            break;
     }
 
-    err = obstacle_avoidance_decode_path(path, answer);
     netconn_delete(conn);
-    return err;
+
+    if (is_json || closed) {
+        err = send_request_json(request, remote_ip, port, path, points, max_points);
+
+        /* Only remembered if the server answered in JSON and it works. After
+         * a closed connection the next request tries binary again. */
+        if (is_json && err == ERR_OK)
+            server_is_json_only = 1;
+
+        return err;
+    }
+
+    if (err != ERR_OK)
+        return err;
+
+    path->points = points;
+    path->len = decoder.len;
+
+    return ERR_OK;
 }
 
 void obstacle_avoidance_delete_path(obstacle_avoidance_path_t *path)
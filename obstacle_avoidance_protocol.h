@@ -42,5 +42,19 @@ int obstacle_avoidance_decode_path(obstacle_avoidance_path_t *path,const char *j
 
 void obstacle_avoidance_delete_path(obstacle_avoidance_path_t *path);
 
+/** Sends a request and decodes the path into the given array, without allocating.
+ *
+ * The binary encoding of obstacle_avoidance_binary.h is used. If the server
+ * does not know it and answers in JSON, JSON is used from then on. If it
+ * closes the connection without answering, this request is sent again in
+ * JSON, but the next one tries binary again.
+ *
+ * @param [out] path The path, its points point to the given array.
+ * @param [in] points, max_points The array receiving the points.
+ * @returns ERR_OK, ERR_BUF if the path does not fit, or a network error.
+ */
+int obstacle_avoidance_send_request_static(obstacle_avoidance_request_t *request, struct ip_addr remote_ip, int port,
+                                           obstacle_avoidance_path_t *path, obstacle_avoidance_point_t *points, int max_points);
+
 int obstacle_avoidance_send_request(obstacle_avoidance_request_t *request, struct ip_addr remote_ip, int port, obstacle_avoidance_path_t *path);
 #endif
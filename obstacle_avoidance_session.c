@@ -0,0 +1,384 @@
+#include <string.h>
+#include <lwip/tcpip.h>
+#include <lwip/ip.h>
+#include <lwip/sys.h>
+#include <uptime.h>
+#include "obstacle_avoidance_session.h"
+
+#define FRAME_HEADER_SIZE (OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE)
+
+static void reset_reception(obstacle_avoidance_session_t *s)
+{
+    s->header_len = 0;
+    s->remaining = 0;
+    s->current = NULL;
+}
+
+/** @returns The request with the given id, or a free slot for id -1. */
+static obstacle_avoidance_session_request_t *find_request(obstacle_avoidance_session_t *s, int id)
+{
+    int i;
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING; i++) {
+        if (s->requests[i].id == id)
+            return &s->requests[i];
+    }
+
+    return NULL;
+}
+
+/** Closes the connection and fails every outstanding request. */
+static void session_fail(obstacle_avoidance_session_t *s, int err)
+{
+    int i;
+
+    if (s->conn != NULL) {
+        netconn_delete(s->conn);
+        s->conn = NULL;
+    }
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING; i++) {
+        if (s->requests[i].status == OBSTACLE_AVOIDANCE_PENDING)
+            s->requests[i].status = err;
+    }
+
+    reset_reception(s);
+}
+
+static int session_connect(obstacle_avoidance_session_t *s)
+{
+    int err;
+
+    s->conn = netconn_new(NETCONN_TCP);
+    if (s->conn == NULL)
+        return ERR_MEM;
+
+    err = netconn_connect(s->conn, &s->remote_ip, s->port);
+    if (err != ERR_OK) {
+        netconn_delete(s->conn);
+        s->conn = NULL;
+        return err;
+    }
+
+    reset_reception(s);
+    s->answered = 0;
+
+    return ERR_OK;
+}
+
+/** Sends the outstanding requests again with obstacle_avoidance_send_request_static,
+ * after the planner did not answer the binary ones.
+ *
+ * @param [in] json_only Set if the planner answered in JSON, the following
+ * requests are then sent the same way. Otherwise the connection may just
+ * have been dropped, and the next submit opens a binary one again.
+ */
+static void session_fallback(obstacle_avoidance_session_t *s, int json_only)
+{
+    obstacle_avoidance_session_request_t *r;
+    int i;
+
+    /* Closes the connection, the requests stay outstanding. */
+    session_fail(s, OBSTACLE_AVOIDANCE_PENDING);
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING; i++) {
+        r = &s->requests[i];
+        if (r->id < 0 || r->status != OBSTACLE_AVOIDANCE_PENDING)
+            continue;
+
+        r->status = obstacle_avoidance_send_request_static(r->request, s->remote_ip, s->port,
+                                                           r->path, r->points, r->max_points);
+
+        /* Only remembered if it worked, it may have been a network error. */
+        if (json_only && r->status == ERR_OK)
+            s->json = 1;
+    }
+}
+
+void obstacle_avoidance_session_init(obstacle_avoidance_session_t *s, struct ip_addr remote_ip, int port)
+{
+    int i;
+
+    memset(s, 0, sizeof(obstacle_avoidance_session_t));
+    s->remote_ip = remote_ip;
+    s->port = port;
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING; i++)
+        s->requests[i].id = -1;
+}
+
+void obstacle_avoidance_session_close(obstacle_avoidance_session_t *s)
+{
+    session_fail(s, ERR_CLSD);
+    s->json = 0;
+}
+
+int obstacle_avoidance_session_submit(obstacle_avoidance_session_t *s, obstacle_avoidance_request_t *request,
+                                      obstacle_avoidance_path_t *path,
+                                      obstacle_avoidance_point_t *points, int max_points,
+                                      int timeout_ms)
+{
+    uint8_t frame[OBSTACLE_AVOIDANCE_BINARY_MAX_REQUEST_SIZE];
+    obstacle_avoidance_session_request_t *r;
+    int frame_len, err;
+
+    r = find_request(s, -1);
+    if (r == NULL)
+        return ERR_MEM;
+
+    if (s->json) {
+        r->id = s->next_id++;
+        r->request = request;
+        r->path = path;
+        r->points = points;
+        r->max_points = max_points;
+        r->deadline = uptime_get() + timeout_ms * 1000;
+        r->status = obstacle_avoidance_send_request_static(request, s->remote_ip, s->port,
+                                                           path, points, max_points);
+        return r->id;
+    }
+
+    frame_len = obstacle_avoidance_binary_encode_session_request(request, s->next_id, frame, sizeof(frame));
+    if (frame_len < 0)
+        return ERR_BUF;
+
+    if (s->conn == NULL) {
+        err = session_connect(s);
+        if (err != ERR_OK)
+            return err;
+    }
+
+    err = netconn_write(s->conn, frame, frame_len, NETCONN_COPY);
+    if (err != ERR_OK) {
+        session_fail(s, err);
+        return err;
+    }
+
+    r->id = s->next_id++;
+    r->status = OBSTACLE_AVOIDANCE_PENDING;
+    r->request = request;
+    r->path = path;
+    r->points = points;
+    r->max_points = max_points;
+    r->deadline = uptime_get() + timeout_ms * 1000;
+
+    return r->id;
+}
+
+int obstacle_avoidance_session_status(obstacle_avoidance_session_t *s, int id)
+{
+    obstacle_avoidance_session_request_t *r = find_request(s, id);
+
+    if (id < 0 || r == NULL)
+        return ERR_VAL;
+
+    return r->status;
+}
+
+void obstacle_avoidance_session_cancel(obstacle_avoidance_session_t *s, int id)
+{
+    obstacle_avoidance_session_request_t *r = find_request(s, id);
+
+    if (id >= 0 && r != NULL)
+        r->id = -1;
+}
+
+void obstacle_avoidance_session_check_timeouts(obstacle_avoidance_session_t *s, int32_t now)
+{
+    int i;
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING; i++) {
+        if (s->requests[i].id >= 0 && s->requests[i].status == OBSTACLE_AVOIDANCE_PENDING
+            && s->requests[i].deadline - now <= 0)
+            s->requests[i].status = ERR_TIMEOUT;
+    }
+}
+
+/** @returns 1 if the answer being received still has a request waiting for it. */
+static int current_is_waited(obstacle_avoidance_session_t *s)
+{
+    /* The slot may have been cancelled, or even reused by another request. */
+    return s->current != NULL && s->current->id == s->current_id
+           && s->current->status == OBSTACLE_AVOIDANCE_PENDING;
+}
+
+/** Handles a complete answer header. @returns ERR_OK or ERR_VAL. */
+static int answer_start(obstacle_avoidance_session_t *s)
+{
+    uint32_t payload_len;
+    int type;
+
+    if (obstacle_avoidance_binary_decode_header(s->header, &type, &payload_len) != ERR_OK
+        || type != OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH
+        || payload_len < OBSTACLE_AVOIDANCE_BINARY_ID_SIZE)
+        return ERR_VAL;
+
+    s->current_id = s->header[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE]
+                    | (s->header[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + 1] << 8);
+    s->remaining = payload_len - OBSTACLE_AVOIDANCE_BINARY_ID_SIZE;
+    s->current = find_request(s, s->current_id);
+
+    if (current_is_waited(s))
+        obstacle_avoidance_binary_decoder_init_payload(&s->decoder, s->current->points,
+                                                       s->current->max_points, s->remaining);
+
+    return ERR_OK;
+}
+
+/** Completes the request of the answer received, if it is still waited. */
+static void answer_end(obstacle_avoidance_session_t *s)
+{
+    obstacle_avoidance_session_request_t *r = s->current;
+
+    if (current_is_waited(s)) {
+        if (s->decoder.error != ERR_OK) {
+            r->status = s->decoder.error;
+        } else if (!obstacle_avoidance_binary_decoder_done(&s->decoder)) {
+            r->status = ERR_VAL;
+        } else {
+            r->path->points = r->points;
+            r->path->len = s->decoder.len;
+            r->status = ERR_OK;
+        }
+    }
+
+    reset_reception(s);
+}
+
+int obstacle_avoidance_session_feed(obstacle_avoidance_session_t *s, const uint8_t *data, int len)
+{
+    int n;
+
+    /* A JSON answer starts with '[' or '{', never with the magic byte. */
+    if (!s->answered && len > 0) {
+        s->answered = 1;
+        if (data[0] != OBSTACLE_AVOIDANCE_BINARY_MAGIC) {
+            s->json = 1;
+            return ERR_VAL;
+        }
+    }
+
+    while (len > 0) {
+        if (s->header_len < FRAME_HEADER_SIZE) {
+            n = FRAME_HEADER_SIZE - s->header_len;
+            if (n > len)
+                n = len;
+
+            memcpy(s->header + s->header_len, data, n);
+            s->header_len += n;
+
+            if (s->header_len == FRAME_HEADER_SIZE && answer_start(s) != ERR_OK)
+                return ERR_VAL;
+        } else {
+            n = len;
+            if ((uint32_t)n > s->remaining)
+                n = s->remaining;
+
+            /* The frame length is known, so an invalid path only fails its
+             * own request and the following answers are still decoded. */
+            if (current_is_waited(s))
+                obstacle_avoidance_binary_decoder_feed(&s->decoder, data, n);
+
+            s->remaining -= n;
+        }
+
+        data += n;
+        len -= n;
+
+        if (s->header_len == FRAME_HEADER_SIZE && s->remaining == 0)
+            answer_end(s);
+    }
+
+    return ERR_OK;
+}
+
+/** Receives bytes once, waiting at most timeout_ms.
+ * @returns ERR_OK, ERR_TIMEOUT if nothing was received, or an error, after
+ * which the session was failed.
+ */
+static int session_receive(obstacle_avoidance_session_t *s, int timeout_ms)
+{
+    struct netbuf *buf;
+    void *data;
+    u16_t len;
+    int err;
+
+    if (s->conn == NULL)
+        return ERR_CLSD;
+
+    /* A zero timeout would block forever. */
+    netconn_set_recvtimeout(s->conn, timeout_ms > 0 ? timeout_ms : 1);
+    err = netconn_recv(s->conn, &buf);
+
+    if (err == ERR_TIMEOUT)
+        return err;
+
+    if (err != ERR_OK) {
+        /* A planner which only knows JSON may fail to parse the request,
+         * but a binary one may also have dropped the connection. */
+        if (!s->answered)
+            session_fallback(s, 0);
+        else
+            session_fail(s, err);
+        return err;
+    }
+
+    do {
+        netbuf_data(buf, &data, &len);
+        err = obstacle_avoidance_session_feed(s, data, len);
+    } while (err == ERR_OK && netbuf_next(buf) >= 0);
+
+    netbuf_delete(buf);
+
+    if (err != ERR_OK && s->json) {
+        /* Only kept if JSON works, see session_fallback. */
+        s->json = 0;
+        session_fallback(s, 1);
+    } else if (err != ERR_OK) {
+        /* The stream cannot be resynchronized, the connection is restarted. */
+        session_fail(s, err);
+    }
+
+    return err;
+}
+
+int obstacle_avoidance_session_poll(obstacle_avoidance_session_t *s, int timeout_ms)
+{
+    int err = session_receive(s, timeout_ms);
+
+    obstacle_avoidance_session_check_timeouts(s, uptime_get());
+
+    return err;
+}
+
+int obstacle_avoidance_session_wait(obstacle_avoidance_session_t *s, int id)
+{
+    obstacle_avoidance_session_request_t *r = find_request(s, id);
+    int32_t left;
+    int status;
+
+    if (id < 0 || r == NULL)
+        return ERR_VAL;
+
+    while (r->status == OBSTACLE_AVOIDANCE_PENDING) {
+        left = r->deadline - uptime_get();
+
+        if (left <= 0) {
+            r->status = ERR_TIMEOUT;
+            break;
+        }
+
+        if (s->conn == NULL) {
+            r->status = ERR_CLSD;
+            break;
+        }
+
+        /* Rounded up, so the deadline is past when it times out. */
+        obstacle_avoidance_session_poll(s, left / 1000 + 1);
+    }
+
+    status = r->status;
+    r->id = -1;
+
+    return status;
+}
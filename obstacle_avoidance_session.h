@@ -0,0 +1,139 @@
+/** @file obstacle_avoidance_session.h
+ * @brief Persistent connection to the path planner, with pipelined requests.
+ *
+ * obstacle_avoidance_send_request opens a new connection for every request,
+ * which costs a TCP handshake over the slow serial link each time. A session
+ * keeps its connection open and sends the session frames of
+ * obstacle_avoidance_binary.h, which carry a request id. Several requests can
+ * then be outstanding at once, for example to compare alternative goals, and
+ * the answers are matched to their request by id, whatever their order.
+ *
+ * Each request has its own timeout. An answer arriving after its request
+ * timed out or was cancelled is skipped. On a connection error every
+ * outstanding request fails, and the connection is opened again on the next
+ * submit.
+ *
+ * The planner may only know JSON. This is detected on the first answer of a
+ * connection, which does not start with the magic byte. The outstanding
+ * requests are then sent again with obstacle_avoidance_send_request_static,
+ * which falls back to JSON, and so are the following requests until the
+ * session is closed. Those are blocking and not pipelined: the submit only
+ * returns once they are answered, and their timeout is not applied.
+ *
+ * When the connection is closed before any answer, the outstanding requests
+ * are sent again the same way, but the next submit opens a binary connection
+ * again: a binary planner which dropped a connection is not downgraded.
+ *
+ * A session is not thread safe, it must only be used by one task.
+ */
+#ifndef OBSTACLE_AVOIDANCE_SESSION_H_
+#define OBSTACLE_AVOIDANCE_SESSION_H_
+
+#include <stdint.h>
+#include <lwip/ip.h>
+#include "obstacle_avoidance_protocol.h"
+#include "obstacle_avoidance_binary.h"
+
+/** Maximum number of outstanding requests on a session. */
+#define OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING 4
+
+/** Status of a request which was not answered yet. lwIP errors are negative. */
+#define OBSTACLE_AVOIDANCE_PENDING 1
+
+typedef struct {
+    int id;                     /**< Request id, -1 if the slot is free. */
+    int status;                 /**< OBSTACLE_AVOIDANCE_PENDING, ERR_OK or an error. */
+    obstacle_avoidance_request_t *request; /**< Kept to send it again in JSON. */
+    obstacle_avoidance_path_t *path;
+    obstacle_avoidance_point_t *points;
+    int max_points;
+    int32_t deadline;           /**< Uptime at which the request times out, in us. */
+} obstacle_avoidance_session_request_t;
+
+typedef struct {
+    struct netconn *conn;       /**< NULL while disconnected. */
+    struct ip_addr remote_ip;
+    int port;
+    uint16_t next_id;
+    int answered;               /**< Set once the connection received something. */
+    int json;                   /**< Set once the planner is known to only speak JSON. */
+
+    obstacle_avoidance_session_request_t requests[OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING];
+
+    /* Answer being received. */
+    uint8_t header[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE];
+    int header_len;
+    uint32_t remaining;         /**< Payload bytes left in the answer. */
+    int current_id;             /**< Id of the answer. */
+    obstacle_avoidance_session_request_t *current; /**< Its request, NULL if skipped. */
+    obstacle_avoidance_binary_decoder_t decoder;
+} obstacle_avoidance_session_t;
+
+/** Inits a session. The connection is only opened by the first request. */
+void obstacle_avoidance_session_init(obstacle_avoidance_session_t *s, struct ip_addr remote_ip, int port);
+
+/** Closes the connection, failing every outstanding request with ERR_CLSD.
+ * The next connection tries the binary encoding again. */
+void obstacle_avoidance_session_close(obstacle_avoidance_session_t *s);
+
+/** Sends a request without waiting for its answer.
+ *
+ * @param [in] request The request. It must stay valid until the request
+ * completes, to be sent again if the planner turns out to only speak JSON.
+ * @param [out] path The path, filled once the request is answered. Its points
+ * point to the given array.
+ * @param [in] points, max_points The array receiving the points. It must stay
+ * valid until the request is waited for or cancelled.
+ * @param [in] timeout_ms Time after which the request fails with ERR_TIMEOUT.
+ * @returns The request id, or a negative lwIP error. ERR_MEM is returned if
+ * there are already OBSTACLE_AVOIDANCE_SESSION_MAX_PENDING outstanding requests.
+ */
+int obstacle_avoidance_session_submit(obstacle_avoidance_session_t *s, obstacle_avoidance_request_t *request,
+                                      obstacle_avoidance_path_t *path,
+                                      obstacle_avoidance_point_t *points, int max_points,
+                                      int timeout_ms);
+
+/** Receives answers until the given request is answered or times out, then
+ * forgets it.
+ *
+ * Answers to the other outstanding requests are decoded meanwhile.
+ *
+ * @returns ERR_OK, ERR_TIMEOUT, ERR_BUF if the path did not fit, ERR_VAL if
+ * the id is unknown or the answer invalid, or a network error.
+ */
+int obstacle_avoidance_session_wait(obstacle_avoidance_session_t *s, int id);
+
+/** Receives the answers available, waiting at most timeout_ms for some,
+ * then fails the requests which timed out.
+ *
+ * Answered requests can then be checked with obstacle_avoidance_session_status.
+ *
+ * @returns ERR_OK, ERR_TIMEOUT if nothing was received, or a network error,
+ * which failed every outstanding request.
+ */
+int obstacle_avoidance_session_poll(obstacle_avoidance_session_t *s, int timeout_ms);
+
+/** Forgets a request, its answer will be skipped. It must be called once a
+ * request completed, unless obstacle_avoidance_session_wait was used. */
+void obstacle_avoidance_session_cancel(obstacle_avoidance_session_t *s, int id);
+
+/** Feeds received bytes to the session, completing the requests answered.
+ *
+ * Only exposed for testing, the bytes are received by obstacle_avoidance_session_wait
+ * and obstacle_avoidance_session_poll.
+ *
+ * @returns ERR_OK, or ERR_VAL if the stream cannot be parsed anymore. If the
+ * first answer of the connection is not binary, the session is also marked
+ * as talking to a JSON planner.
+ */
+int obstacle_avoidance_session_feed(obstacle_avoidance_session_t *s, const uint8_t *data, int len);
+
+/** Fails the outstanding requests whose deadline is past.
+ * @param [in] now The current uptime in us.
+ */
+void obstacle_avoidance_session_check_timeouts(obstacle_avoidance_session_t *s, int32_t now);
+
+/** @returns The status of a request, or ERR_VAL if the id is unknown. */
+int obstacle_avoidance_session_status(obstacle_avoidance_session_t *s, int id);
+
+#endif
@@ -0,0 +1,173 @@
+#include <string.h>
+#include <math.h>
+#include <platform.h>
+#include "path_follower.h"
+#include "trig.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Longitudinal errors decay with a 0.5 s time constant. Lateral errors
+ * behave as a second order system of pulsation vr * sqrt(ky) and damping
+ * ka / (2 * sqrt(ky)), about 0.7 here. */
+#define DEFAULT_KX 2.f
+#define DEFAULT_KY 5e-5f
+#define DEFAULT_KA 1e-2f
+
+void path_follower_init(path_follower_t *f)
+{
+    memset(f, 0, sizeof(path_follower_t));
+    f->kx = DEFAULT_KX;
+    f->ky = DEFAULT_KY;
+    f->ka = DEFAULT_KA;
+}
+
+void path_follower_set_gains(path_follower_t *f, float kx, float ky, float ka)
+{
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+
+    OS_ENTER_CRITICAL();
+#endif
+    f->kx = kx;
+    f->ky = ky;
+    f->ka = ka;
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+void path_follower_start(path_follower_t *f, obstacle_avoidance_path_t *path, int32_t start)
+{
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+
+    OS_ENTER_CRITICAL();
+#endif
+    f->path = *path;
+    f->start = start;
+    f->index = 0;
+    f->active = path->len > 0;
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+void path_follower_stop(path_follower_t *f)
+{
+#ifdef COMPILE_ON_ROBOT
+    OS_CPU_SR cpu_sr;
+
+    OS_ENTER_CRITICAL();
+#endif
+    f->active = 0;
+#ifdef COMPILE_ON_ROBOT
+    OS_EXIT_CRITICAL();
+#endif
+}
+
+int path_follower_is_active(path_follower_t *f)
+{
+    return f->active;
+}
+
+static float wrap_angle(float a)
+{
+    while (a > M_PI)
+        a -= 2 * M_PI;
+    while (a < -M_PI)
+        a += 2 * M_PI;
+    return a;
+}
+
+static float point_speed(obstacle_avoidance_point_t *p)
+{
+    return sqrtf((float)p->vx * p->vx + (float)p->vy * p->vy);
+}
+
+void path_follower_reference(obstacle_avoidance_path_t *path, int *index, float t,
+                             path_follower_reference_t *ref)
+{
+    obstacle_avoidance_point_t *a, *b;
+    float u, dt;
+    int i = *index;
+
+    /* Time only goes forward, so the search starts from the last segment. */
+    if (i < 0 || i >= path->len || t < path->points[i].timestamp)
+        i = 0;
+
+    while (i < path->len - 1 && t >= path->points[i + 1].timestamp)
+        i++;
+
+    *index = i;
+    a = &path->points[i];
+
+    /* Before the start and after the end, the reference does not move. */
+    if (i == path->len - 1 || t < a->timestamp) {
+        ref->x = a->x;
+        ref->y = a->y;
+        ref->vx = ref->vy = ref->w = 0;
+        return;
+    }
+
+    b = &path->points[i + 1];
+    dt = b->timestamp - a->timestamp;
+    u = (t - a->timestamp) / dt;
+
+    ref->x = a->x + u * (b->x - a->x);
+    ref->y = a->y + u * (b->y - a->y);
+    ref->vx = a->vx + u * (b->vx - a->vx);
+    ref->vy = a->vy + u * (b->vy - a->vy);
+
+    /* The heading turns from one point velocity to the next over the segment. */
+    ref->w = 0;
+    if (point_speed(a) > PATH_FOLLOWER_MIN_SPEED && point_speed(b) > PATH_FOLLOWER_MIN_SPEED) {
+        ref->w = wrap_angle(trig_atan2(b->vy, b->vx) - trig_atan2(a->vy, a->vx));
+        ref->w /= dt / 1000.f;
+    }
+}
+
+int path_follower_update(path_follower_t *f, int32_t now, float x, float y, float a, float *v, float *w)
+{
+    path_follower_reference_t ref;
+    obstacle_avoidance_point_t *end;
+    float t, dx, dy, ex, ey, ea, vr, s, c;
+
+    *v = 0;
+    *w = 0;
+
+    if (!f->active)
+        return 0;
+
+    t = (now - f->start) / 1000.f;
+    path_follower_reference(&f->path, &f->index, t, &ref);
+
+    dx = ref.x - x;
+    dy = ref.y - y;
+
+    /* Once the reference stopped, waits for the robot to reach it. */
+    end = &f->path.points[f->path.len - 1];
+    if (t >= end->timestamp) {
+        if (dx * dx + dy * dy < PATH_FOLLOWER_WINDOW * PATH_FOLLOWER_WINDOW
+            || now - f->start - end->timestamp * 1000 > PATH_FOLLOWER_SETTLE_TIME) {
+            f->active = 0;
+            return 0;
+        }
+    }
+
+    /* Error in the robot frame. */
+    trig_sincos(a, &s, &c);
+    ex = c * dx + s * dy;
+    ey = -s * dx + c * dy;
+
+    vr = sqrtf(ref.vx * ref.vx + ref.vy * ref.vy);
+    ea = 0;
+    if (vr > PATH_FOLLOWER_MIN_SPEED)
+        ea = wrap_angle(trig_atan2(ref.vy, ref.vx) - a);
+
+    *v = vr * trig_cos(ea) + f->kx * ex;
+    *w = ref.w + vr * (f->ky * ey + f->ka * trig_sin(ea));
+
+    return 1;
+}
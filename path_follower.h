@@ -0,0 +1,92 @@
+/** @file path_follower.h
+ * @brief Tracks a timed path, such as the ones sent by the path planner.
+ *
+ * Each point of the path tells where the robot should be at a given time, and
+ * at which velocity. The follower interpolates this reference at the current
+ * time, and computes the linear and angular speeds which bring the robot on
+ * it, using the unicycle tracking law of Kanayama et al. :
+ *
+ *     v = vr * cos(ea) + kx * ex
+ *     w = wr + vr * (ky * ey + ka * sin(ea))
+ *
+ * where ex, ey is the position error in the robot frame, ea the heading error,
+ * vr and wr the reference linear and angular speeds.
+ *
+ * The speeds are integrated into the distance and angle consigns at the
+ * control rate, so the robot never stops between points.
+ *
+ * path_follower_update must be called by a task of higher priority than the
+ * ones starting, stopping or tuning the follower, such as the control task.
+ * Those only change the follower with the interrupts disabled, so the update
+ * never sees half of a change, and never waits for a lower priority task.
+ */
+#ifndef PATH_FOLLOWER_H_
+#define PATH_FOLLOWER_H_
+
+#include <stdint.h>
+#include "obstacle_avoidance_protocol.h"
+
+/** The path is done once the robot is this close to its end, in mm. */
+#define PATH_FOLLOWER_WINDOW 20
+
+/** Time given to reach the end of the path after its last timestamp, in us. */
+#define PATH_FOLLOWER_SETTLE_TIME 1000000
+
+/** Below this reference speed, in mm/s, the heading is not tracked. */
+#define PATH_FOLLOWER_MIN_SPEED 10
+
+typedef struct {
+    obstacle_avoidance_path_t path; /**< Its points are not copied. */
+    int32_t start;              /**< Uptime of the path timestamp 0, in us. */
+    int index;                  /**< Segment of the last reference. */
+    int active;
+
+    float kx;                   /**< Gain on the longitudinal error, in 1/s. */
+    float ky;                   /**< Gain on the lateral error, in rad/mm^2. */
+    float ka;                   /**< Gain on the heading error, in rad/mm. */
+} path_follower_t;
+
+/** Reference interpolated along a path. */
+typedef struct {
+    float x, y;                 /**< mm */
+    float vx, vy;               /**< mm/s */
+    float w;                    /**< Angular speed, in rad/s. */
+} path_follower_reference_t;
+
+/** Inits an idle follower with the default gains. */
+void path_follower_init(path_follower_t *f);
+
+/** Sets the tracking gains, see the file description for their meaning. */
+void path_follower_set_gains(path_follower_t *f, float kx, float ky, float ka);
+
+/** Starts following a path, replacing the current one.
+ *
+ * @param [in] path The path, whose points must stay valid until the path is
+ * done, stopped or replaced.
+ * @param [in] start Uptime matching the path timestamp 0, in us.
+ */
+void path_follower_start(path_follower_t *f, obstacle_avoidance_path_t *path, int32_t start);
+
+/** Stops following the path. The consigns are not touched anymore. */
+void path_follower_stop(path_follower_t *f);
+
+/** @returns 1 while a path is followed. */
+int path_follower_is_active(path_follower_t *f);
+
+/** Interpolates the reference of a path at the given time.
+ * @param [in] t Time from the path timestamp 0, in ms.
+ */
+void path_follower_reference(obstacle_avoidance_path_t *path, int *index, float t,
+                             path_follower_reference_t *ref);
+
+/** Computes the speeds to apply, to be called at the control rate.
+ *
+ * @param [in] now Current uptime in us.
+ * @param [in] x, y, a Robot pose, in mm and rad.
+ * @param [out] v, w Linear speed in mm/s and angular speed in rad/s, zero
+ * once the path is done.
+ * @returns 1 while the path is followed, 0 once it is done.
+ */
+int path_follower_update(path_follower_t *f, int32_t now, float x, float y, float a, float *v, float *w);
+
+#endif
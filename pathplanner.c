@@ -0,0 +1,34 @@
+#include <platform.h>
+#include <lwip/ip.h>
+#include "pathplanner.h"
+
+OS_STK    pathplanner_task_stk[2048];
+#define   PATHPLANNER_TASK_PRIORITY 33
+
+/* Path planner server. */
+#define   PATHPLANNER_PORT 1337
+
+obstacle_avoidance_client_t pathplanner;
+
+void pathplanner_manage_task(__attribute__((unused)) void *dummy)
+{
+    while (1)
+        obstacle_avoidance_client_work(&pathplanner);
+}
+
+void pathplanner_init(void)
+{
+    struct ip_addr server;
+
+    IP4_ADDR(&server, 192,168,1,10);
+    obstacle_avoidance_client_init(&pathplanner, server, PATHPLANNER_PORT);
+
+    OSTaskCreateExt(pathplanner_manage_task,
+                    NULL,
+                    &pathplanner_task_stk[2047],
+                    PATHPLANNER_TASK_PRIORITY,
+                    PATHPLANNER_TASK_PRIORITY,
+                    &pathplanner_task_stk[0],
+                    2048, /* stack size */
+                    NULL, NULL);
+}
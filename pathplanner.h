@@ -0,0 +1,12 @@
+#ifndef PATHPLANNER_H_
+#define PATHPLANNER_H_
+
+#include "obstacle_avoidance_client.h"
+
+/** Client of the remote path planner, shared by the strategy and the shell. */
+extern obstacle_avoidance_client_t pathplanner;
+
+/** Inits the client and starts its worker task. Needs the IP stack. */
+void pathplanner_init(void);
+
+#endif
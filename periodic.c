@@ -0,0 +1,94 @@
+#include <platform.h>
+#include <uptime.h>
+#include "periodic.h"
+
+void periodic_init(periodic_t *p, int32_t period)
+{
+    p->period = period;
+    p->next_deadline = uptime_get() + period;
+    p->overruns = 0;
+    p->stats = NULL;
+}
+
+void periodic_set_period(periodic_t *p, int32_t period, int32_t now)
+{
+    if (p->period == 0)
+        p->next_deadline = now;
+    else if (p->next_deadline - now > period)
+        p->next_deadline = now + period;
+
+    p->period = period;
+}
+
+int periodic_is_due(periodic_t *p, int32_t now)
+{
+    if (p->period == 0)
+        return 0;
+
+    /* Difference of dates, so it works when the uptime wraps. */
+    return now - p->next_deadline >= 0;
+}
+
+int32_t periodic_time_left(periodic_t *p, int32_t now)
+{
+    int32_t left;
+
+    if (p->period == 0)
+        return -1;
+
+    left = p->next_deadline - now;
+    return left > 0 ? left : 0;
+}
+
+int periodic_advance(periodic_t *p, int32_t now)
+{
+    if (p->period == 0)
+        return 0;
+
+    p->next_deadline += p->period;
+
+    if (p->next_deadline - now <= 0) {
+        p->overruns++;
+        p->next_deadline = now + p->period;
+        return 1;
+    }
+
+    return 0;
+}
+
+void periodic_wait(periodic_t *p)
+{
+    int32_t now = uptime_get();
+
+    if (p->stats)
+        task_stats_end(p->stats, now);
+
+    periodic_advance(p, now);
+    periodic_sleep_us(periodic_time_left(p, now));
+
+    if (p->stats)
+        task_stats_begin(p->stats, p->next_deadline, uptime_get());
+}
+
+void periodic_set_stats(periodic_t *p, task_stats_t *stats)
+{
+    int32_t now = uptime_get();
+
+    p->stats = stats;
+    task_stats_begin(stats, now, now);
+}
+
+void periodic_sleep_us(int32_t duration)
+{
+#ifdef COMPILE_ON_ROBOT
+    INT32U ticks;
+
+    if (duration <= 0)
+        return;
+
+    ticks = ((INT32U)duration * OS_TICKS_PER_SEC + 999999) / 1000000;
+    OSTimeDly(ticks);
+#else
+    (void)duration;
+#endif
+}
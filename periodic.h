@@ -0,0 +1,75 @@
+/** @file periodic.h
+ * @brief Helper for tasks running at a fixed rate.
+ *
+ * Instead of sleeping a fixed delay after doing their work, which makes the
+ * period drift with the execution time, periodic tasks sleep until an absolute
+ * deadline. Deadlines that are already passed when the task is done are
+ * counted as overruns.
+ *
+ * A typical task looks like :
+ * @code
+ * periodic_t p;
+ * periodic_init(&p, 10000);
+ * while (1) {
+ *     do_something();
+ *     periodic_wait(&p);
+ * }
+ * @endcode
+ */
+#ifndef _PERIODIC_H_
+#define _PERIODIC_H_
+
+#include <stdint.h>
+#include "task_stats.h"
+
+typedef struct {
+    int32_t period;         /**< Period in us, 0 if the task is idle. */
+    int32_t next_deadline;  /**< Date of the next activation, in us since boot. */
+    int32_t overruns;       /**< Number of activations which were late. */
+    task_stats_t *stats;    /**< Optional statistics, updated by periodic_wait. */
+} periodic_t;
+
+/** Inits a periodic timer, the first deadline is one period from now.
+ * @param [in] period The period in us. 0 means the timer is idle.
+ */
+void periodic_init(periodic_t *p, int32_t period);
+
+/** Changes the period.
+ *
+ * If the timer was idle, it is due immediately. Otherwise the next deadline
+ * is brought closer if the new period is shorter.
+ */
+void periodic_set_period(periodic_t *p, int32_t period, int32_t now);
+
+/** Returns non zero if the timer is not idle and its deadline is reached. */
+int periodic_is_due(periodic_t *p, int32_t now);
+
+/** Returns the time left until the next deadline in us, 0 if it is already
+ * passed, or -1 if the timer is idle. */
+int32_t periodic_time_left(periodic_t *p, int32_t now);
+
+/** Moves to the next deadline, once the work of a period is done.
+ *
+ * If the new deadline is already passed, an overrun is counted and the
+ * timer is resynchronized on now, instead of trying to catch up.
+ * @returns 1 if an overrun occured, 0 otherwise.
+ */
+int periodic_advance(periodic_t *p, int32_t now);
+
+/** Advances the timer, then sleeps until the next deadline.
+ *
+ * If stats are attached, the time since the previous wake up is recorded as
+ * the execution time, and the delay between the deadline and the actual wake
+ * up as lateness.
+ */
+void periodic_wait(periodic_t *p);
+
+/** Attaches execution time statistics to a periodic timer.
+ * @note The current activation is considered to start now.
+ */
+void periodic_set_stats(periodic_t *p, task_stats_t *stats);
+
+/** Sleeps for the given time, rounded up to the next OS tick. */
+void periodic_sleep_us(int32_t duration);
+
+#endif
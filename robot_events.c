@@ -0,0 +1,70 @@
+#include <platform.h>
+#include "robot_events.h"
+
+#ifdef COMPILE_ON_ROBOT
+
+static OS_FLAG_GRP *robot_events;
+
+void robot_events_init(void)
+{
+    INT8U err;
+
+    robot_events = OSFlagCreate(0, &err);
+    if (robot_events == NULL)
+        panic();
+}
+
+void robot_events_post(uint32_t events)
+{
+    INT8U err;
+
+    OSFlagPost(robot_events, (OS_FLAGS)events, OS_FLAG_SET, &err);
+}
+
+uint32_t robot_events_wait(uint32_t events, int32_t timeout)
+{
+    INT8U err;
+    INT32U ticks;
+
+    if (timeout == 0)
+        return OSFlagAccept(robot_events, (OS_FLAGS)events, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, &err);
+
+    /* For uC/OS-II a timeout of 0 ticks means forever. */
+    if (timeout == ROBOT_EVENTS_FOREVER) {
+        ticks = 0;
+    } else {
+        ticks = ((INT32U)timeout * OS_TICKS_PER_SEC + 999999) / 1000000;
+        if (ticks > 0xffff)
+            ticks = 0xffff;
+    }
+
+    return OSFlagPend(robot_events, (OS_FLAGS)events, OS_FLAG_WAIT_SET_ANY + OS_FLAG_CONSUME, ticks, &err);
+}
+
+#else
+
+static volatile uint32_t robot_events;
+
+void robot_events_init(void)
+{
+    robot_events = 0;
+}
+
+void robot_events_post(uint32_t events)
+{
+    robot_events |= events;
+}
+
+uint32_t robot_events_wait(uint32_t events, int32_t timeout)
+{
+    uint32_t result;
+
+    (void)timeout;
+
+    result = robot_events & events;
+    robot_events &= ~result;
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/** @file robot_events.h
+ * @brief Events used to wake up the strategy instead of busy waiting.
+ *
+ * The control tasks post events when something the strategy may be waiting
+ * for happens, such as the end of an arm trajectory. The strategy blocks on
+ * them with a timeout, which leaves the CPU to the lower priority tasks
+ * (network, Lua shell) in the meantime.
+ *
+ * Events only tell that a condition may have changed : they can be posted
+ * before the waiter starts waiting, or several times. Waiters must always
+ * check the actual condition after waking up :
+ * @code
+ * while (!arm_is_trajectory_finished(arm))
+ *     robot_events_wait(ROBOT_EVENT_LEFT_ARM_DONE, 100000);
+ * @endcode
+ */
+#ifndef _ROBOT_EVENTS_H_
+#define _ROBOT_EVENTS_H_
+
+#include <stdint.h>
+
+#define ROBOT_EVENT_LEFT_ARM_DONE   0x01 /**< Left arm reached the end of its trajectory. */
+#define ROBOT_EVENT_RIGHT_ARM_DONE  0x02 /**< Right arm reached the end of its trajectory. */
+#define ROBOT_EVENT_TRAJ_END        0x04 /**< The trajectory manager finished. */
+#define ROBOT_EVENT_BLOCKING        0x08 /**< A blocking was detected on the wheels. */
+#define ROBOT_EVENT_POSITION        0x10 /**< The control system ran, the position changed. */
+#define ROBOT_EVENT_STRAT_RESOURCE  0x20 /**< A strategy resource was released. */
+
+/** Timeout value to wait without limit. */
+#define ROBOT_EVENTS_FOREVER -1
+
+/** Creates the event group. Must be called before any other function. */
+void robot_events_init(void);
+
+/** Posts one or several events. Can be called from any task. */
+void robot_events_post(uint32_t events);
+
+/** Waits until at least one of the given events is posted.
+ *
+ * The returned events are cleared, the other ones are left pending.
+ * @param [in] events The events to wait for, OR'd together.
+ * @param [in] timeout The maximum time to wait in us, 0 to only check the
+ * pending events, or ROBOT_EVENTS_FOREVER.
+ * @returns The posted events among the requested ones, 0 on timeout.
+ * @note On the host there is no scheduler to wake us up, so this only
+ * returns the pending events without waiting.
+ */
+uint32_t robot_events_wait(uint32_t events, int32_t timeout);
+
+#endif
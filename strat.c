@@ -7,6 +7,7 @@
 
 #include "strat.h"
 #include "strat_job.h"
+#include "strat_pt.h"
 #include "arm.h"
 #include "arm_trajectories.h"
 #include "strat_utils.h"
@@ -16,6 +17,9 @@
 
 #define FIRE_HEIGHT 30
 
+/** Used to wait for both arms at once. */
+static arm_t *both_arms[] = {&robot.left_arm, &robot.right_arm};
+
 /** Switches from table coordinate to arm coordinate. */
 void strat_block_hand(arm_t *arm, int angle)
 {
@@ -78,7 +82,7 @@ void setup_arm_pos(void)
     arm_trajectory_append_point(&traj, sx, sy, 105, COORDINATE_ARM, .5);
     arm_do_trajectory(arm, &traj);
     arm_trajectory_delete(&traj);
-    while (!arm_trajectory_finished(&arm->trajectory));
+    strat_wait_arm(arm, 0);
     arm_shutdown(arm);
 }
 
@@ -119,7 +123,7 @@ void do_first_fire(void)
     arm_do_trajectory(arm, &traj);
     arm_trajectory_delete(&traj);
 
-    while (!arm_trajectory_finished(&arm->trajectory));
+    strat_wait_arm(arm, 0);
     arm_position_navigation(arm);
 }
 
@@ -148,165 +152,33 @@ void grab_stack(void)
     arm_trajectory_delete(&traj);
 }
 
-void empty_fire_pit(int stack_x, int stack_y)
-{
-    arm_trajectory_t traj;
-    arm_t *arm;
-    float sx, sy, sz;
-    int i;
-    int stack_height = 124;
-
-    if (strat.color == RED)
-        arm = &robot.left_arm;
-    else
-        arm = &robot.right_arm;
-
-    arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
-
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-    arm_trajectory_set_hand_angle(&traj, 90);
-    arm_trajectory_append_point(&traj, sx, sy, 200, COORDINATE_ARM, 1.);
-    arm_trajectory_set_hand_angle(&traj, 0);
-
-    arm_do_trajectory(arm, &traj);
-    arm_trajectory_delete(&traj);
-
-    while (!arm_trajectory_finished(&arm->trajectory));
-
-    //arm->shoulder_mode = SHOULDER_FRONT;
-
-    trajectory_only_a_rel(&robot.traj, COLOR_A(-45));
-    wait_traj_end(TRAJ_FLAGS_STD);
-
-
-    pump_right_bottom(1);
-    pump_right_top(1);
-    pump_left_bottom(1);
-    pump_left_top(1);
-
-    arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-
-    /* First triangle */
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    arm_trajectory_set_hand_angle(&traj, 0);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, stack_height, COORDINATE_TABLE, 1.);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    stack_height -= FIRE_HEIGHT;
-
-    /* Second triangle */
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    arm_trajectory_set_hand_angle(&traj, 180);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, stack_height, COORDINATE_TABLE, 1.);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    stack_height -= FIRE_HEIGHT;
-
-    arm_do_trajectory(arm, &traj);
-    arm_trajectory_delete(&traj);
-    while (!arm_trajectory_finished(&arm->trajectory));
-
-    strat_block_hand(arm, 180);
-
-
-
-    /* Switches arms for second part of movement. */
-    if (arm == &robot.right_arm)
-        arm = &robot.left_arm;
-    else
-        arm = &robot.right_arm;
-
-    trajectory_only_a_rel(&robot.traj, COLOR_A(-45));
-    wait_traj_end(TRAJ_FLAGS_SHORT_DISTANCE);
-
-    arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    arm_trajectory_set_hand_angle(&traj, 180);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, stack_height-2, COORDINATE_TABLE, 1.);
-    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
-    stack_height -= FIRE_HEIGHT;
-    arm_do_trajectory(arm, &traj);
-    arm_trajectory_delete(&traj);
-
-    while (!arm_trajectory_finished(&arm->trajectory));
-    strat_block_hand(arm, 180);
-}
-
-void do_dropzone_corner(void)
-{
-    arm_trajectory_t traj;
-    arm_t *arm;
-    float sx, sy, sz;
-
-    if (strat.color == RED)
-        arm = &robot.left_arm;
-    else
-        arm = &robot.right_arm;
-
-
-    trajectory_turnto_xy(&robot.traj, 0, COLOR_Y(2000));
-    wait_traj_end(END_TRAJ);
-    trajectory_d_rel(&robot.traj, 50);
-
-    arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-    arm_trajectory_set_hand_angle(&traj, 180);
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-    arm_trajectory_append_point(&traj, sx, sy, 80, COORDINATE_ARM, 1.);
-    arm_trajectory_set_hand_angle(&traj, 0);
-    arm_trajectory_append_point(&traj, 100, COLOR_Y(2000-30), 80, COORDINATE_TABLE, 1.);
-    arm_do_trajectory(arm, &traj);
-    arm_trajectory_delete(&traj);
-
-    arm = strat_opposite_arm(arm);
-    arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
-    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
-    arm_trajectory_set_hand_angle(&traj, 180);
-    arm_trajectory_append_point(&traj, sx, sy, 80, COORDINATE_ARM, 1.);
-    arm_trajectory_append_point(&traj, 30, COLOR_Y(2000-100), 80, COORDINATE_TABLE, 1.);
-    arm_do_trajectory(arm, &traj);
-    arm_trajectory_delete(&traj);
-
-    while ((!arm_trajectory_finished(&robot.left_arm.trajectory)) ||
-          (!arm_trajectory_finished(&robot.right_arm.trajectory)));
-
-    if (strat.color == RED) {
-        pump_left_bottom(0);
-        pump_right_top(0);
-    } else {
-        pump_left_top(0);
-        pump_right_bottom(0);
-    }
-}
-
+/** State of the action passing a fire from one arm to the other. */
+struct pass_fire_action {
+    strat_pt_t pt;
+    arm_t *dest;
+    arm_t *src;
+};
 
 /** Pass a fire from src arm to dest.
  *
  * @warning Calling function should make sure the arm is in a safe operating
- * position.
+ * position, and that dest and src are different arms.
  *
  * @note This function sends the fire from bottom to bottom.
  */
-void strat_pass_fire(arm_t *dest, arm_t *src)
+static int action_pass_fire(void *p)
 {
+    struct pass_fire_action *a = p;
     const int delta_z = 110;
     const int src_z = 15;
     arm_trajectory_t traj;
     float sx, sy, sz;
     float dx, dy, dz;
 
-    if (dest == src) {
-        return;
-    }
+    STRAT_PT_BEGIN(&a->pt);
 
     arm_trajectory_init(&traj);
-    arm_get_position(src, &sx, &sy, &sz);
+    arm_get_position(a->src, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, .5);
 
     arm_trajectory_append_point(&traj, sx, sy, 150, COORDINATE_ARM, .5);
@@ -316,83 +188,133 @@ void strat_pass_fire(arm_t *dest, arm_t *src)
 
     arm_trajectory_append_point(&traj, 180, 0, 150, COORDINATE_ROBOT, 2.);
     arm_trajectory_append_point(&traj, 180, 0, src_z, COORDINATE_ROBOT, .5);
-    arm_do_trajectory(src, &traj);
-    while (!arm_trajectory_finished(&src->trajectory)) {}
+    arm_do_trajectory(a->src, &traj);
     arm_trajectory_delete(&traj);
+    STRAT_PT_WAIT_ARM(&a->pt, a->src);
 
-    if (dest == &robot.left_arm) {
+    if (a->dest == &robot.left_arm) {
         pump_left_bottom(1);
     } else {
         pump_right_bottom(1);
     }
 
     arm_trajectory_init(&traj);
-    arm_get_position(dest, &dx, &dy, &dz);
+    arm_get_position(a->dest, &dx, &dy, &dz);
     arm_trajectory_append_point(&traj, dx, dy, dz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, dx, dy, src_z + delta_z + 15, COORDINATE_ARM, .5);
     arm_trajectory_append_point(&traj, 180, 0, src_z + delta_z + 15, COORDINATE_ROBOT, 2.);
     arm_trajectory_append_point(&traj, 180, 0, src_z + delta_z, COORDINATE_ROBOT, .5);
-    arm_do_trajectory(dest, &traj);
-    while (!arm_trajectory_finished(&dest->trajectory)) {}
+    arm_do_trajectory(a->dest, &traj);
     arm_trajectory_delete(&traj);
+    STRAT_PT_WAIT_ARM(&a->pt, a->dest);
 
-    if (src == &robot.left_arm) {
+    if (a->src == &robot.left_arm) {
         pump_left_bottom(0);
     } else {
         pump_right_bottom(0);
     }
 
-    strat_wait_ms(500);
+    STRAT_PT_SLEEP(&a->pt, 500);
 
     arm_trajectory_init(&traj);
-    arm_get_position(dest, &dx, &dy, &dz);
+    arm_get_position(a->dest, &dx, &dy, &dz);
     arm_trajectory_append_point(&traj, dx, dy, dz + 30, COORDINATE_ARM, 1.);
-    arm_do_trajectory(dest, &traj);
-
-    while (!arm_trajectory_finished(&dest->trajectory)) {}
+    arm_do_trajectory(a->dest, &traj);
     arm_trajectory_delete(&traj);
-
+    STRAT_PT_WAIT_ARM(&a->pt, a->dest);
 
     arm_trajectory_init(&traj);
-    arm_get_position(src, &sx, &sy, &sz);
+    arm_get_position(a->src, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, .5);
     arm_trajectory_set_hand_angle(&traj, 180);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, .5);
     arm_trajectory_set_hand_angle(&traj, 0);
-    arm_do_trajectory(src, &traj);
-    while (!arm_trajectory_finished(&src->trajectory)) {}
+    arm_do_trajectory(a->src, &traj);
     arm_trajectory_delete(&traj);
+    STRAT_PT_WAIT_ARM(&a->pt, a->src);
+
+    STRAT_PT_END(&a->pt);
+}
+
+void strat_pass_fire(arm_t *dest, arm_t *src)
+{
+    struct pass_fire_action a;
+
+    if (dest == src) {
+        return;
+    }
+
+    strat_pt_init(&a.pt);
+    a.dest = dest;
+    a.src = src;
+
+    /* Outside of the scheduler nobody sleeps on the events, so we poll. */
+    while (action_pass_fire(&a) != STRAT_JOB_DONE)
+        strat_wait_ms(10);
 }
 
-void exchange_fires(void)
+/** @returns The strategy resource of the given arm. */
+static uint32_t strat_arm_resource(arm_t *arm)
 {
-    arm_trajectory_t traj;
+    if (arm == &robot.left_arm)
+        return STRAT_RESOURCE_LEFT_ARM;
+
+    return STRAT_RESOURCE_RIGHT_ARM;
+}
+
+/** Waits until both arms finished their trajectories. */
+#define STRAT_PT_WAIT_BOTH_ARMS(pt) \
+    STRAT_PT_WAIT_UNTIL(pt, ROBOT_EVENT_LEFT_ARM_DONE | ROBOT_EVENT_RIGHT_ARM_DONE, \
+                        arm_is_trajectory_finished(&robot.left_arm) && \
+                        arm_is_trajectory_finished(&robot.right_arm))
+
+/** State of the fire exchange action. */
+struct exchange_fires_action {
+    strat_pt_t pt;
     arm_t *arm;
-    float sx, sy, sz;
     int ret;
+};
+
+static struct exchange_fires_action exchange_fires;
+
+/** Moves the stack grabbed at the start from one arm to the other, then
+ * drops it in front of the robot. */
+static int action_exchange_fires(void *p)
+{
+    struct exchange_fires_action *a = p;
+    arm_trajectory_t traj;
+    float sx, sy, sz;
+
+    STRAT_PT_BEGIN(&a->pt);
+    STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE);
+
+    strat_set_speed(FAST);
 
     if (strat.color == RED)
-        arm = &robot.left_arm;
+        a->arm = &robot.left_arm;
     else
-        arm = &robot.right_arm;
+        a->arm = &robot.right_arm;
 
     do {
         trajectory_d_rel(&robot.traj, -300);
-        ret = wait_traj_end(TRAJ_FLAGS_STD);
-    } while (!TRAJ_SUCCESS(ret));
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (!TRAJ_SUCCESS(a->ret));
+
+    /* Both arms meet in front of the robot, which must not move meanwhile. */
+    STRAT_PT_NEXT_PHASE(&a->pt, STRAT_RESOURCE_ALL);
 
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, sx, sy, 5, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 200, 0, 5, COORDINATE_ROBOT, 1.);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    arm = strat_opposite_arm(arm);
+    a->arm = strat_opposite_arm(a->arm);
 
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_set_hand_angle(&traj, 180);
     arm_trajectory_append_point(&traj, sx, sy, 135, COORDINATE_ARM, 1.);
@@ -407,7 +329,7 @@ void exchange_fires(void)
     } else {
         arm_trajectory_append_point(&traj, 200, 0, 110, COORDINATE_ROBOT, 1.);
     }
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
     if (strat.color == RED)
@@ -415,8 +337,7 @@ void exchange_fires(void)
     else
         pump_left_bottom(1);
 
-    while ((!arm_trajectory_finished(&robot.left_arm.trajectory)) ||
-          (!arm_trajectory_finished(&robot.right_arm.trajectory)));
+    STRAT_PT_WAIT_BOTH_ARMS(&a->pt);
 
     if (strat.color == RED)
         pump_left_top(0);
@@ -424,162 +345,182 @@ void exchange_fires(void)
         pump_right_top(0);
 
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, sx, sy, 135, COORDINATE_ARM, 1.);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    arm = strat_opposite_arm(arm);
+    a->arm = strat_opposite_arm(a->arm);
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 200, 0, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 200, 0, 160, COORDINATE_ARM, 1.);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    while (!arm_trajectory_finished(&arm->trajectory));
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
-    arm = strat_opposite_arm(arm);
+    a->arm = strat_opposite_arm(a->arm);
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, sx, sy, 30+30+15, COORDINATE_ARM, .5);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
-    while (!arm_trajectory_finished(&arm->trajectory));
-    trajectory_d_rel( &robot.traj, 300);
-    wait_traj_end(END_TRAJ);
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
+
+    trajectory_d_rel(&robot.traj, 300);
+    STRAT_PT_WAIT_TRAJ(&a->pt, END_TRAJ, a->ret);
 
     pump_left_bottom(0);
     pump_right_bottom(0);
-    strat_wait_ms(400);
+    STRAT_PT_SLEEP(&a->pt, 400);
+
+    /* The fires are dropped, only backing off is left. */
+    strat_pt_release(&a->pt, STRAT_RESOURCE_LEFT_ARM | STRAT_RESOURCE_RIGHT_ARM);
 
-    trajectory_d_rel( &robot.traj, -100);
-    wait_traj_end(TRAJ_FLAGS_STD);
+    trajectory_d_rel(&robot.traj, -100);
+    STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+
+    STRAT_PT_END(&a->pt);
 }
 
-void do_fire_middle_table(void)
+/** State of the middle table fire action. */
+struct fire_middle_table_action {
+    strat_pt_t pt;
+    arm_t *arm;
+    int ret;
+    struct pass_fire_action pass_fire;
+};
+
+static struct fire_middle_table_action fire_middle_table;
+
+/** Takes the fires in the middle of the table and brings them back. */
+static int action_fire_middle_table(void *p)
 {
+    struct fire_middle_table_action *a = p;
     arm_trajectory_t traj;
-    arm_t *arm;
     float sx, sy, sz;
-
     const int arm_x = 135;
-    int ret;
-
 
-
-    do {
-        trajectory_goto_backward_xy_abs(&robot.traj, 900, COLOR_Y(1400));
-        ret = wait_traj_end(TRAJ_FLAGS_STD);
-    } while (!TRAJ_SUCCESS(ret));
+    STRAT_PT_BEGIN(&a->pt);
 
     if (strat.color == RED) {
-        arm = &robot.left_arm;
+        a->arm = &robot.left_arm;
     } else {
-        arm = &robot.right_arm;
+        a->arm = &robot.right_arm;
     }
 
+    /* Only this arm moves until the robot reaches the fires. */
+    STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE | strat_arm_resource(a->arm));
+
+    strat_set_speed(FAST);
+
+    do {
+        trajectory_goto_backward_xy_abs(&robot.traj, 900, COLOR_Y(1400));
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (!TRAJ_SUCCESS(a->ret));
+
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 1000, COLOR_Y(1600), 150, COORDINATE_TABLE, .5);
     arm_trajectory_append_point(&traj, 1000, COLOR_Y(1600), 70, COORDINATE_TABLE, .5);
     arm_trajectory_append_point(&traj, 800, COLOR_Y(1600), 70, COORDINATE_TABLE, .5);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    while (!arm_trajectory_finished(&arm->trajectory));
-
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
     do {
         trajectory_goto_xy_abs(&robot.traj, 1500, COLOR_Y(1600));
-        ret = wait_traj_end(TRAJ_FLAGS_STD);
-    } while (!TRAJ_SUCCESS(ret));
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (!TRAJ_SUCCESS(a->ret));
+
+    STRAT_PT_NEXT_PHASE(&a->pt, STRAT_RESOURCE_ALL);
 
     pump_left_bottom(1);
     pump_left_top(1);
     pump_right_bottom(1);
     pump_right_top(1);
 
-    arm = &robot.left_arm;
+    a->arm = &robot.left_arm;
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, -arm_x, 200, sz, COORDINATE_ROBOT, .5);
     arm_trajectory_set_hand_angle(&traj, 90);
     arm_trajectory_append_point(&traj, -arm_x, 200, 20, COORDINATE_ROBOT, 1.);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    arm = &robot.right_arm;
+    a->arm = &robot.right_arm;
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, -arm_x, -200, sz, COORDINATE_ROBOT, .5);
     arm_trajectory_set_hand_angle(&traj, 90);
     arm_trajectory_append_point(&traj, -arm_x, -200, 20, COORDINATE_ROBOT, 1.);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
     do {
         trajectory_turnto_xy_behind(&robot.traj, 1500, COLOR_Y(2000));
-        ret = wait_traj_end(TRAJ_FLAGS_STD);
-    } while (!TRAJ_SUCCESS(ret));
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (!TRAJ_SUCCESS(a->ret));
 
     trajectory_goto_backward_xy_abs(&robot.traj, 1500, COLOR_Y(2000-arm_x-38));
-    wait_traj_end(END_TRAJ|END_BLOCKING);
+    STRAT_PT_WAIT_TRAJ(&a->pt, END_TRAJ|END_BLOCKING, a->ret);
 
-    strat_wait_ms(500);
+    STRAT_PT_SLEEP(&a->pt, 500);
 
-    arm = &robot.left_arm;
+    a->arm = &robot.left_arm;
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_set_hand_angle(&traj, 90);
     arm_trajectory_append_point(&traj, sx, sy, sz+10, COORDINATE_ARM, .1);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    arm = &robot.left_arm;
+    a->arm = &robot.left_arm;
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
     arm_trajectory_set_hand_angle(&traj, 90);
     arm_trajectory_append_point(&traj, sx, sy, sz+10, COORDINATE_ARM, .1);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
     trajectory_d_rel(&robot.traj, 200);
-    wait_traj_end(TRAJ_FLAGS_STD);
+    STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
 
     if (strat.color == RED)
-        arm = &robot.left_arm;
+        a->arm = &robot.left_arm;
     else
-        arm = &robot.right_arm;
+        a->arm = &robot.right_arm;
 
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, .5);
     arm_trajectory_set_hand_angle(&traj, 90);
     arm_trajectory_append_point(&traj, sx, sy, 75, COORDINATE_ARM, .5);
     arm_trajectory_set_hand_angle(&traj, 0);
     arm_trajectory_append_point(&traj, 120, 0, 75, COORDINATE_ARM, .5);
     arm_trajectory_append_point(&traj, 200, 0, 75, COORDINATE_ROBOT, .5);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-
     do {
         trajectory_goto_forward_xy_abs(&robot.traj, 1500,COLOR_Y(1000+150+200));
-        wait_traj_end(TRAJ_FLAGS_STD);
-    } while (ret != END_BLOCKING && ret != END_TRAJ);
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (a->ret != END_BLOCKING && a->ret != END_TRAJ);
 
-    while (!arm_trajectory_finished(&arm->trajectory)) {}
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
-    if (arm == &robot.left_arm) {
+    if (a->arm == &robot.left_arm) {
         pump_left_bottom(0);
         pump_left_top(0);
     } else {
@@ -587,19 +528,19 @@ void do_fire_middle_table(void)
         pump_right_top(0);
     }
 
-    OSTimeDlyHMSM(0,0,1,0);
+    STRAT_PT_SLEEP(&a->pt, 1000);
 
     do {
         trajectory_goto_xy_abs(&robot.traj, 1500,COLOR_Y(1500));
-        wait_traj_end(TRAJ_FLAGS_STD);
-    } while (ret != END_BLOCKING && ret != END_TRAJ);
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (a->ret != END_BLOCKING && a->ret != END_TRAJ);
 
-    arm_position_navigation(arm);
-    while (!arm_trajectory_finished(&arm->trajectory)) {}
+    arm_position_navigation(a->arm);
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
-    arm = strat_opposite_arm(arm);
-    arm_get_position(arm, &sx, &sy, &sz);
-    arm_get_position(arm, &sx, &sy, &sz);
+    a->arm = strat_opposite_arm(a->arm);
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, .5);
     arm_trajectory_set_hand_angle(&traj, 90);
 
@@ -607,35 +548,196 @@ void do_fire_middle_table(void)
     arm_trajectory_append_point(&traj, sx, sy, 120, COORDINATE_ARM, 1.);
     arm_trajectory_set_hand_angle(&traj, 0);
 
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    while (!arm_trajectory_finished(&arm->trajectory)) {}
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
-    strat_pass_fire(strat_opposite_arm(arm), arm);
-    arm_position_navigation(arm);
-    while (!arm_trajectory_finished(&arm->trajectory)) {}
+    a->pass_fire.dest = strat_opposite_arm(a->arm);
+    a->pass_fire.src = a->arm;
+    STRAT_PT_SPAWN(&a->pt, &a->pass_fire.pt, action_pass_fire(&a->pass_fire));
+
+    arm_position_navigation(a->arm);
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
 
-    arm = strat_opposite_arm(arm);
+    a->arm = strat_opposite_arm(a->arm);
 
     arm_trajectory_init(&traj);
-    arm_get_position(arm, &sx, &sy, &sz);
+    arm_get_position(a->arm, &sx, &sy, &sz);
     arm_trajectory_append_point(&traj, 200, 0, 75, COORDINATE_ROBOT, .5);
-    arm_do_trajectory(arm, &traj);
+    arm_do_trajectory(a->arm, &traj);
     arm_trajectory_delete(&traj);
 
-    while (!arm_trajectory_finished(&arm->trajectory)) {}
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
+
+    /* The other arm is stowed and empty, only the one holding the fires is
+     * still needed. */
+    strat_pt_release(&a->pt, strat_arm_resource(strat_opposite_arm(a->arm)));
 
     do {
         trajectory_goto_xy_abs(&robot.traj, 1500,COLOR_Y(1000+150+200));
-        wait_traj_end(TRAJ_FLAGS_STD);
-    } while (ret != END_BLOCKING && ret != END_TRAJ);
+        STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+    } while (a->ret != END_BLOCKING && a->ret != END_TRAJ);
 
     pump_left_bottom(0);
     pump_left_top(0);
     pump_right_bottom(0);
     pump_right_top(0);
 
+    STRAT_PT_END(&a->pt);
+}
+
+/** State of the fire pit action. */
+struct fire_pit_action {
+    strat_pt_t pt;
+    arm_t *arm;
+    int stack_height;
+    int ret;
+};
+
+static struct fire_pit_action fire_pit;
+
+/** Empties the fire pit near the start and drops the fires in the corner.
+ *
+ * The arm is raised while the robot drives to the fire pit, instead of once
+ * it arrived.
+ */
+static int action_fire_pit(void *p)
+{
+    struct fire_pit_action *a = p;
+    arm_trajectory_t traj;
+    float sx, sy, sz;
+    const int stack_x = 430;
+    const int stack_y = COLOR_Y(2000 - 160);
+
+    STRAT_PT_BEGIN(&a->pt);
+
+    if (strat.color == RED)
+        a->arm = &robot.left_arm;
+    else
+        a->arm = &robot.right_arm;
+
+    STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE | strat_arm_resource(a->arm));
+
+    a->stack_height = 124;
+
+    strat_set_speed(SLOW);
+
+    trajectory_only_a_abs(&robot.traj, COLOR_A(80));
+    STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+    arm_trajectory_set_hand_angle(&traj, 90);
+    arm_trajectory_append_point(&traj, sx, sy, 200, COORDINATE_ARM, 1.);
+    arm_trajectory_set_hand_angle(&traj, 0);
+    arm_do_trajectory(a->arm, &traj);
+    arm_trajectory_delete(&traj);
+
+    do {
+        trajectory_goto_forward_xy_abs(&robot.traj, 300, COLOR_Y(1700));
+        STRAT_PT_WAIT_TRAJ(&a->pt, END_TRAJ | END_OBSTACLE, a->ret);
+    } while (!TRAJ_SUCCESS(a->ret));
+
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
+
+    strat_set_speed(FUCKING_SLOW);
+
+    trajectory_only_a_rel(&robot.traj, COLOR_A(-45));
+    STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+
+    pump_right_bottom(1);
+    pump_right_top(1);
+    pump_left_bottom(1);
+    pump_left_top(1);
+
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+
+    /* First triangle */
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    arm_trajectory_set_hand_angle(&traj, 0);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, a->stack_height, COORDINATE_TABLE, 1.);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    a->stack_height -= FIRE_HEIGHT;
+
+    /* Second triangle */
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    arm_trajectory_set_hand_angle(&traj, 180);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, a->stack_height, COORDINATE_TABLE, 1.);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    a->stack_height -= FIRE_HEIGHT;
+
+    arm_do_trajectory(a->arm, &traj);
+    arm_trajectory_delete(&traj);
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
+
+    strat_block_hand(a->arm, 180);
+
+    /* Switches arms for second part of movement. */
+    a->arm = strat_opposite_arm(a->arm);
+    STRAT_PT_NEXT_PHASE(&a->pt, STRAT_RESOURCE_BASE | strat_arm_resource(a->arm));
+
+    trajectory_only_a_rel(&robot.traj, COLOR_A(-45));
+    STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_SHORT_DISTANCE, a->ret);
+
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    arm_trajectory_set_hand_angle(&traj, 180);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, a->stack_height-2, COORDINATE_TABLE, 1.);
+    arm_trajectory_append_point(&traj, stack_x, stack_y, 180, COORDINATE_TABLE, 1.);
+    a->stack_height -= FIRE_HEIGHT;
+    arm_do_trajectory(a->arm, &traj);
+    arm_trajectory_delete(&traj);
+
+    STRAT_PT_WAIT_ARM(&a->pt, a->arm);
+    strat_block_hand(a->arm, 180);
+
+    /* Drops the fires in the corner. */
+    a->arm = strat_opposite_arm(a->arm);
+    STRAT_PT_NEXT_PHASE(&a->pt, STRAT_RESOURCE_ALL);
+
+    trajectory_turnto_xy(&robot.traj, 0, COLOR_Y(2000));
+    STRAT_PT_WAIT_TRAJ(&a->pt, END_TRAJ, a->ret);
+    trajectory_d_rel(&robot.traj, 50);
+
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+    arm_trajectory_set_hand_angle(&traj, 180);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, sx, sy, 80, COORDINATE_ARM, 1.);
+    arm_trajectory_set_hand_angle(&traj, 0);
+    arm_trajectory_append_point(&traj, 100, COLOR_Y(2000-30), 80, COORDINATE_TABLE, 1.);
+    arm_do_trajectory(a->arm, &traj);
+    arm_trajectory_delete(&traj);
+
+    a->arm = strat_opposite_arm(a->arm);
+    arm_trajectory_init(&traj);
+    arm_get_position(a->arm, &sx, &sy, &sz);
+    arm_trajectory_append_point(&traj, sx, sy, sz, COORDINATE_ARM, 1.);
+    arm_trajectory_set_hand_angle(&traj, 180);
+    arm_trajectory_append_point(&traj, sx, sy, 80, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 30, COLOR_Y(2000-100), 80, COORDINATE_TABLE, 1.);
+    arm_do_trajectory(a->arm, &traj);
+    arm_trajectory_delete(&traj);
+
+    STRAT_PT_WAIT_BOTH_ARMS(&a->pt);
+
+    if (strat.color == RED) {
+        pump_left_bottom(0);
+        pump_right_top(0);
+    } else {
+        pump_left_top(0);
+        pump_right_bottom(0);
+    }
+
+    STRAT_PT_END(&a->pt);
 }
 
 void strat_begin(void)
@@ -656,7 +758,8 @@ void strat_begin(void)
 
     trajectory_goto_forward_xy_abs(&robot.traj, 690, COLOR_Y(1050));
     while (position_get_x_float(&robot.pos) < 500) {
-        test_traj_end(TRAJ_FLAGS_STD);
+        /* Leaves the CPU to other tasks until the next position update. */
+        wait_traj_end_timeout(TRAJ_FLAGS_STD, 1000 / ASSERV_FREQUENCY);
         trajectory_goto_forward_xy_abs(&robot.traj, 690, COLOR_Y(1050));
     }
 
@@ -667,29 +770,25 @@ void strat_begin(void)
         ret = wait_traj_end(TRAJ_FLAGS_STD);
     } while (!TRAJ_SUCCESS(ret));
 
-    strat_set_speed(SLOW);
-
-    trajectory_only_a_abs(&robot.traj, COLOR_A(80));
-    wait_traj_end(TRAJ_FLAGS_STD);
-
-    do {
-        trajectory_goto_forward_xy_abs(&robot.traj, 300, COLOR_Y(1700));
-        ret = wait_traj_end(END_TRAJ |END_OBSTACLE);
-    } while (!TRAJ_SUCCESS(ret));
-
-    strat_set_speed(FUCKING_SLOW);
-    empty_fire_pit(430, COLOR_Y(2000 - 160));
-    do_dropzone_corner();
-
-    strat_set_speed(FAST);
-    exchange_fires();
-
-    do_fire_middle_table();
+    /* The priorities keep the order in which the actions were tested : the
+     * exchange backs off from where the fire pit left the robot, and empties
+     * the arm the middle table action uses. The scores cannot express this.
+     * Durations and scores are estimates from the test runs, the deadlines
+     * drop the actions which would not be finished before the end of the
+     * match. */
+    strat_job_reset();
+    strat_pt_init(&fire_pit.pt);
+    strat_pt_init(&exchange_fires.pt);
+    strat_pt_init(&fire_middle_table.pt);
+    strat_schedule_job_ext(action_fire_pit, &fire_pit, 3, 0, 25, 6);
+    strat_schedule_job_ext(action_exchange_fires, &exchange_fires, 2, 0, 10, 0);
+    strat_schedule_job_ext(action_fire_middle_table, &fire_middle_table, 1, 0, 30, 4);
+    strat_do_jobs();
 
     arm_position_navigation(&robot.left_arm);
     arm_position_navigation(&robot.right_arm);
 
-    while (!arm_trajectory_finished(&robot.left_arm.trajectory));
+    strat_wait_arm(&robot.left_arm, 0);
 
     trajectory_only_a_rel(&robot.traj, 180);
     wait_traj_end(TRAJ_FLAGS_SHORT_DISTANCE);
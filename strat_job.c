@@ -1,48 +1,184 @@
-#include <platform.h>
-#include <stdlib.h>
-#include "strat_job.h"
-#include <platform.h>
-#include <aversive/error.h>
-
-struct strat_job {
-    int (*f)(void *);
-    void *param;
-    int active;
-};
-
-struct strat_job *jobs = NULL;
-int job_count = 0;
-int active_count = 0;
-
-void strat_schedule_job(void (*f)(void *), void *param) {
-
-    job_count++;
-    active_count++;
-    jobs = realloc(jobs, job_count * sizeof(struct strat_job));
-
-    if(jobs == NULL)
-        panic();
-
-    jobs[job_count-1].f = f;
-    jobs[job_count-1].param = param;
-}
-
-int strat_job_pool_is_empty(void) {
-    return active_count == 0;
-}
-
-void strat_do_jobs(void) { 
-    int i=0;
-    while(!strat_job_pool_is_empty()) {
-        if(jobs[i].active)
-            if(jobs[i].f(jobs[i].param)==0) {
-                jobs[i].active = 0;
-                active_count--;
-            }
-
-        i++;
-        if(i>=job_count)
-            i = 0;
-    }
-}
-
+#include <platform.h>
+#include <string.h>
+#include <aversive/error.h>
+#include "strat_job.h"
+#include "strat_utils.h"
+#include "robot_events.h"
+
+/** Maximum time the scheduler sleeps before rechecking waiting jobs, in us. */
+#define STRAT_JOB_POLL_PERIOD 100000
+
+struct strat_job {
+    strat_job_f f;
+    void *param;
+    int priority;
+    int deadline;
+    int duration;
+    int score;
+    int active;
+    int started;
+    uint32_t wait_events;   /**< Events the job waits for, 0 if it is runnable. */
+};
+
+static struct strat_job jobs[STRAT_JOB_MAX];
+
+/** Job being run, used by strat_job_wait_for. */
+static struct strat_job *current_job;
+
+void strat_job_reset(void)
+{
+    memset(jobs, 0, sizeof(jobs));
+    current_job = NULL;
+}
+
+int strat_schedule_job(strat_job_f f, void *param)
+{
+    return strat_schedule_job_ext(f, param, 0, 0, 0, 0);
+}
+
+int strat_schedule_job_ext(strat_job_f f, void *param, int priority,
+                           int deadline, int duration, int score)
+{
+    int i;
+
+    for (i = 0; i < STRAT_JOB_MAX; i++) {
+        if (!jobs[i].active)
+            break;
+    }
+
+    if (i == STRAT_JOB_MAX) {
+        WARNING(0, "Job pool is full.");
+        return -1;
+    }
+
+    jobs[i].f = f;
+    jobs[i].param = param;
+    jobs[i].priority = priority;
+    jobs[i].deadline = deadline > 0 ? deadline : MATCH_TIME;
+    jobs[i].duration = duration;
+    jobs[i].score = score;
+    jobs[i].wait_events = 0;
+    jobs[i].started = 0;
+    jobs[i].active = 1;
+
+    return i;
+}
+
+void strat_cancel_job(int id)
+{
+    if (id >= 0 && id < STRAT_JOB_MAX)
+        jobs[id].active = 0;
+}
+
+void strat_job_wait_for(uint32_t events)
+{
+    if (current_job != NULL)
+        current_job->wait_events = events;
+}
+
+int strat_job_pool_is_empty(void)
+{
+    int i;
+
+    for (i = 0; i < STRAT_JOB_MAX; i++) {
+        if (jobs[i].active)
+            return 0;
+    }
+
+    return 1;
+}
+
+/** Returns non zero if job a should run before job b. */
+static int strat_job_is_better(struct strat_job *a, struct strat_job *b)
+{
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+
+    if (a->score != b->score)
+        return a->score > b->score;
+
+    return a->deadline < b->deadline;
+}
+
+/** Drops the jobs which cannot finish in time, and returns the best
+ * runnable one, or -1. */
+static int strat_job_pick(int now)
+{
+    int i, best = -1;
+
+    for (i = 0; i < STRAT_JOB_MAX; i++) {
+        if (!jobs[i].active)
+            continue;
+
+        if (!jobs[i].started && now + jobs[i].duration > jobs[i].deadline) {
+            NOTICE(0, "Dropping job %d, it cannot finish in time.", i);
+            jobs[i].active = 0;
+            continue;
+        }
+
+        if (jobs[i].wait_events)
+            continue;
+
+        if (best < 0 || strat_job_is_better(&jobs[i], &jobs[best]))
+            best = i;
+    }
+
+    return best;
+}
+
+/** Sleeps until one of the waiting jobs gets an event, then makes it
+ * runnable again. */
+static void strat_job_sleep(void)
+{
+    uint32_t events = 0;
+    int i;
+
+    for (i = 0; i < STRAT_JOB_MAX; i++) {
+        if (jobs[i].active)
+            events |= jobs[i].wait_events;
+    }
+
+    if (events == 0)
+        return;
+
+    events = robot_events_wait(events, STRAT_JOB_POLL_PERIOD);
+
+    /* On timeout everybody rechecks its condition, in case an event was
+     * consumed by someone else. */
+    for (i = 0; i < STRAT_JOB_MAX; i++) {
+        if (events == 0 || (jobs[i].wait_events & events))
+            jobs[i].wait_events = 0;
+    }
+}
+
+int strat_job_step(int now)
+{
+    struct strat_job *job;
+    int id, ret;
+
+    id = strat_job_pick(now);
+
+    if (id < 0) {
+        strat_job_sleep();
+        return -1;
+    }
+
+    job = &jobs[id];
+    current_job = job;
+    job->started = 1;
+    ret = job->f(job->param);
+    current_job = NULL;
+
+    if (ret == STRAT_JOB_DONE)
+        job->active = 0;
+    else if (ret != STRAT_JOB_WAIT)
+        job->wait_events = 0;
+
+    return id;
+}
+
+void strat_do_jobs(void)
+{
+    while (!strat_job_pool_is_empty() && strat_get_time() < MATCH_TIME)
+        strat_job_step(strat_get_time());
+}
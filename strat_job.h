@@ -1,15 +1,74 @@
-#ifndef _STRAT_JOB_H_
-#define _STRAT_JOB_H_
-
-#include "strat.h"
-#include <aversive/queue.h>
-
-/** Run all the jobs from the pool, until the pool is empty. */
-void strat_do_jobs(void);
-
-/** Adds a job to the pool. */
-void strat_schedule_job(void (*f)(void *), void *param);
-
-/** @returns 1 if the job pool is empty. */
-int strat_job_pool_is_empty(void);
-#endif
+/** @file strat_job.h
+ * @brief Cooperative scheduler for the strategy actions.
+ *
+ * A job is a function called repeatedly by the strategy task until it
+ * reports it is done. Each time, the scheduler runs the most valuable job
+ * that can still be finished before its deadline :
+ *  - highest priority first,
+ *  - then highest expected score,
+ *  - then earliest deadline.
+ *
+ * Jobs which cannot finish in time anymore are dropped, unless they already
+ * started since they may own resources. When every job is waiting for an
+ * event, the strategy task sleeps until one of them is posted, see
+ * robot_events.h.
+ */
+#ifndef _STRAT_JOB_H_
+#define _STRAT_JOB_H_
+
+#include <stdint.h>
+#include "strat.h"
+
+/** Maximum number of jobs in the pool. */
+#define STRAT_JOB_MAX 16
+
+/* Return values of the job functions. */
+#define STRAT_JOB_DONE  0 /**< The job is finished and removed from the pool. */
+#define STRAT_JOB_AGAIN 1 /**< The job must be called again. */
+#define STRAT_JOB_WAIT  2 /**< The job waits for the events given to strat_job_wait_for(). */
+
+/** A job function, returns one of the STRAT_JOB_* values. */
+typedef int (*strat_job_f)(void *param);
+
+/** Removes all jobs from the pool. */
+void strat_job_reset(void);
+
+/** Adds a job to the pool, with no priority, score or deadline.
+ * @returns The job id, or -1 if the pool is full.
+ */
+int strat_schedule_job(strat_job_f f, void *param);
+
+/** Adds a job to the pool.
+ *
+ * @param [in] f, param The function to call and its argument.
+ * @param [in] priority Jobs with a higher priority always run first.
+ * @param [in] deadline Match time in s at which the job must be finished,
+ * 0 for the end of the match.
+ * @param [in] duration Expected time in s needed to finish the job.
+ * @param [in] score Expected number of points scored by the job.
+ * @returns The job id, or -1 if the pool is full.
+ */
+int strat_schedule_job_ext(strat_job_f f, void *param, int priority,
+                           int deadline, int duration, int score);
+
+/** Removes a job from the pool. */
+void strat_cancel_job(int id);
+
+/** Called by a job before returning STRAT_JOB_WAIT, to tell which events
+ * wake it up. */
+void strat_job_wait_for(uint32_t events);
+
+/** @returns 1 if the job pool is empty. */
+int strat_job_pool_is_empty(void);
+
+/** Runs the best job once, or sleeps if all jobs are waiting.
+ *
+ * @param [in] now The match time in s.
+ * @returns The id of the job which ran, or -1 if none could run.
+ */
+int strat_job_step(int now);
+
+/** Runs the jobs until the pool is empty or the match is over. */
+void strat_do_jobs(void);
+
+#endif
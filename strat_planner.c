@@ -0,0 +1,446 @@
+#include <string.h>
+#include "strat_planner.h"
+
+#define MAX_STATIC_NODES 64
+#define MAX_OPPONENT_NODES (STRAT_PLANNER_MAX_OPPONENTS * 4)
+#define MAX_NODES (MAX_STATIC_NODES + MAX_OPPONENT_NODES + 2)
+#define MAX_POLYGONS (STRAT_PLANNER_MAX_STATIC + STRAT_PLANNER_MAX_OPPONENTS)
+
+/** Default bounding box, bigger than the table. */
+#define NO_LIMIT 100000
+
+typedef struct {
+    strat_planner_point_t points[STRAT_PLANNER_POLYGON_POINTS];
+    int count;
+} planner_polygon_t;
+
+static struct {
+    /* Static polygons come first, then the opponents. */
+    planner_polygon_t polygons[MAX_POLYGONS];
+    int static_count;
+    int opponent_active[STRAT_PLANNER_MAX_OPPONENTS];
+    strat_planner_point_t opponent_center[STRAT_PLANNER_MAX_OPPONENTS];
+
+    strat_planner_point_t box_min, box_max;
+
+    /* Nodes of the graph : static vertices, opponent vertices, start, goal. */
+    strat_planner_point_t nodes[MAX_NODES];
+    int static_node_count;
+
+    /* Visibility between static nodes, ignoring the opponents. */
+    int static_ready;
+    uint64_t static_visible[MAX_STATIC_NODES];
+
+    /* Previous path, start excluded. */
+    strat_planner_point_t goal;
+    strat_planner_point_t path[STRAT_PLANNER_MAX_PATH];
+    int path_len;
+
+    strat_planner_stats_t stats;
+} planner;
+
+static int32_t cross(strat_planner_point_t a, strat_planner_point_t b, strat_planner_point_t c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static int point_equal(strat_planner_point_t a, strat_planner_point_t b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+/** Integer square root, rounded down. */
+static uint32_t isqrt(uint32_t x)
+{
+    uint32_t result = 0, bit = 1UL << 30;
+
+    while (bit > x)
+        bit >>= 2;
+
+    while (bit) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return result;
+}
+
+static int32_t distance(strat_planner_point_t a, strat_planner_point_t b)
+{
+    int32_t dx = b.x - a.x, dy = b.y - a.y;
+    return isqrt(dx * dx + dy * dy);
+}
+
+static int point_strictly_inside(planner_polygon_t *p, strat_planner_point_t a)
+{
+    int i;
+
+    for (i = 0; i < p->count; i++) {
+        if (cross(p->points[i], p->points[(i + 1) % p->count], a) <= 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+/** Returns non zero if the segment crosses the interior of the polygon.
+ *
+ * The polygon is counter clockwise, so its interior is on the left of every
+ * edge. Each edge bounds the part of the segment inside the polygon, as in
+ * the Cyrus-Beck clipping. Touching a vertex or following an edge is allowed.
+ */
+static int segment_blocked_by(planner_polygon_t *p, strat_planner_point_t a, strat_planner_point_t b)
+{
+    /* Bounds of the parameter along the segment, as fractions. */
+    int64_t low_num = 0, low_den = 1, high_num = 1, high_den = 1;
+    int32_t c0, c1;
+    int i;
+
+    for (i = 0; i < p->count; i++) {
+        c0 = cross(p->points[i], p->points[(i + 1) % p->count], a);
+        c1 = cross(p->points[i], p->points[(i + 1) % p->count], b);
+
+        /* The segment is inside this edge for c0 + t * (c1 - c0) > 0. */
+        if (c0 == c1) {
+            if (c0 <= 0)
+                return 0;
+        } else if (c1 > c0) {
+            /* t > -c0 / (c1 - c0) */
+            if (-(int64_t)c0 * low_den > low_num * (c1 - c0)) {
+                low_num = -c0;
+                low_den = c1 - c0;
+            }
+        } else {
+            /* t < c0 / (c0 - c1) */
+            if ((int64_t)c0 * high_den < high_num * (c0 - c1)) {
+                high_num = c0;
+                high_den = c0 - c1;
+            }
+        }
+    }
+
+    return low_num * high_den < high_num * low_den;
+}
+
+/** Checks a segment against polygons, except the ones in the ignore mask. */
+static int segment_blocked(int first, int last, uint32_t ignore,
+                           strat_planner_point_t a, strat_planner_point_t b)
+{
+    int i;
+
+    for (i = first; i < last; i++) {
+        if (planner.polygons[i].count == 0 || (ignore & (1UL << i)))
+            continue;
+
+        if (segment_blocked_by(&planner.polygons[i], a, b))
+            return 1;
+    }
+
+    return 0;
+}
+
+static int point_valid(strat_planner_point_t a, int first, int last)
+{
+    int i;
+
+    if (a.x < planner.box_min.x || a.x > planner.box_max.x ||
+        a.y < planner.box_min.y || a.y > planner.box_max.y)
+        return 0;
+
+    for (i = first; i < last; i++) {
+        if (planner.polygons[i].count && point_strictly_inside(&planner.polygons[i], a))
+            return 0;
+    }
+
+    return 1;
+}
+
+void strat_planner_init(void)
+{
+    memset(&planner, 0, sizeof(planner));
+    strat_planner_set_bounding_box(-NO_LIMIT, -NO_LIMIT, NO_LIMIT, NO_LIMIT);
+}
+
+void strat_planner_set_bounding_box(int32_t x_min, int32_t y_min, int32_t x_max, int32_t y_max)
+{
+    planner.box_min.x = x_min;
+    planner.box_min.y = y_min;
+    planner.box_max.x = x_max;
+    planner.box_max.y = y_max;
+    planner.static_ready = 0;
+    planner.path_len = 0;
+}
+
+int strat_planner_add_static_polygon(const strat_planner_point_t *points, int count)
+{
+    planner_polygon_t *p;
+    int64_t area = 0;
+    int i;
+
+    if (planner.static_count >= STRAT_PLANNER_MAX_STATIC || count > STRAT_PLANNER_POLYGON_POINTS)
+        return -1;
+
+    if (planner.static_node_count + count > MAX_STATIC_NODES)
+        return -1;
+
+    p = &planner.polygons[planner.static_count];
+    p->count = count;
+
+    for (i = 0; i < count; i++)
+        area += cross(points[0], points[i], points[(i + 1) % count]);
+
+    /* Stores it counter clockwise. */
+    for (i = 0; i < count; i++)
+        p->points[i] = area > 0 ? points[i] : points[count - 1 - i];
+
+    for (i = 0; i < count; i++)
+        planner.nodes[planner.static_node_count + i] = p->points[i];
+
+    planner.static_count++;
+    planner.static_node_count += count;
+    planner.static_ready = 0;
+    planner.path_len = 0;
+
+    return 0;
+}
+
+void strat_planner_set_opponent(int index, int32_t x, int32_t y, int32_t half_size)
+{
+    planner_polygon_t *p = &planner.polygons[STRAT_PLANNER_MAX_STATIC + index];
+    strat_planner_point_t *center = &planner.opponent_center[index];
+
+    if (planner.opponent_active[index] &&
+        center->x - x < STRAT_PLANNER_MOVE_THRESHOLD && x - center->x < STRAT_PLANNER_MOVE_THRESHOLD &&
+        center->y - y < STRAT_PLANNER_MOVE_THRESHOLD && y - center->y < STRAT_PLANNER_MOVE_THRESHOLD)
+        return;
+
+    center->x = x;
+    center->y = y;
+    planner.opponent_active[index] = 1;
+
+    p->count = 4;
+    p->points[0].x = x - half_size; p->points[0].y = y - half_size;
+    p->points[1].x = x + half_size; p->points[1].y = y - half_size;
+    p->points[2].x = x + half_size; p->points[2].y = y + half_size;
+    p->points[3].x = x - half_size; p->points[3].y = y + half_size;
+}
+
+void strat_planner_remove_opponent(int index)
+{
+    planner.opponent_active[index] = 0;
+    planner.polygons[STRAT_PLANNER_MAX_STATIC + index].count = 0;
+}
+
+/** Computes the visibility between static nodes, done once. */
+static void strat_planner_prepare_static(void)
+{
+    int i, j, ns = planner.static_node_count;
+    uint64_t valid = 0;
+
+    for (i = 0; i < ns; i++) {
+        planner.static_visible[i] = 0;
+        if (point_valid(planner.nodes[i], 0, planner.static_count))
+            valid |= 1ULL << i;
+    }
+
+    for (i = 0; i < ns; i++) {
+        for (j = i + 1; j < ns; j++) {
+            if (!((valid >> i) & (valid >> j) & 1))
+                continue;
+
+            if (segment_blocked(0, planner.static_count, 0, planner.nodes[i], planner.nodes[j]))
+                continue;
+
+            planner.static_visible[i] |= 1ULL << j;
+            planner.static_visible[j] |= 1ULL << i;
+        }
+    }
+
+    planner.static_ready = 1;
+}
+
+/** Returns the polygons the point is strictly inside of, as a mask. */
+static uint32_t polygons_containing(strat_planner_point_t a)
+{
+    uint32_t mask = 0;
+    int i;
+
+    for (i = 0; i < MAX_POLYGONS; i++) {
+        if (planner.polygons[i].count && point_strictly_inside(&planner.polygons[i], a))
+            mask |= 1UL << i;
+    }
+
+    return mask;
+}
+
+/** Tries to reuse the previous path, skipping the waypoints already passed.
+ * @returns The index of the first waypoint to use, or -1. */
+static int strat_planner_reuse(strat_planner_point_t start, strat_planner_point_t goal)
+{
+    uint32_t ignore = polygons_containing(start);
+    int k;
+
+    if (planner.path_len == 0 || !point_equal(goal, planner.goal))
+        return -1;
+
+    for (k = planner.path_len - 1; k >= 0; k--) {
+        if (k < planner.path_len - 1 &&
+            segment_blocked(0, MAX_POLYGONS, 0, planner.path[k], planner.path[k + 1]))
+            return -1;
+
+        if (!segment_blocked(0, MAX_POLYGONS, ignore, start, planner.path[k]))
+            return k;
+    }
+
+    return -1;
+}
+
+/** A* search in the visibility graph. Fills the path cache. */
+static int strat_planner_search(strat_planner_point_t start, strat_planner_point_t goal)
+{
+    static int32_t cost[MAX_NODES];
+    static int8_t parent[MAX_NODES];
+    static uint8_t state[MAX_NODES]; /* 0 : unseen, 1 : open, 2 : closed */
+    int ns = planner.static_node_count;
+    int n, i, j, current, start_node, goal_node, len;
+    int32_t best, d;
+    uint32_t ignore = polygons_containing(start);
+    int blocked;
+
+    if (!planner.static_ready)
+        strat_planner_prepare_static();
+
+    /* Adds the opponent corners, the start and the goal to the graph. */
+    n = ns;
+    for (i = 0; i < STRAT_PLANNER_MAX_OPPONENTS; i++) {
+        planner_polygon_t *p = &planner.polygons[STRAT_PLANNER_MAX_STATIC + i];
+        for (j = 0; j < p->count; j++)
+            planner.nodes[n++] = p->points[j];
+    }
+
+    start_node = n++;
+    goal_node = n++;
+    planner.nodes[start_node] = start;
+    planner.nodes[goal_node] = goal;
+
+    if (!point_valid(goal, 0, MAX_POLYGONS))
+        return 0;
+
+    for (i = 0; i < n; i++) {
+        /* Corners inside other obstacles are never used. */
+        if (i < start_node && !point_valid(planner.nodes[i], 0, MAX_POLYGONS))
+            state[i] = 2;
+        else
+            state[i] = 0;
+    }
+
+    cost[start_node] = 0;
+    parent[start_node] = -1;
+    state[start_node] = 1;
+
+    while (1) {
+        current = -1;
+        best = 0;
+
+        for (i = 0; i < n; i++) {
+            if (state[i] != 1)
+                continue;
+
+            d = cost[i] + distance(planner.nodes[i], goal);
+            if (current < 0 || d < best) {
+                current = i;
+                best = d;
+            }
+        }
+
+        if (current < 0)
+            return 0;
+
+        if (current == goal_node)
+            break;
+
+        state[current] = 2;
+
+        for (j = 0; j < n; j++) {
+            if (state[j] == 2)
+                continue;
+
+            d = cost[current] + distance(planner.nodes[current], planner.nodes[j]);
+            if (state[j] == 1 && d >= cost[j])
+                continue;
+
+            if (current < ns && j < ns) {
+                /* Static polygons were already checked. */
+                blocked = !((planner.static_visible[current] >> j) & 1) ||
+                          segment_blocked(STRAT_PLANNER_MAX_STATIC, MAX_POLYGONS, 0,
+                                          planner.nodes[current], planner.nodes[j]);
+            } else {
+                blocked = segment_blocked(0, MAX_POLYGONS, current == start_node ? ignore : 0,
+                                          planner.nodes[current], planner.nodes[j]);
+            }
+
+            if (blocked)
+                continue;
+
+            cost[j] = d;
+            parent[j] = current;
+            state[j] = 1;
+        }
+    }
+
+    len = 0;
+    for (i = goal_node; i != start_node; i = parent[i])
+        len++;
+
+    if (len > STRAT_PLANNER_MAX_PATH)
+        return 0;
+
+    for (i = goal_node, j = len - 1; i != start_node; i = parent[i], j--)
+        planner.path[j] = planner.nodes[i];
+
+    planner.path_len = len;
+    planner.goal = goal;
+
+    return len;
+}
+
+int strat_planner_get_path(strat_planner_point_t start, strat_planner_point_t goal,
+                           strat_planner_point_t *path, int max_len)
+{
+    int first, len;
+
+    first = strat_planner_reuse(start, goal);
+
+    if (first >= 0) {
+        planner.stats.reuses++;
+    } else {
+        planner.stats.searches++;
+        planner.path_len = 0;
+        first = 0;
+
+        if (strat_planner_search(start, goal) == 0) {
+            planner.stats.failures++;
+            return 0;
+        }
+    }
+
+    len = planner.path_len - first;
+    if (len > max_len) {
+        planner.stats.failures++;
+        return 0;
+    }
+
+    memcpy(path, &planner.path[first], len * sizeof(strat_planner_point_t));
+
+    return len;
+}
+
+void strat_planner_get_stats(strat_planner_stats_t *stats)
+{
+    *stats = planner.stats;
+}
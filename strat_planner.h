@@ -0,0 +1,87 @@
+/** @file strat_planner.h
+ * @brief Incremental path planner around the obstacles of the table.
+ *
+ * The planner searches the shortest path in the visibility graph of convex
+ * polygons, with A*. Polygons must already be grown by the robot size.
+ *
+ * To keep the latency of a replan below one control period, the work is
+ * split between :
+ *  - Static polygons (table elements), whose visibility graph is computed
+ *    once, the first time a path is requested.
+ *  - Opponent polygons, updated from the beacon. Only moves bigger than
+ *    STRAT_PLANNER_MOVE_THRESHOLD invalidate the previous path.
+ *  - The previous path, which is reused as long as no obstacle blocks it.
+ *
+ * All coordinates are integers in mm, so that no floating point is needed.
+ */
+#ifndef _STRAT_PLANNER_H_
+#define _STRAT_PLANNER_H_
+
+#include <stdint.h>
+
+/** Maximum number of points in a polygon. */
+#define STRAT_PLANNER_POLYGON_POINTS 8
+
+/** Maximum number of static polygons. */
+#define STRAT_PLANNER_MAX_STATIC 8
+
+/** Maximum number of opponents. */
+#define STRAT_PLANNER_MAX_OPPONENTS 4
+
+/** Maximum number of waypoints in a path. */
+#define STRAT_PLANNER_MAX_PATH 16
+
+/** Opponent moves smaller than this (in mm) are ignored. */
+#define STRAT_PLANNER_MOVE_THRESHOLD 20
+
+typedef struct {
+    int32_t x, y;
+} strat_planner_point_t;
+
+/** Planner statistics, mostly to check the replan rate. */
+typedef struct {
+    int32_t searches;       /**< Number of A* searches. */
+    int32_t reuses;         /**< Number of times the previous path was reused. */
+    int32_t failures;       /**< Number of requests without path. */
+} strat_planner_stats_t;
+
+/** Removes all obstacles and forgets the previous path. */
+void strat_planner_init(void);
+
+/** Sets the area the robot center can reach. */
+void strat_planner_set_bounding_box(int32_t x_min, int32_t y_min, int32_t x_max, int32_t y_max);
+
+/** Adds a static convex polygon.
+ * @returns 0 on success, -1 if there is no room left.
+ */
+int strat_planner_add_static_polygon(const strat_planner_point_t *points, int count);
+
+/** Sets the position of an opponent, modeled as a square.
+ *
+ * @param [in] index The opponent index, below STRAT_PLANNER_MAX_OPPONENTS.
+ * @param [in] x, y The opponent center in mm.
+ * @param [in] half_size Half the side of the square, robot size included.
+ */
+void strat_planner_set_opponent(int index, int32_t x, int32_t y, int32_t half_size);
+
+/** Removes an opponent. */
+void strat_planner_remove_opponent(int index);
+
+/** Finds a path to the goal.
+ *
+ * The previous path is reused if it leads to the same goal and is not
+ * blocked. In that case the waypoints which are not needed anymore, because
+ * a later one is directly reachable, are skipped.
+ *
+ * @param [in] start The current position.
+ * @param [in] goal The destination.
+ * @param [out] path The waypoints, the last one being the goal.
+ * @param [in] max_len The size of path.
+ * @returns The number of waypoints, 0 if there is no path.
+ */
+int strat_planner_get_path(strat_planner_point_t start, strat_planner_point_t goal,
+                           strat_planner_point_t *path, int max_len);
+
+void strat_planner_get_stats(strat_planner_stats_t *stats);
+
+#endif
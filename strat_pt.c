@@ -0,0 +1,35 @@
+#include <string.h>
+#include "strat_pt.h"
+
+/** Resources owned by any protothread. */
+static uint32_t strat_resources;
+
+void strat_pt_init(strat_pt_t *pt)
+{
+    memset(pt, 0, sizeof(strat_pt_t));
+}
+
+int strat_pt_acquire(strat_pt_t *pt, uint32_t resources)
+{
+    /* Only the strategy task uses them, no locking needed. */
+    if (strat_resources & resources & ~pt->resources)
+        return 0;
+
+    strat_resources |= resources;
+    pt->resources |= resources;
+
+    return 1;
+}
+
+void strat_pt_release(strat_pt_t *pt, uint32_t resources)
+{
+    resources &= pt->resources;
+
+    if (resources == 0)
+        return;
+
+    strat_resources &= ~resources;
+    pt->resources &= ~resources;
+
+    robot_events_post(ROBOT_EVENT_STRAT_RESOURCE);
+}
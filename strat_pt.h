@@ -0,0 +1,143 @@
+/** @file strat_pt.h
+ * @brief Stackless coroutines (protothreads) for the strategy actions.
+ *
+ * An action written with those macros is a strat_job function which returns
+ * to the scheduler whenever it has to wait for the base or an arm, instead of
+ * blocking the strategy task. Other actions can run in the meantime, for
+ * example to drive to the next goal while an arm is still stowing.
+ *
+ * @code
+ * struct my_action { strat_pt_t pt; int ret; };
+ *
+ * int my_action(void *p)
+ * {
+ *     struct my_action *a = p;
+ *
+ *     STRAT_PT_BEGIN(&a->pt);
+ *     STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE);
+ *     trajectory_d_rel(&robot.traj, 100);
+ *     STRAT_PT_WAIT_TRAJ(&a->pt, TRAJ_FLAGS_STD, a->ret);
+ *     STRAT_PT_END(&a->pt);
+ * }
+ * @endcode
+ *
+ * Resources are taken for a whole phase at once, and released as soon as the
+ * action does not need them anymore. To avoid deadlocks, an action never
+ * acquires more resources while it already owns some, it uses
+ * STRAT_PT_NEXT_PHASE instead.
+ *
+ * @warning The function is re-entered from the top after each wait, so local
+ * variables are lost across waits. Everything needed after a wait must live
+ * in the parameter struct. Waits cannot be used inside a switch statement,
+ * and there can only be one wait per line.
+ */
+#ifndef _STRAT_PT_H_
+#define _STRAT_PT_H_
+
+#include <stdint.h>
+#include <uptime.h>
+#include "strat_job.h"
+#include "strat_utils.h"
+#include "robot_events.h"
+
+/* Resources an action can own, so concurrent actions do not fight. */
+#define STRAT_RESOURCE_BASE       0x01
+#define STRAT_RESOURCE_LEFT_ARM   0x02
+#define STRAT_RESOURCE_RIGHT_ARM  0x04
+#define STRAT_RESOURCE_ALL        0x07
+
+/** State of a protothread. */
+typedef struct {
+    int line;               /**< Line to resume at, 0 to start from the beginning. */
+    uint32_t resources;     /**< Resources owned by the protothread. */
+    int32_t date;           /**< End of the current STRAT_PT_SLEEP, in us. */
+} strat_pt_t;
+
+/** Inits a protothread, it will start from the beginning. */
+void strat_pt_init(strat_pt_t *pt);
+
+/** Takes resources if none of them is owned by another protothread.
+ * @returns 1 if the resources were taken, 0 otherwise.
+ */
+int strat_pt_acquire(strat_pt_t *pt, uint32_t resources);
+
+/** Releases resources and wakes up the protothreads waiting for them. */
+void strat_pt_release(strat_pt_t *pt, uint32_t resources);
+
+#define STRAT_PT_BEGIN(pt) switch ((pt)->line) { case 0:
+
+/** Ends the protothread, releasing its resources. */
+#define STRAT_PT_END(pt) \
+    } \
+    strat_pt_release((pt), (pt)->resources); \
+    (pt)->line = 0; \
+    return STRAT_JOB_DONE
+
+/** Waits until cond is true. It is evaluated again each time one of the
+ * events is posted. */
+#define STRAT_PT_WAIT_UNTIL(pt, events, cond) \
+    do { \
+        (pt)->line = __LINE__; case __LINE__: \
+        if (!(cond)) { \
+            strat_job_wait_for(events); \
+            return STRAT_JOB_WAIT; \
+        } \
+    } while (0)
+
+/** Lets the other jobs run once. */
+#define STRAT_PT_YIELD(pt) \
+    do { \
+        (pt)->line = __LINE__; \
+        return STRAT_JOB_AGAIN; \
+        case __LINE__:; \
+    } while (0)
+
+/** Waits until the resources are available, then takes them. */
+#define STRAT_PT_ACQUIRE(pt, res) \
+    STRAT_PT_WAIT_UNTIL(pt, ROBOT_EVENT_STRAT_RESOURCE, strat_pt_acquire(pt, res))
+
+/** Goes to the next phase of an action : releases all its resources, then
+ * waits until the ones of the phase are available and takes them.
+ *
+ * When they are free, they are taken back before any other job runs.
+ */
+#define STRAT_PT_NEXT_PHASE(pt, res) \
+    do { \
+        strat_pt_release((pt), (pt)->resources); \
+        STRAT_PT_ACQUIRE(pt, res); \
+    } while (0)
+
+/** Waits for the end of an arm trajectory. */
+#define STRAT_PT_WAIT_ARM(pt, arm) \
+    STRAT_PT_WAIT_UNTIL(pt, strat_arm_done_event(arm), arm_is_trajectory_finished(arm))
+
+/** Same as wait_traj_end, the end reason is stored in ret. */
+#define STRAT_PT_WAIT_TRAJ(pt, why, ret) \
+    STRAT_PT_WAIT_UNTIL(pt, strat_traj_events(why), ((ret) = test_traj_end(why)) != 0)
+
+/** Runs a child protothread until it ends, as part of this one.
+ *
+ * The child waits on behalf of its parent. It must not acquire resources,
+ * it uses the ones of its parent.
+ * @param [in] child The state of the child, it is inited here.
+ * @param [in] call The call to the child function.
+ */
+#define STRAT_PT_SPAWN(pt, child, call) \
+    do { \
+        strat_pt_init(child); \
+        (pt)->line = __LINE__; case __LINE__: \
+        { \
+            int strat_pt_ret_ = (call); \
+            if (strat_pt_ret_ != STRAT_JOB_DONE) \
+                return strat_pt_ret_; \
+        } \
+    } while (0)
+
+/** Sleeps for the given time in ms, with the resolution of the control loop. */
+#define STRAT_PT_SLEEP(pt, ms) \
+    do { \
+        (pt)->date = uptime_get() + (ms) * 1000; \
+        STRAT_PT_WAIT_UNTIL(pt, ROBOT_EVENT_POSITION, uptime_get() - (pt)->date >= 0); \
+    } while (0)
+
+#endif
@@ -1,10 +1,40 @@
 #include <platform.h>
-#include <obstacle_avoidance.h>
+#include <math.h>
 #include <aversive/error.h>
 #include <2wheels/trajectory_manager_utils.h>
-#include <cvra_beacon.h>
 #include "strat_utils.h"
 #include "cvra_cs.h"
+#include "periodic.h"
+#include "robot_events.h"
+#include "strat_planner.h"
+#include "task_stats.h"
+
+/** Period at which conditions without event (END_TIMER) are checked, in us. */
+#define STRAT_EVENT_POLL_PERIOD 100000
+
+/** Distance between the robot and opponent centers considered as a collision, in mm. */
+#define OBSTACLE_RADIUS 500
+
+/** Collisions predicted later than this are ignored, in ms. */
+#define OBSTACLE_HORIZON 2000
+
+/** Distance kept before the collision point when braking, in mm. */
+#define OBSTACLE_MARGIN 100
+
+/** When the speed allowed by an obstacle is below this, the robot stops
+ * and END_OBSTACLE is returned, in mm/s. */
+#define OBSTACLE_MIN_SPEED 100
+
+/** Smallest END_NEAR window, used at low speed, in mm. */
+#define NEAR_MIN_DISTANCE 100
+
+/** Speed set before an obstacle slowed us down, restored once it is gone. */
+static struct {
+    int active;
+    double d_speed, a_speed;    /**< In imp per control period. */
+} speed_limit;
+
+static void strat_release_speed_limit(void);
 
 
 struct strat_info strat;
@@ -85,6 +115,15 @@ void strat_autopos(int16_t x, int16_t y, int16_t a, int16_t epaisseurRobot)
     trajectory_set_speed(&robot.traj, speed_mm2imp(&robot.traj, 300), speed_rd2imp(&robot.traj, 2.5));
 }
 
+void strat_get_velocity(float *vx, float *vy)
+{
+    float speed = speed_imp2mm(&robot.traj, robot.distance_qr.previous_var);
+    float a = position_get_a_rad_float(&robot.pos);
+
+    *vx = speed * cos(a);
+    *vy = speed * sin(a);
+}
+
 /** Converts relative angle/distance coordinates to absolute. */
 void strat_da_rel_to_xy_abs(float a_deg, float distance_mm, int *x_mm, int *y_mm)
 {
@@ -92,131 +131,262 @@ void strat_da_rel_to_xy_abs(float a_deg, float distance_mm, int *x_mm, int *y_mm
     *y_mm = distance_mm * sin(RAD(a_deg)) + position_get_y_s16(&robot.pos);
 }
 
-void create_opp_polygon(poly_t *pol, int x, int y)
+/** Time taken by the replans of strat_goto_avoid, to check they fit in a
+ * control period. */
+static task_stats_t replan_stats;
+
+/** Radius of the hearts of fire, grown by the robot size, in mm. */
+#define CENTER_HEART_RADIUS (150 + 150)
+#define CORNER_HEART_RADIUS (250 + 150)
+
+void strat_add_table_obstacles(void)
+{
+    /* Octagon around the central heart, its corners outside of the circle. */
+    static const strat_planner_point_t center[] = {
+        {1500 + 125, 1000 + 302}, {1500 + 302, 1000 + 125},
+        {1500 + 302, 1000 - 125}, {1500 + 125, 1000 - 302},
+        {1500 - 125, 1000 - 302}, {1500 - 302, 1000 - 125},
+        {1500 - 302, 1000 + 125}, {1500 - 125, 1000 + 302},
+    };
+
+    /* Quarter circles in the corners of the x = 0 border. */
+    static const strat_planner_point_t corner_low[] = {
+        {0, 0}, {CORNER_HEART_RADIUS, 0}, {283, 283}, {0, CORNER_HEART_RADIUS},
+    };
+    static const strat_planner_point_t corner_high[] = {
+        {0, 2000}, {0, 2000 - CORNER_HEART_RADIUS}, {283, 2000 - 283}, {CORNER_HEART_RADIUS, 2000},
+    };
+
+    strat_planner_add_static_polygon(center, 8);
+    strat_planner_add_static_polygon(corner_low, 4);
+    strat_planner_add_static_polygon(corner_high, 4);
+}
+
+/** Half size of the square modeling an opponent, our size included. */
+#define OPPONENT_HALF_SIZE 600 // XXX check this, it should be greater IMHO
+
+void strat_update_opponents(void)
 {
-    const int width = 600; // half width XXX check this, it should be greater IMHO
-    const int height = width;
+    beacon_track_t tracks[STRAT_PLANNER_MAX_OPPONENTS];
+    int i, n;
 
-    oa_poly_set_point(pol, x+width, y+width, 0);
-    oa_poly_set_point(pol, x+width, y-width, 1);
-    oa_poly_set_point(pol, x-width, y-width, 2);
-    oa_poly_set_point(pol, x-width, y+width, 3);
+    n = beacon_tracker_get_tracks(&robot.tracker, tracks, STRAT_PLANNER_MAX_OPPONENTS, uptime_get());
+
+    for (i = 0; i < STRAT_PLANNER_MAX_OPPONENTS; i++) {
+        if (i < n)
+            strat_planner_set_opponent(i, tracks[i].x, tracks[i].y, OPPONENT_HALF_SIZE);
+        else
+            strat_planner_remove_opponent(i);
+    }
 }
 
 int strat_goto_avoid(int x, int y, int flags)
 {
-    int i, len, ret;
-    int retry_count;
-    int opp_x, opp_y;
-    poly_t *pol_opp;
-    point_t *p;
-    oa_init();
+    strat_planner_point_t start, goal, target, reached;
+    strat_planner_point_t path[STRAT_PLANNER_MAX_PATH];
+    int len, ret, first;
+    int retry_count = 0;
+    int moving = 0;
+    int has_reached = 0;
+    int32_t now;
 
-    /* The robot will try 3 times before giving up. */
-    for(retry_count=0;retry_count<3;retry_count++) {
+    goal.x = x;
+    goal.y = y;
 
-        /* Creates one polygon for each opponent robot. */
-        for(i=0;i<robot.beacon.nb_beacon;i++) {
-            pol_opp = oa_new_poly(4);
+    if (replan_stats.name == NULL)
+        task_stats_init(&replan_stats, "replan");
 
-            strat_da_rel_to_xy_abs(robot.beacon.beacon[i].direction, robot.beacon.beacon[i].distance*10,
-                   &opp_x, &opp_y);
+    while (1) {
+        now = uptime_get();
+        task_stats_begin(&replan_stats, now, now);
 
-            NOTICE(0, "Op is at %d;%d", opp_x, opp_y);
-            create_opp_polygon(pol_opp, 800, 0);
+        strat_update_opponents();
 
-            /* Checks if the arrival point is in an opponent. */
-            if(is_point_in_poly(pol_opp, x, y)) {
-                WARNING(0, "Destination point is in opponent.");
-                return END_ERROR;
-            }
-        }
+        start.x = position_get_x_s16(&robot.pos);
+        start.y = position_get_y_s16(&robot.pos);
 
-        /* Sets starting and ending point of the path. */
-        oa_start_end_points(position_get_x_s16(&robot.pos), position_get_x_s16(&robot.pos), x, y);
+        /* Cheap when nothing moved, the previous path is reused. */
+        len = strat_planner_get_path(start, goal, path, STRAT_PLANNER_MAX_PATH);
 
-        /* Computes the path */
-        len = oa_process();
+        task_stats_end(&replan_stats, uptime_get());
 
-        /* Checks if a path was found. */
-        if(len == 0) {
+        if (len == 0) {
             WARNING(0, "Cannot find a suitable path.");
+            if (moving)
+                trajectory_hardstop(&robot.traj);
+
+            /* The last wait may have timed out while an obstacle slowed
+             * us down, the other returns come from an ended order. */
+            strat_release_speed_limit();
             return END_ERROR;
         }
 
-        p = oa_get_path();
-        /* For all the points in the path. */
-        for(i=0;i<len;i++) {
-            /* Goes to the point. */
-            trajectory_goto_forward_xy_abs(&robot.traj, p->x, p->y);
-
-            /* Waits for the completion of the trajectory. */
-            ret = wait_traj_end(flags);
-
-            /* If we were blocked or met an obstacle, we will retry. */
-            if(ret == END_BLOCKING || ret == END_OBSTACLE) {
-                WARNING(0, "Retry");
-                break; // we retry once more
-            } else if(!TRAJ_SUCCESS(ret)) {
-                /* If it was an other error, we simply abort and return it. */
-                WARNING(0, "Unknown error code : %d", ret);
-                return ret;
-            }
+        /* The robot stops a few mm off the waypoint, from where the
+         * planner may not see the next one and return the same waypoint
+         * again. It is skipped, otherwise the wait below would end at once
+         * forever. */
+        first = 0;
+        if (has_reached && len > 1 && path[0].x == reached.x && path[0].y == reached.y)
+            first = 1;
+
+        /* Only sends a new order when the next waypoint changed, so the
+         * trajectory is not restarted every period. */
+        if (!moving || path[first].x != target.x || path[first].y != target.y) {
+            target = path[first];
+            moving = 1;
+            trajectory_goto_forward_xy_abs(&robot.traj, target.x, target.y);
+        }
+
+        /* Wakes up every control period to replan if the opponents moved. */
+        ret = wait_traj_end_timeout(flags, 1000 / ASSERV_FREQUENCY);
+
+        if (ret == END_TIMEOUT)
+            continue;
 
-            /* Increments pointer to load next point. */
-            p++;
+        /* If we were blocked or met an obstacle, we will retry. */
+        if (ret == END_BLOCKING || ret == END_OBSTACLE) {
+            /* The robot will try 3 times before giving up. */
+            if (++retry_count >= 3)
+                return END_ERROR;
+
+            WARNING(0, "Retry");
+            moving = 0;
+            continue;
         }
 
-        /* If we reached last point, no need to retry. */
-        if(ret == END_TRAJ)
-            return END_TRAJ;
+        if (!TRAJ_SUCCESS(ret)) {
+            /* If it was an other error, we simply abort and return it. */
+            WARNING(0, "Unknown error code : %d", ret);
+            return ret;
+        }
+
+        /* If we reached last point, we are done. */
+        if (len - first == 1)
+            return ret;
+
+        reached = target;
+        has_reached = 1;
+        moving = 0;
     }
+}
 
-    /* If we reach here, it means 3 try were not enough. */
-    return END_ERROR;
+/** Returns the current distance speed and deceleration, in mm/s and mm/s^2. */
+static void strat_get_speed_decel(double *speed, double *decel)
+{
+    *speed = fabs(speed_imp2mm(&robot.traj, robot.distance_qr.previous_var));
+    *decel = acc_imp2mm(&robot.traj, robot.distance_qr.var_2nd_ord_neg);
 }
 
-int test_traj_end(int why)
+/** Distance needed to stop from the given speed, in mm. */
+static double strat_stop_distance(double speed, double decel)
+{
+    if (decel <= 0)
+        return 0;
+
+    return speed * speed / (2 * decel);
+}
+
+/** Lowers the distance speed of the current trajectory, in mm/s.
+ *
+ * The trajectory manager reapplies its own speed on xy orders, and only at
+ * the start of the others, so both are changed. */
+static void strat_limit_speed(double speed_mm)
+{
+    double speed;
+
+    if (!speed_limit.active) {
+        speed_limit.d_speed = robot.traj.d_speed;
+        speed_limit.a_speed = robot.traj.a_speed;
+        speed_limit.active = 1;
+    }
+
+    speed = speed_mm2imp(&robot.traj, speed_mm);
+    if (speed > speed_limit.d_speed)
+        speed = speed_limit.d_speed;
+
+    trajectory_set_speed(&robot.traj, speed, speed_limit.a_speed);
+    quadramp_set_1st_order_vars(&robot.distance_qr, speed, speed);
+}
+
+static void strat_release_speed_limit(void)
+{
+    if (!speed_limit.active)
+        return;
+
+    speed_limit.active = 0;
+    trajectory_set_speed(&robot.traj, speed_limit.d_speed, speed_limit.a_speed);
+    quadramp_set_1st_order_vars(&robot.distance_qr, speed_limit.d_speed, speed_limit.d_speed);
+}
+
+/** Slows the robot down when it drives toward an opponent.
+ *
+ * The speed is limited so that the robot could stop within half of the
+ * distance left before the predicted collision, which makes it brake
+ * progressively as the opponent gets closer.
+ *
+ * @returns END_OBSTACLE if the robot had to stop, 0 otherwise.
+ */
+static int strat_check_obstacle(double speed, double decel)
+{
+    double free, allowed;
+    float vx, vy;
+    int32_t ttc;
+
+    strat_get_velocity(&vx, &vy);
+    ttc = beacon_tracker_time_to_collision(&robot.tracker,
+            position_get_x_float(&robot.pos), position_get_y_float(&robot.pos),
+            vx, vy, OBSTACLE_RADIUS, uptime_get());
+
+    if (ttc == BEACON_TRACKER_NO_COLLISION || ttc > OBSTACLE_HORIZON) {
+        strat_release_speed_limit();
+        return 0;
+    }
+
+    /* Distance we travel before reaching the collision point. */
+    free = speed * ttc / 1000. - OBSTACLE_MARGIN;
+
+    /* Too late to brake normally. */
+    if (free <= strat_stop_distance(speed, decel)) {
+        trajectory_hardstop(&robot.traj);
+        bd_reset(&robot.distance_bd);
+        return END_OBSTACLE;
+    }
+
+    allowed = sqrt(decel * free);
+
+    if (allowed < OBSTACLE_MIN_SPEED) {
+        trajectory_stop(&robot.traj);
+        return END_OBSTACLE;
+    }
+
+    strat_limit_speed(allowed);
+
+    return 0;
+}
+
+static int test_traj_end_cause(int why)
 {
+    double speed, decel;
 
     if((why & END_TRAJ) && trajectory_finished(&robot.traj))
         return END_TRAJ;
 
+    strat_get_speed_decel(&speed, &decel);
+
     if (why & END_NEAR) {
-        int16_t d_near = 100; /* mm */
-        /* XXX Change distance depending on speed. */
+        /* We are near when we should start braking, so the next order is
+         * given without slowing down. */
+        double d_near = strat_stop_distance(speed, decel);
+
+        if (d_near < NEAR_MIN_DISTANCE)
+            d_near = NEAR_MIN_DISTANCE;
+
         if (trajectory_in_window(&robot.traj, d_near, RAD(5.0)))
             return END_NEAR;
     }
 
-    if((why & END_OBSTACLE)) {
-        int i;
-        OS_CPU_SR cpu_sr;
-        OS_ENTER_CRITICAL();
-
-        for(i=0;i<robot.beacon.nb_beacon;i++) {
-            if(robot.beacon.beacon[i].distance > 0) { /*cm*/
-                if(robot.distance_qr.previous_var > 0) {
-                    /* Going forward. */
-                    if(robot.beacon.beacon[i].direction > -90 && robot.beacon.beacon[i].direction < 90) {
-                        OS_EXIT_CRITICAL();
-                        trajectory_hardstop(&robot.traj);
-                        bd_reset(&robot.distance_bd);
-                        return END_OBSTACLE;
-                    }
-                } else if(robot.distance_qr.previous_var < 0) {
-                    /* Going backward */
-                    if(robot.beacon.beacon[i].direction < -90 && robot.beacon.beacon[i].direction > -270) {
-                        OS_EXIT_CRITICAL();
-                        trajectory_hardstop(&robot.traj);
-                        bd_reset(&robot.distance_bd);
-                        return END_OBSTACLE;
-                    }
-                }
-            }
-        }
-        OS_EXIT_CRITICAL();
-    }
+    if ((why & END_OBSTACLE) && strat_check_obstacle(speed, decel))
+        return END_OBSTACLE;
 
     if((why & END_BLOCKING) && bd_get(&robot.distance_bd)) {
         trajectory_hardstop(&robot.traj);
@@ -241,17 +411,107 @@ int test_traj_end(int why)
     return 0;
 }
 
-int wait_traj_end_debug(int why, char *file, int line) {
+int test_traj_end(int why)
+{
+    int ret = test_traj_end_cause(why);
+
+    /* The next trajectory must not inherit the obstacle speed limit. */
+    if (ret != 0)
+        strat_release_speed_limit();
+
+    return ret;
+}
+
+uint32_t strat_traj_events(int why)
+{
+    uint32_t events = 0;
+
+    if (why & END_TRAJ)
+        events |= ROBOT_EVENT_TRAJ_END;
+
+    if (why & END_BLOCKING)
+        events |= ROBOT_EVENT_BLOCKING;
+
+    /* Those depend on the position. */
+    if (why & (END_NEAR | END_OBSTACLE))
+        events |= ROBOT_EVENT_POSITION;
+
+    return events;
+}
+
+int wait_traj_end_debug(int why, int timeout, char *file, int line) {
+    int32_t deadline = uptime_get() + timeout * 1000;
+    int32_t sleep;
+    uint32_t events = strat_traj_events(why);
     int ret;
-    do {
-        ret = test_traj_end(why);
-    } while(ret==0);
+
+    while ((ret = test_traj_end(why)) == 0) {
+        sleep = STRAT_EVENT_POLL_PERIOD;
+
+        if (timeout != 0) {
+            if (deadline - uptime_get() <= 0) {
+                ret = END_TIMEOUT;
+                break;
+            }
+
+            if (deadline - uptime_get() < sleep)
+                sleep = deadline - uptime_get();
+        }
+
+        if (events)
+            robot_events_wait(events, sleep);
+        else
+            periodic_sleep_us(sleep);
+    }
 
     DEBUG(0, "%s:%d got %d", file, line, ret);
 
     return ret;
 }
 
+uint32_t strat_arm_done_event(arm_t *arm)
+{
+    if (arm == &robot.left_arm)
+        return ROBOT_EVENT_LEFT_ARM_DONE;
+
+    return ROBOT_EVENT_RIGHT_ARM_DONE;
+}
+
+int strat_wait_arm(arm_t *arm, int timeout)
+{
+    return strat_wait_arms(&arm, 1, timeout);
+}
+
+int strat_wait_arms(arm_t **arms, int count, int timeout)
+{
+    int32_t deadline = uptime_get() + timeout * 1000;
+    int32_t sleep;
+    uint32_t events = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+        events |= strat_arm_done_event(arms[i]);
+
+    while (1) {
+        for (i = 0; i < count; i++) {
+            if (!arm_is_trajectory_finished(arms[i]))
+                break;
+        }
+
+        if (i == count)
+            return END_TRAJ;
+
+        sleep = ROBOT_EVENTS_FOREVER;
+        if (timeout != 0) {
+            sleep = deadline - uptime_get();
+            if (sleep <= 0)
+                return END_TIMEOUT;
+        }
+
+        robot_events_wait(events, sleep);
+    }
+}
+
 void right_pump(int status){
     if(status > 0)
         cvra_dc_set_pwm4(HEXMOTORCONTROLLER_BASE, 475);
@@ -302,6 +562,9 @@ void strat_set_speed(enum speed_e speed)
     }
 
 
+    /* The new speed replaces the one saved before an obstacle limit. */
+    speed_limit.active = 0;
+
     trajectory_set_acc(&robot.traj,
             acc_mm2imp(&robot.traj, acc_d),
             acc_rd2imp(&robot.traj, acc_a));
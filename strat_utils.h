@@ -1,6 +1,8 @@
 #ifndef _STRAT_UTILS_H_
 #define _STRAT_UTILS_H_
 
+#include "arm.h"
+
 /** Duration of a match in seconds. */
 #define MATCH_TIME 89
 
@@ -11,6 +13,7 @@
 #define END_OBSTACLE   8 /**< There is an obstacle in front of us */
 #define END_ERROR     16 /**< Cannot do the command */
 #define END_TIMER     32 /**< End of match timer. */
+#define END_TIMEOUT   64 /**< The wait timed out before any other condition. */
 
 /** Checks if an return code indicates a succesful trajectory. */
 #define TRAJ_SUCCESS(f) ((f) & (END_TRAJ|END_NEAR))
@@ -43,7 +46,10 @@ extern struct strat_info strat;
 /** Computes the symmetrical angle depending on color. */
 #define COLOR_A(x) (strat.color == YELLOW ? (x) : -(x))
 
-#define wait_traj_end(why) wait_traj_end_debug(why, __FILE__, __LINE__)
+#define wait_traj_end(why) wait_traj_end_debug(why, 0, __FILE__, __LINE__)
+
+/** Same as wait_traj_end, but gives up after timeout ms with END_TIMEOUT. */
+#define wait_traj_end_timeout(why, timeout) wait_traj_end_debug(why, timeout, __FILE__, __LINE__)
 
 enum servo_e {
     LEFT,
@@ -76,11 +82,39 @@ void strat_autopos(int16_t x, int16_t y, int16_t a, int16_t epaisseurRobot);
 int test_traj_end(int why);
 
 /** Waits for the end of a trajectory.
+ *
+ * The task sleeps until the control system signals the end of the trajectory
+ * or a blocking. Conditions depending on the position (END_NEAR,
+ * END_OBSTACLE) are checked once per control period.
  *
  * @param [in] why The allowed reasons to end the trajectory.
+ * @param [in] timeout The maximum time to wait in ms, 0 to wait forever.
  * @returns An error code indicating the reason of the end of the trajectory.
  */
-int wait_traj_end_debug(int why, char *file, int line);
+int wait_traj_end_debug(int why, int timeout, char *file, int line);
+
+/** Returns the robot events signaling a change in the given end of
+ * trajectory conditions. */
+uint32_t strat_traj_events(int why);
+
+/** Returns the robot event posted when the given arm finishes its trajectory. */
+uint32_t strat_arm_done_event(arm_t *arm);
+
+/** Waits until an arm finishes its trajectory, without using the CPU.
+ *
+ * @param [in] timeout The maximum time to wait in ms, 0 to wait forever.
+ * @returns END_TRAJ if the arm finished, END_TIMEOUT otherwise.
+ */
+int strat_wait_arm(arm_t *arm, int timeout);
+
+/** Waits until all the given arms finish their trajectories.
+ *
+ * @param [in] arms The arms to wait for.
+ * @param [in] count The number of arms.
+ * @param [in] timeout The maximum time to wait in ms, 0 to wait forever.
+ * @returns END_TRAJ if all arms finished, END_TIMEOUT otherwise.
+ */
+int strat_wait_arms(arm_t **arms, int count, int timeout);
 
 
 void left_pump(int status);
@@ -100,8 +134,20 @@ int strat_get_time(void);
  */
 void strat_wait_ms(int ms);
 
+/** Gets the robot velocity in the table frame, in mm/s. */
+void strat_get_velocity(float *vx, float *vy);
+
+/** Adds the hearts of fire to the path planner, after its bounding box. */
+void strat_add_table_obstacles(void);
+
+/** Updates the opponents of the path planner from the beacon tracker. */
+void strat_update_opponents(void);
+
 /**
- * Goes to a given position, with the given flags.
+ * Goes to a given position, avoiding the obstacles, with the given flags.
+ *
+ * The path is replanned every control period, so the robot goes around the
+ * opponents while they move. See strat_planner.h.
  * @param [in] x,y Target point
  * @param [in] flags Some OR'd flag to indicate possible cause for stop, such
  * as END_TRAJ | END_BLOCKING.
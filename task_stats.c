@@ -0,0 +1,122 @@
+#include <stddef.h>
+#include <string.h>
+#include "task_stats.h"
+
+static task_stats_t *registry[TASK_STATS_MAX_TASKS];
+static int registry_count;
+
+static void task_stats_clear(task_stats_t *s)
+{
+    s->count = 0;
+    s->min_time = INT32_MAX;
+    s->max_time = 0;
+    s->total_time = 0;
+    s->min_lateness = INT32_MAX;
+    s->max_lateness = INT32_MIN;
+    s->total_lateness = 0;
+    memset(s->histogram, 0, sizeof(s->histogram));
+    s->reset_requested = 0;
+}
+
+void task_stats_init(task_stats_t *s, const char *name)
+{
+    int i;
+
+    s->name = name;
+    s->running = 0;
+    task_stats_clear(s);
+
+    for (i = 0; i < registry_count; i++) {
+        if (registry[i] == s)
+            return;
+    }
+
+    if (registry_count < TASK_STATS_MAX_TASKS)
+        registry[registry_count++] = s;
+}
+
+void task_stats_begin(task_stats_t *s, int32_t deadline, int32_t now)
+{
+    int32_t lateness = now - deadline;
+
+    if (s->reset_requested)
+        task_stats_clear(s);
+
+    if (lateness < s->min_lateness)
+        s->min_lateness = lateness;
+    if (lateness > s->max_lateness)
+        s->max_lateness = lateness;
+    s->total_lateness += lateness;
+
+    s->start = now;
+    s->running = 1;
+}
+
+void task_stats_end(task_stats_t *s, int32_t now)
+{
+    int32_t duration = now - s->start;
+    int bucket = 0;
+
+    if (!s->running)
+        return;
+
+    s->running = 0;
+    s->count++;
+
+    if (duration < s->min_time)
+        s->min_time = duration;
+    if (duration > s->max_time)
+        s->max_time = duration;
+    s->total_time += duration;
+
+    while ((duration >> (bucket + 1)) > 0 && bucket < TASK_STATS_HISTOGRAM_SIZE - 1)
+        bucket++;
+
+    s->histogram[bucket]++;
+}
+
+void task_stats_request_reset(task_stats_t *s)
+{
+    s->reset_requested = 1;
+}
+
+int32_t task_stats_mean_time(task_stats_t *s)
+{
+    if (s->count == 0)
+        return 0;
+
+    return s->total_time / s->count;
+}
+
+int32_t task_stats_mean_lateness(task_stats_t *s)
+{
+    if (s->count == 0)
+        return 0;
+
+    return s->total_lateness / s->count;
+}
+
+int task_stats_count(void)
+{
+    return registry_count;
+}
+
+task_stats_t *task_stats_get(int i)
+{
+    if (i < 0 || i >= registry_count)
+        return NULL;
+
+    return registry[i];
+}
+
+task_stats_t *task_stats_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < registry_count; i++) {
+        if (!strcmp(registry[i]->name, name))
+            return registry[i];
+    }
+
+    return NULL;
+}
@@ -0,0 +1,75 @@
+/** @file task_stats.h
+ * @brief Execution time and wake up jitter statistics of the periodic tasks.
+ *
+ * Each task owns a task_stats_t, and calls task_stats_begin when it wakes up
+ * and task_stats_end when its work is done. Tasks using periodic_wait only
+ * need to attach their stats with periodic_set_stats.
+ *
+ * All times are in us.
+ */
+#ifndef _TASK_STATS_H_
+#define _TASK_STATS_H_
+
+#include <stdint.h>
+
+/** Number of buckets of the execution time histogram. Bucket i counts the
+ * execution times between 2^i and 2^(i+1) us, the last one everything above. */
+#define TASK_STATS_HISTOGRAM_SIZE 16
+
+/** Maximum number of tasks in the registry. */
+#define TASK_STATS_MAX_TASKS 8
+
+typedef struct {
+    const char *name;
+
+    int32_t count;          /**< Number of measured activations. */
+    int32_t min_time;       /**< Shortest execution time. */
+    int32_t max_time;       /**< Longest execution time. */
+    int64_t total_time;     /**< Sum of execution times, to compute the mean. */
+
+    int32_t min_lateness;   /**< Smallest delay between deadline and wake up. */
+    int32_t max_lateness;   /**< Largest delay between deadline and wake up. */
+    int64_t total_lateness;
+
+    int32_t histogram[TASK_STATS_HISTOGRAM_SIZE];
+
+    int32_t start;          /**< Wake up date of the current activation. */
+    int running;            /**< Non zero between begin and end. */
+    volatile int reset_requested;
+} task_stats_t;
+
+/** Inits the stats of a task and adds them to the registry. */
+void task_stats_init(task_stats_t *s, const char *name);
+
+/** Marks the start of an activation.
+ * @param [in] deadline The date at which the task should have woken up.
+ * @param [in] now The current date.
+ */
+void task_stats_begin(task_stats_t *s, int32_t deadline, int32_t now);
+
+/** Marks the end of an activation started with task_stats_begin. */
+void task_stats_end(task_stats_t *s, int32_t now);
+
+/** Asks for the stats to be cleared.
+ *
+ * The reset is done by the task itself on its next activation, so this can be
+ * called from any task.
+ */
+void task_stats_request_reset(task_stats_t *s);
+
+/** Mean execution time, 0 if nothing was measured yet. */
+int32_t task_stats_mean_time(task_stats_t *s);
+
+/** Mean lateness, 0 if nothing was measured yet. */
+int32_t task_stats_mean_lateness(task_stats_t *s);
+
+/** Returns the number of registered tasks. */
+int task_stats_count(void);
+
+/** Returns the stats of the i-th registered task, or NULL. */
+task_stats_t *task_stats_get(int i);
+
+/** Returns the stats of the task with the given name, or NULL. */
+task_stats_t *task_stats_find(const char *name);
+
+#endif
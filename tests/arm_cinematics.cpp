@@ -31,7 +31,8 @@ TEST_GROUP(CinematicsTestGroup)
     {
         uptime_set(0);
         arm_trajectory_delete(&traj);
-        arm_trajectory_delete(&arm.trajectory);
+        arm_trajectory_delete(&arm.trajectory_buffers[0]);
+        arm_trajectory_delete(&arm.trajectory_buffers[1]);
     }
 };
 
@@ -88,6 +89,7 @@ TEST(CinematicsTestGroup, DoesNotOscillateAroundZero)
     arm_trajectory_append_point(&traj, 100,  1, 10, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 100, -1, 10, COORDINATE_ARM, 10.);
     arm_do_trajectory(&arm, &traj);
+    arm_manage(&arm);
 
     while (uptime_get() < traj.frames[traj.frame_count-1].date) {
         frame = arm_position_for_date(&arm, uptime_get());
@@ -103,3 +105,149 @@ TEST(CinematicsTestGroup, DoesNotOscillateAroundZero)
         uptime_set(uptime_get() + 2*1000);
     }
 }
+
+/* Reference implementation, using the generic circle intersection. */
+static int reference_inverse_cinematics(point_t target, float length[2], shoulder_mode_t mode,
+                                        float *alpha, float *beta)
+{
+    point_t p1, p2;
+    int count;
+
+    count = compute_possible_elbow_positions(target, length[0], length[1], &p1, &p2);
+    if (count == 0)
+        return 0;
+
+    if (count == 2)
+        p1 = choose_shoulder_solution(target, p1, p2, mode);
+
+    *alpha = compute_shoulder_angle(p1, target);
+    *beta = compute_elbow_angle(p1, target) - *alpha;
+
+    if (*beta < -M_PI)
+        *beta += 2 * M_PI;
+    if (*beta > M_PI)
+        *beta -= 2 * M_PI;
+
+    return 1;
+}
+
+static float angle_difference(float a, float b)
+{
+    float diff = fmodf(a - b, 2 * M_PI);
+    if (diff > M_PI)
+        diff -= 2 * M_PI;
+    if (diff < -M_PI)
+        diff += 2 * M_PI;
+    return diff;
+}
+
+TEST(CinematicsTestGroup, InverseCinematicsMatchesReference)
+{
+    shoulder_mode_t modes[] = {SHOULDER_BACK, SHOULDER_FRONT};
+    float alpha, beta, ref_alpha, ref_beta;
+    point_t target, reached;
+    int m, status, ref_status, checked = 0;
+    float x, y;
+
+    /* The grid is offset so no point lies on an axis, where both elbows are
+     * equally good and the choice depends on circle_intersect order. */
+    for (m = 0; m < 2; m++) {
+        for (x = -250.5; x < 250; x += 5) {
+            for (y = -250.5; y < 250; y += 5) {
+                target.x = x;
+                target.y = y;
+
+                status = arm_inverse_cinematics(target, arm.length, modes[m], &alpha, &beta);
+                ref_status = reference_inverse_cinematics(target, arm.length, modes[m],
+                                                          &ref_alpha, &ref_beta);
+
+                CHECK_EQUAL(ref_status, status);
+                if (!status)
+                    continue;
+
+                DOUBLES_EQUAL(0, angle_difference(ref_alpha, alpha), 1e-3);
+                DOUBLES_EQUAL(0, angle_difference(ref_beta, beta), 1e-3);
+
+                reached = arm_forward_cinematics(alpha, beta, arm.length);
+                DOUBLES_EQUAL(target.x, reached.x, 1e-1);
+                DOUBLES_EQUAL(target.y, reached.y, 1e-1);
+
+                checked++;
+            }
+        }
+    }
+
+    /* Makes sure the grid actually covers the workspace. */
+    CHECK(checked > 1000);
+}
+
+TEST(CinematicsTestGroup, InverseCinematicsFailsWhenTooFar)
+{
+    point_t target = {100., 100.};
+    float length[] = {10., 10.};
+    float alpha, beta;
+
+    CHECK_EQUAL(0, arm_inverse_cinematics(target, length, SHOULDER_BACK, &alpha, &beta));
+}
+
+TEST(CinematicsTestGroup, InverseCinematicsFullyExtended)
+{
+    point_t target = {0., 200.};
+    float length[] = {100., 100.};
+    float alpha, beta;
+
+    CHECK_EQUAL(1, arm_inverse_cinematics(target, length, SHOULDER_BACK, &alpha, &beta));
+    DOUBLES_EQUAL(M_PI / 2, alpha, 1e-3);
+    DOUBLES_EQUAL(0, beta, 1e-2);
+}
+
+/* Hand position for joint angles, beta being relative to the first segment. */
+static void hand_position(float alpha, float beta, float length[2], double pos[2])
+{
+    pos[0] = length[0] * cos(alpha) + length[1] * cos(alpha + beta);
+    pos[1] = length[0] * sin(alpha) + length[1] * sin(alpha + beta);
+}
+
+TEST(CinematicsTestGroup, JointDerivativesMatchHandDerivatives)
+{
+    float length[] = {100., 80.};
+    float alpha = 0.3, beta = 1.2;
+    float velocity[] = {50., -20.}, acceleration[] = {-30., 100.};
+    float joint_velocity[2], joint_acceleration[2];
+    double before[2], now[2], after[2];
+    const double h = 1e-2;
+    int i;
+
+    CHECK_EQUAL(1, arm_inverse_cinematics_derivatives(alpha, beta, length,
+                                                      velocity, acceleration,
+                                                      joint_velocity, joint_acceleration));
+
+    /* Moves the joints along a parabola and differentiates the hand position. */
+    hand_position(alpha - joint_velocity[0] * h + 0.5 * joint_acceleration[0] * h * h,
+                  beta - joint_velocity[1] * h + 0.5 * joint_acceleration[1] * h * h,
+                  length, before);
+    hand_position(alpha, beta, length, now);
+    hand_position(alpha + joint_velocity[0] * h + 0.5 * joint_acceleration[0] * h * h,
+                  beta + joint_velocity[1] * h + 0.5 * joint_acceleration[1] * h * h,
+                  length, after);
+
+    for (i = 0; i < 2; i++) {
+        DOUBLES_EQUAL(velocity[i], (after[i] - before[i]) / (2 * h), 0.5);
+        DOUBLES_EQUAL(acceleration[i], (after[i] - 2 * now[i] + before[i]) / (h * h), 5.);
+    }
+}
+
+TEST(CinematicsTestGroup, JointDerivativesAreZeroAtSingularity)
+{
+    float length[] = {100., 100.};
+    float velocity[] = {50., 50.}, acceleration[] = {10., 10.};
+    float joint_velocity[2], joint_acceleration[2];
+
+    CHECK_EQUAL(0, arm_inverse_cinematics_derivatives(0.5, 0., length,
+                                                      velocity, acceleration,
+                                                      joint_velocity, joint_acceleration));
+    CHECK_EQUAL(0, joint_velocity[0]);
+    CHECK_EQUAL(0, joint_velocity[1]);
+    CHECK_EQUAL(0, joint_acceleration[0]);
+    CHECK_EQUAL(0, joint_acceleration[1]);
+}
@@ -5,11 +5,13 @@ extern "C" {
 }
 
 static int pwm_called;
+static int32_t pwm_value;
 static int get_encoder_called;
 
 static void pwm(void *p, int32_t v)
 {
     pwm_called++;
+    pwm_value = v;
 }
 
 static int32_t get_encoder(void *p)
@@ -54,3 +56,33 @@ TEST(ArmControlTestGroup, ProcessInCalled)
     arm_cs_manage(&loop);
     CHECK_EQUAL(1, get_encoder_called);
 }
+
+TEST(ArmControlTestGroup, FeedforwardIsZeroByDefault)
+{
+    arm_cs_set_reference_derivatives(&loop, 100., 1000.);
+    CHECK_EQUAL(0, loop.feedforward);
+}
+
+TEST(ArmControlTestGroup, FeedforwardIsAddedToOutput)
+{
+    arm_cs_connect_motor(&loop, pwm, NULL);
+    arm_cs_connect_encoder(&loop, get_encoder, NULL);
+    arm_cs_manage(&loop);
+    int32_t pid_output = pwm_value;
+
+    arm_cs_set_feedforward_gains(&loop, 2., 0.5);
+    arm_cs_set_reference_derivatives(&loop, 100., 40.);
+    arm_cs_manage(&loop);
+
+    CHECK_EQUAL(pid_output + 220, pwm_value);
+}
+
+TEST(ArmControlTestGroup, DisableClearsFeedforward)
+{
+    arm_cs_set_feedforward_gains(&loop, 2., 0.5);
+    arm_cs_set_reference_derivatives(&loop, 100., 40.);
+    arm_cs_disable(&loop);
+
+    CHECK_EQUAL(0, loop.feedforward);
+    CHECK_FALSE(loop.manager.enabled);
+}
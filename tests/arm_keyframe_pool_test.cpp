@@ -0,0 +1,153 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../arm_keyframe_pool.h"
+#include "../arm_trajectories.h"
+}
+
+#define POOL_SLABS 8
+#define POOL_FRAMES (POOL_SLABS * ARM_KEYFRAME_POOL_SLAB_FRAMES)
+
+TEST_GROUP(ArmKeyframePoolTest)
+{
+    arm_keyframe_t buffer[POOL_FRAMES];
+    arm_keyframe_pool_stats_t stats;
+
+    void setup()
+    {
+        arm_keyframe_pool_init(buffer, POOL_FRAMES);
+    }
+
+    void teardown()
+    {
+        /* Other tests expect trajectories on the heap. */
+        arm_keyframe_pool_init(NULL, 0);
+    }
+
+    bool in_pool(arm_keyframe_t *frames)
+    {
+        return frames >= buffer && frames < buffer + POOL_FRAMES;
+    }
+};
+
+TEST(ArmKeyframePoolTest, AllocatesFromBuffer)
+{
+    arm_keyframe_t *frames = arm_keyframe_pool_alloc(3);
+    CHECK(in_pool(frames));
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(POOL_SLABS, stats.slab_count);
+    CHECK_EQUAL(1, stats.used_slabs);
+
+    arm_keyframe_pool_free(frames);
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(0, stats.used_slabs);
+    CHECK_EQUAL(1, stats.high_water_mark);
+}
+
+TEST(ArmKeyframePoolTest, AllocationsDoNotOverlap)
+{
+    arm_keyframe_t *a = arm_keyframe_pool_alloc(ARM_KEYFRAME_POOL_SLAB_FRAMES);
+    arm_keyframe_t *b = arm_keyframe_pool_alloc(2 * ARM_KEYFRAME_POOL_SLAB_FRAMES);
+
+    CHECK(in_pool(a));
+    CHECK(in_pool(b));
+    CHECK(b >= a + ARM_KEYFRAME_POOL_SLAB_FRAMES || a >= b + 2 * ARM_KEYFRAME_POOL_SLAB_FRAMES);
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(3, stats.used_slabs);
+
+    arm_keyframe_pool_free(a);
+    arm_keyframe_pool_free(b);
+}
+
+TEST(ArmKeyframePoolTest, GrowsInPlaceWhenPossible)
+{
+    arm_keyframe_t *frames = arm_keyframe_pool_alloc(ARM_KEYFRAME_POOL_SLAB_FRAMES);
+    arm_keyframe_t *grown;
+
+    frames[0].position[0] = 42;
+    grown = arm_keyframe_pool_realloc(frames, 2 * ARM_KEYFRAME_POOL_SLAB_FRAMES);
+
+    POINTERS_EQUAL(frames, grown);
+    CHECK_EQUAL(42, grown[0].position[0]);
+
+    arm_keyframe_pool_free(grown);
+}
+
+TEST(ArmKeyframePoolTest, MovesBlockWhenNextSlabIsUsed)
+{
+    arm_keyframe_t *a = arm_keyframe_pool_alloc(ARM_KEYFRAME_POOL_SLAB_FRAMES);
+    arm_keyframe_t *b = arm_keyframe_pool_alloc(ARM_KEYFRAME_POOL_SLAB_FRAMES);
+    arm_keyframe_t *grown;
+
+    a[7].position[0] = 42;
+    grown = arm_keyframe_pool_realloc(a, 2 * ARM_KEYFRAME_POOL_SLAB_FRAMES);
+
+    CHECK(grown != a);
+    CHECK(in_pool(grown));
+    CHECK_EQUAL(42, grown[7].position[0]);
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(3, stats.used_slabs);
+
+    arm_keyframe_pool_free(b);
+    arm_keyframe_pool_free(grown);
+}
+
+TEST(ArmKeyframePoolTest, FallsBackToHeapWhenFull)
+{
+    arm_keyframe_t *frames = arm_keyframe_pool_alloc(POOL_FRAMES + 1);
+
+    CHECK(!in_pool(frames));
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(1, stats.heap_fallbacks);
+    CHECK_EQUAL(0, stats.used_slabs);
+
+    arm_keyframe_pool_free(frames);
+}
+
+TEST(ArmKeyframePoolTest, FragmentationIsComputed)
+{
+    arm_keyframe_t *blocks[POOL_SLABS];
+    int i;
+
+    for (i = 0; i < POOL_SLABS; i++)
+        blocks[i] = arm_keyframe_pool_alloc(1);
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(0, arm_keyframe_pool_fragmentation(&stats));
+
+    /* Free every other slab: 4 free slabs, but at most 1 contiguous. */
+    for (i = 0; i < POOL_SLABS; i += 2)
+        arm_keyframe_pool_free(blocks[i]);
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(1, stats.largest_free_run);
+    CHECK_EQUAL(75, arm_keyframe_pool_fragmentation(&stats));
+
+    for (i = 1; i < POOL_SLABS; i += 2)
+        arm_keyframe_pool_free(blocks[i]);
+
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(POOL_SLABS, stats.largest_free_run);
+    CHECK_EQUAL(0, arm_keyframe_pool_fragmentation(&stats));
+}
+
+TEST(ArmKeyframePoolTest, TrajectoriesUsePool)
+{
+    arm_trajectory_t traj;
+    int i;
+
+    arm_trajectory_init(&traj);
+
+    for (i = 0; i < 20; i++)
+        arm_trajectory_append_point(&traj, i, 10, 10, COORDINATE_ARM, 1.);
+
+    CHECK(in_pool(traj.frames));
+    CHECK_EQUAL(19, traj.frames[19].position[0]);
+
+    arm_trajectory_delete(&traj);
+    arm_keyframe_pool_get_stats(&stats);
+    CHECK_EQUAL(0, stats.used_slabs);
+}
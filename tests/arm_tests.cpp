@@ -26,7 +26,20 @@ TEST_GROUP(ArmTestGroup)
     {
         uptime_set(0);
         arm_trajectory_delete(&traj);
-        arm_trajectory_delete(&arm.trajectory);
+        arm_trajectory_delete(&arm.trajectory_buffers[0]);
+        arm_trajectory_delete(&arm.trajectory_buffers[1]);
+    }
+
+    arm_trajectory_t *published_trajectory()
+    {
+        return &arm.trajectory_buffers[arm.published_trajectory];
+    }
+
+    /* Publishes traj and lets arm_manage take it, like the cinematics task. */
+    void start_trajectory()
+    {
+        arm_do_trajectory(&arm, &traj);
+        arm_manage(&arm);
     }
 };
 
@@ -81,8 +94,8 @@ TEST(ArmTestGroup, ExecuteTrajectoryCopiesData)
     arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 10.);
 
     arm_do_trajectory(&arm, &traj);
-    CHECK_EQUAL(traj.frame_count, arm.trajectory.frame_count);
-    CHECK(0 == memcmp(traj.frames, arm.trajectory.frames, sizeof(arm_keyframe_t) * traj.frame_count));
+    CHECK_EQUAL(traj.frame_count, published_trajectory()->frame_count);
+    CHECK(0 == memcmp(traj.frames, published_trajectory()->frames, sizeof(arm_keyframe_t) * traj.frame_count));
 }
 
 TEST(ArmTestGroup, ExecuteTrajectoryIsAtomic)
@@ -95,7 +108,7 @@ TEST(ArmTestGroup, ExecuteTrajectoryIsAtomic)
     CHECK_EQUAL(1, arm.trajectory_semaphore.count);
 }
 
-TEST(ArmTestGroup, ArmManageIsAtomic)
+TEST(ArmTestGroup, ArmManageDoesNotBlock)
 {
     arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 10.);
@@ -103,18 +116,18 @@ TEST(ArmTestGroup, ArmManageIsAtomic)
 
     CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     arm_manage(&arm);
-    CHECK_EQUAL(2, arm.trajectory_semaphore.acquired_count);
+    CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     CHECK_EQUAL(1, arm.trajectory_semaphore.count);
 
 }
 
-TEST(ArmTestGroup, ArmManageIsAtomicWithEmptyTraj)
+TEST(ArmTestGroup, ArmManageDoesNotBlockWithEmptyTraj)
 {
     arm_do_trajectory(&arm, &traj);
 
     CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     arm_manage(&arm);
-    CHECK_EQUAL(2, arm.trajectory_semaphore.acquired_count);
+    CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     CHECK_EQUAL(1, arm.trajectory_semaphore.count);
 }
 
@@ -125,14 +138,14 @@ TEST(ArmTestGroup, ArmShutdownIsAtomic)
     CHECK_EQUAL(1, arm.trajectory_semaphore.count);
 }
 
-TEST(ArmTestGroup, ArmManageIsAtomicWithUnreachableTarget)
+TEST(ArmTestGroup, ArmManageDoesNotBlockWithUnreachableTarget)
 {
     arm_trajectory_append_point_with_length(&traj, 100, 100, 10, COORDINATE_ARM, 1., 10, 10);
     arm_do_trajectory(&arm, &traj);
 
     CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     arm_manage(&arm);
-    CHECK_EQUAL(2, arm.trajectory_semaphore.acquired_count);
+    CHECK_EQUAL(1, arm.trajectory_semaphore.acquired_count);
     CHECK_EQUAL(1, arm.trajectory_semaphore.count);
 }
 
@@ -148,7 +161,7 @@ TEST(ArmTestGroup, ArmManageEmptyTrajectoryDisablesControl)
 TEST(ArmTestGroup, ArmManageUpdatesLastLoop)
 {
     uptime_set(42);
-    CHECK_EQUAL(0, arm.trajectory.frame_count);
+    CHECK_EQUAL(0, arm.trajectory_buffers[arm.active_trajectory].frame_count);
     arm_manage(&arm);
     CHECK_EQUAL(42, arm.last_loop)
 }
@@ -232,7 +245,7 @@ TEST(ArmTestGroup, CurrentPointComputation)
     uptime_set(0);
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ARM, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(result.position[0], 5., 0.1);
@@ -245,7 +258,7 @@ TEST(ArmTestGroup, CurrentPointSelectFrame)
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ARM, 10.);
     arm_trajectory_append_point(&traj, 10, 30, 0, COORDINATE_ARM, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(25, result.position[1], 0.1);
@@ -258,7 +271,7 @@ TEST(ArmTestGroup, CurrentPointPastEnd)
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ARM, 10.);
     arm_trajectory_append_point(&traj, 10, 30, 0, COORDINATE_ARM, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(30, result.position[1], 0.1);
@@ -271,7 +284,7 @@ TEST(ArmTestGroup, MixedCoordinateSystems)
     arm.offset_rotation = M_PI / 2;
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ROBOT, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(10, result.position[0], 0.1);
@@ -300,7 +313,7 @@ TEST(ArmTestGroup, TableCoordinateSystem)
 
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_TABLE, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_TABLE, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(20, result.position[0], 0.1);
@@ -317,7 +330,7 @@ TEST(ArmTestGroup, TrajectoriesFirstPointTableNotHandledCorrectly)
     arm.offset_rotation = M_PI / 2;
     arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ROBOT, 10.);
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(20, result.position[0], 0.1);
@@ -332,9 +345,239 @@ TEST(ArmTestGroup, LengthAreInterpolated)
     arm_trajectory_append_point_with_length(&traj, 0, 0, 0, COORDINATE_ARM, 1., 10, 10);
     arm_trajectory_append_point_with_length(&traj, 0, 0, 0, COORDINATE_ARM, 10., 100, 200);
 
-    arm_do_trajectory(&arm, &traj);
+    start_trajectory();
 
     result = arm_position_for_date(&arm, date);
     DOUBLES_EQUAL(55, result.length[0], 0.1);
     DOUBLES_EQUAL(105, result.length[1], 0.1);
 }
+
+TEST(ArmTestGroup, CurrentPointBeforeStart)
+{
+    arm_keyframe_t result;
+    uptime_set(10 * 1000000);
+    arm_trajectory_append_point(&traj, 0, 10, 0, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ARM, 10.);
+    start_trajectory();
+
+    result = arm_position_for_date(&arm, 0);
+    DOUBLES_EQUAL(10, result.position[1], 0.1);
+}
+
+TEST(ArmTestGroup, PositionWithoutTrajectory)
+{
+    arm_keyframe_t result;
+
+    result = arm_position_for_date(&arm, 0);
+    DOUBLES_EQUAL(0, result.position[0], 0.1);
+    DOUBLES_EQUAL(0, result.position[1], 0.1);
+}
+
+TEST(ArmTestGroup, LongTrajectoryScan)
+{
+    const int frame_count = 10000;
+    arm_keyframe_t result;
+    int32_t date;
+    int i;
+
+    for (i = 0; i < frame_count; i++)
+        arm_trajectory_append_point(&traj, i, 0, 0, COORDINATE_ARM, 0.01);
+    start_trajectory();
+
+    /* Scans the whole trajectory forward, like arm_manage does. */
+    for (i = 1; i < frame_count; i++) {
+        date = (traj.frames[i-1].date + traj.frames[i].date) / 2;
+        result = arm_position_for_date(&arm, date);
+        DOUBLES_EQUAL(i - 0.5, result.position[0], 0.1);
+
+        result = arm_position_for_date(&arm, traj.frames[i].date);
+        DOUBLES_EQUAL(i, result.position[0], 0.1);
+    }
+}
+
+TEST(ArmTestGroup, LongTrajectoryTimeGoesBackward)
+{
+    const int frame_count = 10000;
+    arm_keyframe_t result;
+    int32_t date;
+    int i;
+
+    for (i = 0; i < frame_count; i++)
+        arm_trajectory_append_point(&traj, i, 0, 0, COORDINATE_ARM, 0.01);
+    start_trajectory();
+
+    /* Goes to the end then scans backward. */
+    result = arm_position_for_date(&arm, traj.frames[frame_count-1].date);
+    DOUBLES_EQUAL(frame_count - 1, result.position[0], 0.1);
+
+    for (i = frame_count - 1; i > 0; i -= 7) {
+        date = (traj.frames[i-1].date + traj.frames[i].date) / 2;
+        result = arm_position_for_date(&arm, date);
+        DOUBLES_EQUAL(i - 0.5, result.position[0], 0.1);
+    }
+}
+
+TEST(ArmTestGroup, RobotCoordinatesAreConvertedOnce)
+{
+    arm.offset_rotation = M_PI / 2;
+    arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_ROBOT, 1.);
+    arm_do_trajectory(&arm, &traj);
+
+    CHECK_EQUAL(COORDINATE_ARM, published_trajectory()->frames[0].coordinate_type);
+    DOUBLES_EQUAL(20, published_trajectory()->frames[0].position[0], 0.1);
+    DOUBLES_EQUAL(-10, published_trajectory()->frames[0].position[1], 0.1);
+}
+
+TEST(ArmTestGroup, TableCoordinatesFollowRobot)
+{
+    arm_keyframe_t result;
+    struct robot_position pos;
+    position_init(&pos);
+
+    const int32_t date = 15 * 1000000;
+    arm.offset_rotation = M_PI / 2;
+
+    arm_set_related_robot_pos(&arm, &pos);
+    position_set(&pos, -10, -10, 0);
+
+    arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_TABLE, 1.);
+    arm_trajectory_append_point(&traj, 10, 20, 0, COORDINATE_TABLE, 10.);
+    start_trajectory();
+
+    result = arm_position_for_date(&arm, date);
+    DOUBLES_EQUAL(30, result.position[0], 0.1);
+    DOUBLES_EQUAL(-20, result.position[1], 0.1);
+
+    /* Moving the robot must move the target in arm frame. */
+    position_set(&pos, 0, 0, 0);
+
+    result = arm_position_for_date(&arm, date);
+    DOUBLES_EQUAL(20, result.position[0], 0.1);
+    DOUBLES_EQUAL(-10, result.position[1], 0.1);
+}
+
+TEST(ArmTestGroup, NewTrajectoryIsUsedOnNextTick)
+{
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+    arm_manage(&arm);
+
+    arm_trajectory_delete(&traj);
+    arm_trajectory_append_point(&traj, 100, 20, 10, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+
+    /* The new trajectory was written to the other buffer. */
+    CHECK(arm.published_trajectory != arm.active_trajectory);
+
+    arm_manage(&arm);
+    CHECK_EQUAL(arm.published_trajectory, arm.active_trajectory);
+    DOUBLES_EQUAL(20, arm.trajectory_buffers[arm.active_trajectory].frames[0].position[1], 0.1);
+}
+
+TEST(ArmTestGroup, LastPublishedTrajectoryWins)
+{
+    arm_trajectory_append_point(&traj, 0, 10, 0, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+
+    arm_trajectory_delete(&traj);
+    arm_trajectory_append_point(&traj, 0, 20, 0, COORDINATE_ARM, 1.);
+    start_trajectory();
+
+    DOUBLES_EQUAL(20, arm_position_for_date(&arm, 0).position[1], 0.1);
+}
+
+TEST(ArmTestGroup, PositionQueryDoesNotTakeTrajectory)
+{
+    arm_trajectory_append_point(&traj, 0, 10, 0, COORDINATE_ARM, 1.);
+    start_trajectory();
+
+    arm_trajectory_delete(&traj);
+    arm_trajectory_append_point(&traj, 0, 20, 0, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+
+    /* Only arm_manage switches to the new trajectory. */
+    DOUBLES_EQUAL(10, arm_position_for_date(&arm, 0).position[1], 0.1);
+    CHECK(arm.published_trajectory != arm.active_trajectory);
+}
+
+TEST(ArmTestGroup, TrajectoryBeingWrittenIsIgnored)
+{
+    arm_trajectory_append_point(&traj, 100, 10, 0, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+    arm_manage(&arm);
+
+    /* Simulates a writer preempted in the middle of a copy. */
+    arm.trajectory_seq++;
+    arm.trajectory_buffers[1 - arm.active_trajectory].frame_count = 0;
+
+    arm_manage(&arm);
+    DOUBLES_EQUAL(10, arm_position_for_date(&arm, 0).position[1], 0.1);
+    CHECK_EQUAL(1, arm.shoulder.manager.enabled);
+}
+
+TEST(ArmTestGroup, TrajectoryFinishedUsesPublishedTrajectory)
+{
+    uptime_set(0);
+    CHECK(arm_is_trajectory_finished(&arm));
+
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 10.);
+    arm_do_trajectory(&arm, &traj);
+
+    /* Not started by arm_manage yet, but must not be reported as finished. */
+    CHECK_FALSE(arm_is_trajectory_finished(&arm));
+
+    uptime_set(20 * 1000000);
+    CHECK(arm_is_trajectory_finished(&arm));
+}
+
+TEST(ArmTestGroup, ManageReportsTrajectoryEnd)
+{
+    uptime_set(0);
+    CHECK(arm_manage(&arm));
+
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 10.);
+    arm_do_trajectory(&arm, &traj);
+    CHECK_FALSE(arm_manage(&arm));
+
+    uptime_set(20 * 1000000);
+    CHECK(arm_manage(&arm));
+
+    /* Neither is a trajectory still being written. */
+    arm_do_trajectory(&arm, &traj);
+    arm.trajectory_seq++;
+    CHECK_FALSE(arm_manage(&arm));
+    arm.trajectory_seq++;
+}
+
+TEST(ArmTestGroup, IdleArmHasNoManagePeriod)
+{
+    CHECK_EQUAL(0, arm_get_manage_period(&arm));
+}
+
+TEST(ArmTestGroup, PublishedTrajectoryWakesUpArm)
+{
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+    CHECK_EQUAL(ARM_DEFAULT_MANAGE_PERIOD, arm_get_manage_period(&arm));
+
+    arm_set_manage_period(&arm, 5000);
+    arm_manage(&arm);
+    CHECK_EQUAL(5000, arm_get_manage_period(&arm));
+}
+
+TEST(ArmTestGroup, ShutdownArmRunsOnceMoreThenIdles)
+{
+    arm_trajectory_append_point(&traj, 100, 10, 10, COORDINATE_ARM, 1.);
+    arm_do_trajectory(&arm, &traj);
+    arm_manage(&arm);
+
+    arm_shutdown(&arm);
+
+    /* Must run once to disable the control systems. */
+    CHECK(arm_get_manage_period(&arm) > 0);
+    arm_manage(&arm);
+    CHECK_EQUAL(0, arm.shoulder.manager.enabled);
+    CHECK_EQUAL(0, arm_get_manage_period(&arm));
+}
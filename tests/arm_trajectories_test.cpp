@@ -16,7 +16,7 @@ TEST_GROUP(ArmTrajectoriesBuilderTest)
 
     void teardown()
     {
-        free(traj.frames);
+        arm_trajectory_delete(&traj);
         uptime_set(0);
     }
 };
@@ -59,6 +59,7 @@ TEST(ArmTrajectoriesBuilderTest, DeleteTrajectory)
 TEST(ArmTrajectoriesBuilderTest, CopyTrajectory)
 {
     arm_trajectory_t copy;
+    arm_trajectory_init(&copy);
     arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 1.);
     arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 10.);
 
@@ -68,6 +69,77 @@ TEST(ArmTrajectoriesBuilderTest, CopyTrajectory)
 
     /* Check that it is a full copy. */
     CHECK(traj.frames[0].position != copy.frames[0].position);
+    arm_trajectory_delete(&copy);
+}
+
+TEST(ArmTrajectoriesBuilderTest, CopyReusesDestinationBuffer)
+{
+    arm_trajectory_t copy;
+    arm_keyframe_t *buffer;
+    arm_trajectory_init(&copy);
+    arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 10.);
+
+    arm_trajectory_copy(&copy, &traj);
+    buffer = copy.frames;
+
+    arm_trajectory_copy(&copy, &traj);
+    POINTERS_EQUAL(buffer, copy.frames);
+    CHECK_EQUAL(2, copy.frame_count);
+    arm_trajectory_delete(&copy);
+}
+
+TEST(ArmTrajectoriesBuilderTest, CapacityGrowsGeometrically)
+{
+    int i;
+
+    for (i = 0; i < 100; i++)
+        arm_trajectory_append_point(&traj, i, 10, 10, COORDINATE_ARM, 1.);
+
+    CHECK_EQUAL(100, traj.frame_count);
+    CHECK_EQUAL(128, traj.capacity);
+    CHECK_EQUAL(99, traj.frames[99].position[0]);
+}
+
+TEST(ArmTrajectoriesBuilderTest, DeleteReleasesCapacity)
+{
+    arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_delete(&traj);
+    CHECK_EQUAL(0, traj.capacity);
+    POINTERS_EQUAL(NULL, traj.frames);
+}
+
+TEST(ArmTrajectoriesBuilderTest, StaticTrajectoryUsesCallerBuffer)
+{
+    arm_trajectory_t t;
+    arm_keyframe_t buffer[4];
+
+    arm_trajectory_init_static(&t, buffer, 4);
+    arm_trajectory_append_point(&t, 10, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&t, 20, 10, 10, COORDINATE_ARM, 1.);
+
+    POINTERS_EQUAL(buffer, t.frames);
+    CHECK_EQUAL(2, t.frame_count);
+    CHECK_EQUAL(20, buffer[1].position[0]);
+
+    /* Deleting only empties the trajectory, the buffer can be reused. */
+    arm_trajectory_delete(&t);
+    CHECK_EQUAL(0, t.frame_count);
+    POINTERS_EQUAL(buffer, t.frames);
+}
+
+TEST(ArmTrajectoriesBuilderTest, CanCopyToStaticTrajectory)
+{
+    arm_trajectory_t t;
+    arm_keyframe_t buffer[4];
+
+    arm_trajectory_init_static(&t, buffer, 4);
+    arm_trajectory_append_point(&traj, 10, 10, 10, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 20, 10, 10, COORDINATE_ARM, 1.);
+
+    arm_trajectory_copy(&t, &traj);
+    POINTERS_EQUAL(buffer, t.frames);
+    CHECK_EQUAL(20, buffer[1].position[0]);
 }
 
 TEST(ArmTrajectoriesBuilderTest, EmptyTrajectoryIsFinished)
@@ -108,3 +180,35 @@ TEST(ArmTrajectoriesBuilderTest, KeyframeInterpolation)
     DOUBLES_EQUAL(150., result.length[1], 0.1);
 }
 
+
+TEST(ArmTrajectoriesBuilderTest, DerivativesAreZeroAtSegmentEnds)
+{
+    arm_keyframe_derivatives_t result;
+    arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 10, 20, 30, COORDINATE_ARM, 2.);
+
+    result = arm_trajectory_interpolate_derivatives(traj.frames[0], traj.frames[1], traj.frames[0].date);
+    DOUBLES_EQUAL(0., result.velocity[0], 1e-6);
+    DOUBLES_EQUAL(0., result.velocity[2], 1e-6);
+
+    result = arm_trajectory_interpolate_derivatives(traj.frames[0], traj.frames[1], traj.frames[1].date);
+    DOUBLES_EQUAL(0., result.velocity[1], 1e-6);
+    DOUBLES_EQUAL(0., result.acceleration[1], 1e-6);
+}
+
+TEST(ArmTrajectoriesBuilderTest, VelocityPeaksAtSegmentMiddle)
+{
+    arm_keyframe_derivatives_t result;
+    int32_t middle;
+    arm_trajectory_append_point(&traj, 0, 0, 0, COORDINATE_ARM, 1.);
+    arm_trajectory_append_point(&traj, 10, 20, 30, COORDINATE_ARM, 2.);
+
+    middle = (traj.frames[0].date + traj.frames[1].date) / 2;
+    result = arm_trajectory_interpolate_derivatives(traj.frames[0], traj.frames[1], middle);
+
+    /* Smoothstep peak speed is 1.875 times the mean speed, over 2 seconds. */
+    DOUBLES_EQUAL(1.875 * 10 / 2., result.velocity[0], 1e-3);
+    DOUBLES_EQUAL(1.875 * 20 / 2., result.velocity[1], 1e-3);
+    DOUBLES_EQUAL(1.875 * 30 / 2., result.velocity[2], 1e-3);
+    DOUBLES_EQUAL(0., result.acceleration[0], 1e-3);
+}
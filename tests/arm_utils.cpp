@@ -47,3 +47,23 @@ TEST(ArmUtilsTestGroup, CoordinateTableToRobot45Deg)
     DOUBLES_EQUAL(sqrt(2)*100., result.x, 1e-2);
     DOUBLES_EQUAL(0., result.y, 1e-2);
 }
+
+TEST(ArmUtilsTestGroup, TableToArmTransformMatchesCoordinateChanges)
+{
+    point_t target = {300, 200};
+    point_t robot_pos = {100, 50};
+    float robot_a_rad = 0.7;
+    vect2_cart offset_xy = {10, 87.5};
+    float offset_angle = M_PI/2.;
+    arm_transform_t t;
+    point_t expected, result;
+
+    expected = arm_coordinate_table2robot(target, robot_pos, robot_a_rad);
+    expected = arm_coordinate_robot2arm(expected, offset_xy, offset_angle);
+
+    arm_transform_table2arm(&t, robot_pos, robot_a_rad, offset_xy, offset_angle);
+    result = arm_transform_apply(&t, target);
+
+    DOUBLES_EQUAL(expected.x, result.x, 1e-2);
+    DOUBLES_EQUAL(expected.y, result.y, 1e-2);
+}
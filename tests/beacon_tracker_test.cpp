@@ -0,0 +1,151 @@
+#include "CppUTest/TestHarness.h"
+#include <cmath>
+
+extern "C" {
+#include "../beacon_tracker.h"
+}
+
+TEST_GROUP(BeaconTrackerTestGroup)
+{
+    beacon_tracker_t tracker;
+    beacon_track_t tracks[BEACON_TRACKER_MAX_TRACKS];
+
+    void setup()
+    {
+        beacon_tracker_init(&tracker);
+    }
+
+    void see(float direction, float distance, float robot_x, float robot_a, int32_t date)
+    {
+        beacon_tracker_reading_t reading = {direction, distance};
+        beacon_tracker_update(&tracker, &reading, 1, robot_x, 0, robot_a, date);
+    }
+};
+
+TEST(BeaconTrackerTestGroup, NoTrackAtInit)
+{
+    CHECK_EQUAL(0, beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 0));
+}
+
+TEST(BeaconTrackerTestGroup, ReadingCreatesTrackInTableFrame)
+{
+    int n;
+
+    see(90, 500, 100, M_PI / 2, 0);
+    n = beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 0);
+
+    CHECK_EQUAL(1, n);
+    DOUBLES_EQUAL(-400, tracks[0].x, 0.1);
+    DOUBLES_EQUAL(0, tracks[0].y, 0.1);
+}
+
+TEST(BeaconTrackerTestGroup, EmptyReadingIsIgnored)
+{
+    see(0, 0, 0, 0, 0);
+    CHECK_EQUAL(0, beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 0));
+}
+
+TEST(BeaconTrackerTestGroup, VelocityConverges)
+{
+    int32_t date;
+
+    /* Opponent at 1000 mm moving at 200 mm/s, seen every 100 ms. */
+    for (date = 0; date <= 3000000; date += 100000)
+        see(0, 1000 + 200 * date / 1e6f, 0, 0, date);
+
+    beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, date);
+
+    DOUBLES_EQUAL(200, tracks[0].vx, 5);
+    DOUBLES_EQUAL(0, tracks[0].vy, 1);
+    DOUBLES_EQUAL(1000 + 200 * date / 1e6f, tracks[0].x, 10);
+}
+
+TEST(BeaconTrackerTestGroup, RepeatedReadingIsNotAMeasure)
+{
+    /* The robot moved but the beacon did not refresh. */
+    see(0, 1000, 0, 0, 0);
+    see(0, 1000, 100, 0, 100000);
+
+    beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 100000);
+
+    DOUBLES_EQUAL(1000, tracks[0].x, 0.1);
+    DOUBLES_EQUAL(0, tracks[0].vx, 0.1);
+    CHECK_EQUAL(1, tracks[0].hits);
+}
+
+TEST(BeaconTrackerTestGroup, RepeatedReadingKeepsTrackAlive)
+{
+    int32_t date;
+
+    for (date = 0; date < 2 * BEACON_TRACKER_TIMEOUT; date += 100000)
+        see(0, 1000, 0, 0, date);
+
+    CHECK_EQUAL(1, beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, date));
+}
+
+TEST(BeaconTrackerTestGroup, LostTrackIsDropped)
+{
+    see(0, 1000, 0, 0, 0);
+    see(0, 0, 0, 0, BEACON_TRACKER_TIMEOUT + 1);
+
+    CHECK_EQUAL(0, beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 0));
+}
+
+TEST(BeaconTrackerTestGroup, TwoOpponentsAreTrackedSeparately)
+{
+    beacon_tracker_reading_t readings[2] = {{0, 1000}, {180, 1000}};
+    int n;
+
+    beacon_tracker_update(&tracker, readings, 2, 0, 0, 0, 0);
+    readings[0].distance = 1010;
+    readings[1].distance = 990;
+    beacon_tracker_update(&tracker, readings, 2, 0, 0, 0, 100000);
+
+    n = beacon_tracker_get_tracks(&tracker, tracks, BEACON_TRACKER_MAX_TRACKS, 100000);
+
+    CHECK_EQUAL(2, n);
+    CHECK_EQUAL(2, tracks[0].hits);
+    CHECK_EQUAL(2, tracks[1].hits);
+    CHECK(tracks[0].vx > 0);
+    CHECK(tracks[1].vx > 0);
+}
+
+TEST(BeaconTrackerTestGroup, TimeToCollisionWithStillOpponent)
+{
+    int32_t ttc;
+
+    see(0, 1500, 0, 0, 0);
+    ttc = beacon_tracker_time_to_collision(&tracker, 0, 0, 500, 0, 500, 0);
+
+    CHECK_EQUAL(2000, ttc);
+}
+
+TEST(BeaconTrackerTestGroup, NoCollisionWhenPassingBy)
+{
+    int32_t ttc;
+
+    see(45, 1414, 0, 0, 0);
+    ttc = beacon_tracker_time_to_collision(&tracker, 0, 0, 500, 0, 500, 0);
+
+    CHECK_EQUAL(BEACON_TRACKER_NO_COLLISION, ttc);
+}
+
+TEST(BeaconTrackerTestGroup, OpponentBehindIsIgnored)
+{
+    int32_t ttc;
+
+    see(180, 1000, 0, 0, 0);
+    ttc = beacon_tracker_time_to_collision(&tracker, 0, 0, 500, 0, 500, 0);
+
+    CHECK_EQUAL(BEACON_TRACKER_NO_COLLISION, ttc);
+}
+
+TEST(BeaconTrackerTestGroup, OpponentTooCloseCollidesNow)
+{
+    int32_t ttc;
+
+    see(0, 300, 0, 0, 0);
+    ttc = beacon_tracker_time_to_collision(&tracker, 0, 0, 500, 0, 500, 0);
+
+    CHECK_EQUAL(0, ttc);
+}
@@ -0,0 +1,159 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include <uptime.h>
+#include "../console_output.h"
+}
+
+static char sent[4 * CONSOLE_OUTPUT_SIZE];
+static int sent_len;
+static int send_count;
+
+static void send(void *arg, const char *data, int len)
+{
+    (void)arg;
+    memcpy(&sent[sent_len], data, len);
+    sent_len += len;
+    send_count++;
+}
+
+TEST_GROUP(ConsoleOutputTestGroup)
+{
+    console_output_t o;
+
+    void setup()
+    {
+        sent_len = 0;
+        send_count = 0;
+        uptime_set(0);
+        console_output_init(&o, send, NULL);
+    }
+
+    void teardown()
+    {
+        uptime_set(0);
+    }
+};
+
+TEST(ConsoleOutputTestGroup, WritesAreBuffered)
+{
+    console_output_puts(&o, "hello");
+    console_output_puts(&o, "\r\n");
+
+    CHECK_EQUAL(0, send_count);
+}
+
+TEST(ConsoleOutputTestGroup, FlushSendsEverythingAtOnce)
+{
+    console_output_puts(&o, "hello");
+    console_output_puts(&o, "\r\n");
+    console_output_flush(&o);
+
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL(7, sent_len);
+    CHECK_EQUAL(0, memcmp("hello\r\n", sent, 7));
+}
+
+TEST(ConsoleOutputTestGroup, EmptyFlushSendsNothing)
+{
+    console_output_flush(&o);
+    CHECK_EQUAL(0, send_count);
+}
+
+TEST(ConsoleOutputTestGroup, FullBufferIsSent)
+{
+    char line[CONSOLE_OUTPUT_SIZE / 4];
+    int i;
+
+    memset(line, 'a', sizeof(line));
+
+    for (i = 0; i < 4; i++)
+        console_output_write(&o, line, sizeof(line));
+
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL(CONSOLE_OUTPUT_SIZE, sent_len);
+    CHECK_EQUAL(0, o.len);
+}
+
+TEST(ConsoleOutputTestGroup, WriteWhichDoesNotFitFlushesFirst)
+{
+    char line[CONSOLE_OUTPUT_SIZE - 1];
+
+    memset(line, 'a', sizeof(line));
+
+    console_output_puts(&o, "xy");
+    console_output_write(&o, line, sizeof(line));
+
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL(2, sent_len);
+    CHECK_EQUAL(sizeof(line), o.len);
+}
+
+TEST(ConsoleOutputTestGroup, LargeWriteIsSentDirectly)
+{
+    char block[2 * CONSOLE_OUTPUT_SIZE];
+
+    memset(block, 'b', sizeof(block));
+
+    console_output_puts(&o, "x");
+    console_output_write(&o, block, sizeof(block));
+
+    CHECK_EQUAL(2, send_count);
+    CHECK_EQUAL(1 + sizeof(block), sent_len);
+    CHECK_EQUAL('x', sent[0]);
+    CHECK_EQUAL(0, o.len);
+}
+
+TEST(ConsoleOutputTestGroup, OldDataIsSentOnNextWrite)
+{
+    console_output_puts(&o, "a");
+    uptime_set(CONSOLE_OUTPUT_FLUSH_DELAY - 1);
+    console_output_puts(&o, "b");
+    CHECK_EQUAL(0, send_count);
+
+    uptime_set(CONSOLE_OUTPUT_FLUSH_DELAY);
+    console_output_puts(&o, "c");
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL(0, memcmp("abc", sent, 3));
+}
+
+TEST(ConsoleOutputTestGroup, AgeRestartsAfterFlush)
+{
+    console_output_puts(&o, "a");
+    uptime_set(CONSOLE_OUTPUT_FLUSH_DELAY);
+    console_output_flush(&o);
+
+    console_output_puts(&o, "b");
+    CHECK_EQUAL(1, send_count);
+}
+
+TEST(ConsoleOutputTestGroup, PollOnlySendsOldData)
+{
+    console_output_puts(&o, "a");
+
+    uptime_set(CONSOLE_OUTPUT_FLUSH_DELAY - 1);
+    console_output_poll(&o);
+    CHECK_EQUAL(0, send_count);
+
+    uptime_set(CONSOLE_OUTPUT_FLUSH_DELAY);
+    console_output_poll(&o);
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL('a', sent[0]);
+}
+
+TEST(ConsoleOutputTestGroup, ClosedOutputSendsNothing)
+{
+    console_output_puts(&o, "a");
+    console_output_close(&o);
+
+    console_output_puts(&o, "b");
+    console_output_flush(&o);
+    CHECK_EQUAL(0, send_count);
+
+    console_output_open(&o, send, NULL);
+    console_output_puts(&o, "c");
+    console_output_flush(&o);
+    CHECK_EQUAL(1, send_count);
+    CHECK_EQUAL('c', sent[0]);
+}
@@ -0,0 +1,100 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include <cvra_dc.h>
+#include "../motor_io.h"
+}
+
+#define DEVICE_SIZE 32
+
+TEST_GROUP(MotorIOTestGroup)
+{
+    int device[DEVICE_SIZE];
+    int expected[DEVICE_SIZE];
+    motor_io_t io;
+
+    void setup()
+    {
+        int i;
+
+        /* Every register is different, so we can tell which one is read. */
+        for (i = 0; i < DEVICE_SIZE; i++)
+            device[i] = 100 * i + 1;
+
+        memcpy(expected, device, sizeof(device));
+        motor_io_init(&io, device);
+    }
+};
+
+TEST(MotorIOTestGroup, ChannelIsSampledWhenAdded)
+{
+    motor_io_channel_t *c = motor_io_channel(&io, 3);
+
+    CHECK_EQUAL(cvra_dc_get_encoder(device, 3), motor_io_get_encoder(c));
+}
+
+TEST(MotorIOTestGroup, InvalidChannel)
+{
+    POINTERS_EQUAL(NULL, motor_io_channel(&io, -1));
+    POINTERS_EQUAL(NULL, motor_io_channel(&io, MOTOR_IO_MAX_CHANNELS));
+}
+
+TEST(MotorIOTestGroup, EncoderIsReadFromSnapshot)
+{
+    motor_io_channel_t *c = motor_io_channel(&io, 2);
+    int32_t before = motor_io_get_encoder(c);
+
+    cvra_dc_set_encoder(device, 2, 42);
+    CHECK_EQUAL(before, motor_io_get_encoder(c));
+
+    motor_io_read(&io);
+    CHECK_EQUAL(cvra_dc_get_encoder(device, 2), motor_io_get_encoder(c));
+}
+
+TEST(MotorIOTestGroup, OnlyUsedChannelsAreSampled)
+{
+    motor_io_channel(&io, 1);
+    motor_io_read(&io);
+
+    CHECK_EQUAL(0, io.encoders[0]);
+    CHECK_EQUAL(cvra_dc_get_encoder(device, 1), io.encoders[1]);
+}
+
+TEST(MotorIOTestGroup, PWMIsSentOnWrite)
+{
+    motor_io_channel_t *c = motor_io_channel(&io, 4);
+
+    motor_io_set_pwm(c, 42);
+    CHECK_EQUAL(0, memcmp(expected, device, sizeof(device)));
+
+    motor_io_write(&io);
+    cvra_dc_set_pwm(expected, 4, 42);
+    CHECK_EQUAL(0, memcmp(expected, device, sizeof(device)));
+}
+
+TEST(MotorIOTestGroup, OnlySetPWMsAreSent)
+{
+    motor_io_channel(&io, 0);
+    motor_io_set_pwm(motor_io_channel(&io, 1), 10);
+    motor_io_write(&io);
+
+    /* Channel 0 may be driven by another task, it must not be touched. */
+    cvra_dc_set_pwm(expected, 1, 10);
+    CHECK_EQUAL(0, memcmp(expected, device, sizeof(device)));
+
+    /* Nothing is sent twice. */
+    cvra_dc_set_pwm(device, 1, 20);
+    memcpy(expected, device, sizeof(device));
+    motor_io_write(&io);
+    CHECK_EQUAL(0, memcmp(expected, device, sizeof(device)));
+}
+
+TEST(MotorIOTestGroup, NegativePWM)
+{
+    motor_io_set_pwm_negative(motor_io_channel(&io, 2), 42);
+    motor_io_write(&io);
+
+    cvra_dc_set_pwm(expected, 2, -42);
+    CHECK_EQUAL(0, memcmp(expected, device, sizeof(device)));
+}
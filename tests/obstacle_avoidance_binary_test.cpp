@@ -0,0 +1,222 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include "../obstacle_avoidance_binary.h"
+}
+
+TEST_GROUP(ObstacleAvoidanceBinaryTestGroup)
+{
+    uint8_t buf[256];
+    obstacle_avoidance_point_t points[8];
+    obstacle_avoidance_path_t path;
+
+    /* Encodes a path of n points, with recognizable values. */
+    int make_path(int n)
+    {
+        obstacle_avoidance_point_t src[8];
+        obstacle_avoidance_path_t p;
+        int i;
+
+        for (i = 0; i < n; i++) {
+            src[i].x = 100 * i;
+            src[i].y = -50 * i;
+            src[i].vx = 300;
+            src[i].vy = -300;
+            src[i].timestamp = 100000 * i;
+        }
+
+        p.points = src;
+        p.len = n;
+
+        return obstacle_avoidance_binary_encode_path(&p, buf, sizeof(buf));
+    }
+};
+
+TEST(ObstacleAvoidanceBinaryTestGroup, RequestRoundTrip)
+{
+    obstacle_avoidance_obstacle_t obstacles[2] = {{1, 2, 3, 4, 150}, {-5, 6, -7, 8, 200}};
+    obstacle_avoidance_obstacle_t decoded_obstacles[2];
+    obstacle_avoidance_request_t r, decoded;
+    int len, err;
+
+    memset(&r, 0, sizeof(r));
+    r.start.x = 1500;
+    r.start.y = 1000;
+    r.start.vx = -200;
+    r.end.x = 2500;
+    r.end.y = 300;
+    r.desired_samplerate = 200;
+    r.desired_datapoints = 1000;
+    r.obstacles = obstacles;
+    r.obstacle_count = 2;
+
+    len = obstacle_avoidance_binary_encode_request(&r, buf, sizeof(buf));
+    CHECK_EQUAL(obstacle_avoidance_binary_request_size(&r), len);
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_BINARY_MAGIC, buf[0]);
+
+    err = obstacle_avoidance_binary_decode_request(&decoded, NULL, decoded_obstacles, 2, buf, len);
+    CHECK_EQUAL(ERR_OK, err);
+
+    CHECK_EQUAL(1500, decoded.start.x);
+    CHECK_EQUAL(1000, decoded.start.y);
+    CHECK_EQUAL(-200, decoded.start.vx);
+    CHECK_EQUAL(2500, decoded.end.x);
+    CHECK_EQUAL(300, decoded.end.y);
+    CHECK_EQUAL(200, decoded.desired_samplerate);
+    CHECK_EQUAL(1000, decoded.desired_datapoints);
+    CHECK_EQUAL(2, decoded.obstacle_count);
+    CHECK_EQUAL(-5, decoded.obstacles[1].x);
+    CHECK_EQUAL(-7, decoded.obstacles[1].vx);
+    CHECK_EQUAL(200, decoded.obstacles[1].r);
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, RequestTooBigForBuffer)
+{
+    obstacle_avoidance_request_t r;
+
+    memset(&r, 0, sizeof(r));
+    CHECK_EQUAL(-1, obstacle_avoidance_binary_encode_request(&r, buf, 10));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, TooManyObstacles)
+{
+    obstacle_avoidance_obstacle_t obstacles[2];
+    obstacle_avoidance_request_t r;
+    int len;
+
+    memset(&r, 0, sizeof(r));
+    memset(obstacles, 0, sizeof(obstacles));
+    r.obstacles = obstacles;
+    r.obstacle_count = 2;
+
+    len = obstacle_avoidance_binary_encode_request(&r, buf, sizeof(buf));
+    CHECK_EQUAL(ERR_BUF, obstacle_avoidance_binary_decode_request(&r, NULL, obstacles, 1, buf, len));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, PathRoundTrip)
+{
+    int len = make_path(3);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_binary_decode_path(&path, points, 8, buf, len));
+
+    CHECK_EQUAL(3, path.len);
+    POINTERS_EQUAL(points, path.points);
+    CHECK_EQUAL(200, points[2].x);
+    CHECK_EQUAL(-100, points[2].y);
+    CHECK_EQUAL(300, points[2].vx);
+    CHECK_EQUAL(-300, points[2].vy);
+    CHECK_EQUAL(200000, points[2].timestamp);
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, EmptyPath)
+{
+    int len = make_path(0);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_binary_decode_path(&path, points, 8, buf, len));
+    CHECK_EQUAL(0, path.len);
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, PathTooLong)
+{
+    int len = make_path(3);
+
+    CHECK_EQUAL(ERR_BUF, obstacle_avoidance_binary_decode_path(&path, points, 2, buf, len));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, TruncatedPathIsInvalid)
+{
+    int len = make_path(3);
+
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_binary_decode_path(&path, points, 8, buf, len - 1));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, JsonIsNotBinary)
+{
+    const char *json = "[[1,2,3,4,5]]";
+
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_binary_decode_path(&path, points, 8,
+                (const uint8_t *)json, strlen(json)));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, InconsistentCountIsInvalid)
+{
+    int len = make_path(3);
+
+    buf[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE] = 4;
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_binary_decode_path(&path, points, 8, buf, len));
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, StreamingByteByByte)
+{
+    obstacle_avoidance_binary_decoder_t d;
+    int len = make_path(3), i;
+
+    obstacle_avoidance_binary_decoder_init(&d, points, 8);
+
+    for (i = 0; i < len; i++) {
+        CHECK_FALSE(obstacle_avoidance_binary_decoder_done(&d));
+        CHECK_EQUAL(ERR_OK, obstacle_avoidance_binary_decoder_feed(&d, &buf[i], 1));
+
+        /* Points are available as soon as they are received. */
+        if (i == OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE + 4 + OBSTACLE_AVOIDANCE_BINARY_POINT_SIZE - 1)
+            CHECK_EQUAL(1, d.len);
+    }
+
+    CHECK_TRUE(obstacle_avoidance_binary_decoder_done(&d));
+    CHECK_EQUAL(3, d.len);
+    CHECK_EQUAL(100, points[1].x);
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, SessionRequestCarriesId)
+{
+    obstacle_avoidance_obstacle_t obstacles[1] = {{1, 2, 3, 4, 150}};
+    obstacle_avoidance_obstacle_t decoded_obstacles[1];
+    obstacle_avoidance_request_t r, decoded;
+    uint16_t id;
+    int len;
+
+    memset(&r, 0, sizeof(r));
+    r.end.x = 2500;
+    r.obstacles = obstacles;
+    r.obstacle_count = 1;
+
+    len = obstacle_avoidance_binary_encode_session_request(&r, 0x1234, buf, sizeof(buf));
+    CHECK_EQUAL(obstacle_avoidance_binary_request_size(&r) + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE, len);
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_BINARY_SESSION_REQUEST, buf[1]);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_binary_decode_request(&decoded, &id, decoded_obstacles, 1, buf, len));
+    CHECK_EQUAL(0x1234, id);
+    CHECK_EQUAL(2500, decoded.end.x);
+    CHECK_EQUAL(150, decoded.obstacles[0].r);
+}
+
+TEST(ObstacleAvoidanceBinaryTestGroup, SessionPathHeader)
+{
+    obstacle_avoidance_binary_decoder_t d;
+    obstacle_avoidance_path_t p;
+    uint32_t payload_len;
+    int len, type;
+
+    p.points = points;
+    points[0].x = 42;
+    points[0].timestamp = 0;
+    p.len = 1;
+
+    len = obstacle_avoidance_binary_encode_session_path(&p, 5, buf, sizeof(buf));
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_binary_decode_header(buf, &type, &payload_len));
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_BINARY_SESSION_PATH, type);
+    CHECK_EQUAL(len - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE, (int)payload_len);
+    CHECK_EQUAL(5, buf[OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE]);
+
+    /* The rest of the payload is a path, decoded without its header. */
+    points[0].x = 0;
+    obstacle_avoidance_binary_decoder_init_payload(&d, points, 8, payload_len - OBSTACLE_AVOIDANCE_BINARY_ID_SIZE);
+    obstacle_avoidance_binary_decoder_feed(&d, buf + OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE
+                                           + OBSTACLE_AVOIDANCE_BINARY_ID_SIZE,
+                                           len - OBSTACLE_AVOIDANCE_BINARY_HEADER_SIZE
+                                           - OBSTACLE_AVOIDANCE_BINARY_ID_SIZE);
+    CHECK_TRUE(obstacle_avoidance_binary_decoder_done(&d));
+    CHECK_EQUAL(42, points[0].x);
+}
@@ -0,0 +1,113 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include "../obstacle_avoidance_client.h"
+}
+
+TEST_GROUP(ObstacleAvoidanceClientTestGroup)
+{
+    obstacle_avoidance_client_t c;
+    obstacle_avoidance_request_t request;
+    obstacle_avoidance_obstacle_t obstacles[OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES + 1];
+    obstacle_avoidance_point_t points[8];
+    obstacle_avoidance_path_t path;
+
+    void setup()
+    {
+        struct ip_addr ip;
+
+        ip.addr = 0;
+        obstacle_avoidance_client_init(&c, ip, 1337);
+
+        memset(&request, 0, sizeof(request));
+        memset(obstacles, 0, sizeof(obstacles));
+        request.obstacles = obstacles;
+    }
+
+    int submit()
+    {
+        return obstacle_avoidance_client_submit(&c, &request, points, 8, 1000);
+    }
+};
+
+TEST(ObstacleAvoidanceClientTestGroup, SubmitReturnsPendingHandle)
+{
+    int handle = submit();
+
+    CHECK_TRUE(handle >= 0);
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_PENDING, obstacle_avoidance_client_poll(&c, handle, &path));
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, SubmitWakesUpWorker)
+{
+    submit();
+    CHECK_EQUAL(1, c.work.count);
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, RequestIsCopied)
+{
+    int handle;
+
+    obstacles[0].x = 1200;
+    request.obstacle_count = 1;
+    request.end.x = 500;
+
+    handle = submit();
+
+    /* The submitter may reuse its request at once. */
+    obstacles[0].x = 0;
+    request.end.x = 0;
+
+    CHECK_EQUAL(500, c.jobs[handle].request.end.x);
+    CHECK_EQUAL(1200, c.jobs[handle].request.obstacles[0].x);
+    POINTERS_EQUAL(c.jobs[handle].obstacles, c.jobs[handle].request.obstacles);
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, TooManyObstacles)
+{
+    request.obstacle_count = OBSTACLE_AVOIDANCE_BINARY_MAX_OBSTACLES + 1;
+
+    CHECK_EQUAL(ERR_BUF, submit());
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, TooManyRequests)
+{
+    int i;
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++)
+        CHECK_TRUE(submit() >= 0);
+
+    CHECK_EQUAL(ERR_MEM, submit());
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, ReleaseFreesHandle)
+{
+    int i, handle = 0;
+
+    for (i = 0; i < OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS; i++)
+        handle = submit();
+
+    obstacle_avoidance_client_release(&c, handle);
+
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_client_poll(&c, handle, &path));
+    CHECK_EQUAL(handle, submit());
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, InvalidHandle)
+{
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_client_poll(&c, 0, &path));
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_client_poll(&c, -1, &path));
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_client_poll(&c, OBSTACLE_AVOIDANCE_CLIENT_MAX_JOBS, &path));
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_client_wait(&c, 0, &path));
+}
+
+TEST(ObstacleAvoidanceClientTestGroup, LockIsReleased)
+{
+    int handle = submit();
+
+    obstacle_avoidance_client_poll(&c, handle, &path);
+    obstacle_avoidance_client_release(&c, handle);
+
+    CHECK_EQUAL(1, c.lock.count);
+}
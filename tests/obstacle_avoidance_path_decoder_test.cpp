@@ -0,0 +1,130 @@
+#include "CppUTest/TestHarness.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+extern "C" {
+#include "../obstacle_avoidance_path_decoder.h"
+}
+
+TEST_GROUP(ObstacleAvoidancePathDecoderTestGroup)
+{
+    obstacle_avoidance_path_decoder_t d;
+    obstacle_avoidance_path_t path;
+
+    void setup()
+    {
+        obstacle_avoidance_path_decoder_init(&d, &path);
+    }
+
+    void teardown()
+    {
+        free(path.points);
+    }
+
+    int feed(const char *s)
+    {
+        return obstacle_avoidance_path_decoder_feed(&d, s, strlen(s));
+    }
+};
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, EmptyPath)
+{
+    CHECK_EQUAL(ERR_OK, feed(" [ ] "));
+    CHECK_TRUE(obstacle_avoidance_path_decoder_done(&d));
+    CHECK_EQUAL(0, path.len);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, SimplePath)
+{
+    CHECK_EQUAL(ERR_OK, feed("[[1,2,3,4, 1000], [10, -11, 12, 13, 2000]]"));
+    CHECK_TRUE(obstacle_avoidance_path_decoder_done(&d));
+
+    CHECK_EQUAL(2, path.len);
+    CHECK_EQUAL(1, path.points[0].x);
+    CHECK_EQUAL(1000, path.points[0].timestamp);
+    CHECK_EQUAL(-11, path.points[1].y);
+    CHECK_EQUAL(13, path.points[1].vy);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, PointsAreAvailableWhileStreaming)
+{
+    feed("[[1,2,3,4,5],[6,7");
+
+    CHECK_FALSE(obstacle_avoidance_path_decoder_done(&d));
+    CHECK_EQUAL(1, path.len);
+
+    feed(",8,9,10]]");
+    CHECK_TRUE(obstacle_avoidance_path_decoder_done(&d));
+    CHECK_EQUAL(2, path.len);
+    CHECK_EQUAL(7, path.points[1].y);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, NumberSplitBetweenChunks)
+{
+    feed("[[12");
+    feed("34,0,0,0,0]]");
+
+    CHECK_EQUAL(1234, path.points[0].x);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, FloatsAreTruncated)
+{
+    feed("[[1.9,-2.5,1e3,1.5E+2,25e-1]]");
+
+    CHECK_EQUAL(1, path.points[0].x);
+    CHECK_EQUAL(-2, path.points[0].y);
+    CHECK_EQUAL(1000, path.points[0].vx);
+    CHECK_EQUAL(150, path.points[0].vy);
+    CHECK_EQUAL(2, path.points[0].timestamp);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, ExtraValuesAreIgnored)
+{
+    CHECK_EQUAL(ERR_OK, feed("[[1,2,3,4,5,6]]"));
+    CHECK_EQUAL(5, path.points[0].timestamp);
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, MissingValuesAreInvalid)
+{
+    CHECK_EQUAL(ERR_VAL, feed("[[1,2,3,4]]"));
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, InvalidEncodings)
+{
+    CHECK_EQUAL(ERR_VAL, feed("1"));
+
+    obstacle_avoidance_path_decoder_init(&d, &path);
+    CHECK_EQUAL(ERR_VAL, feed("[1,2"));
+
+    obstacle_avoidance_path_decoder_init(&d, &path);
+    CHECK_EQUAL(ERR_VAL, feed("[[1,,2,3,4,5]]"));
+
+    obstacle_avoidance_path_decoder_init(&d, &path);
+    CHECK_EQUAL(ERR_VAL, feed("[[-,2,3,4,5]]"));
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, ErrorsAreSticky)
+{
+    feed("[x");
+    CHECK_EQUAL(ERR_VAL, feed("[1,2,3,4,5]]"));
+    CHECK_FALSE(obstacle_avoidance_path_decoder_done(&d));
+}
+
+TEST(ObstacleAvoidancePathDecoderTestGroup, LongPathHasNoLimit)
+{
+    char point[64];
+    int i;
+
+    feed("[");
+    for (i = 0; i < 5000; i++) {
+        sprintf(point, "%s[%d,0,0,0,%d]", i ? "," : "", i, i * 10);
+        CHECK_EQUAL(ERR_OK, feed(point));
+    }
+    feed("]");
+
+    CHECK_TRUE(obstacle_avoidance_path_decoder_done(&d));
+    CHECK_EQUAL(5000, path.len);
+    CHECK_EQUAL(4999, path.points[4999].x);
+    CHECK_EQUAL(49990, path.points[4999].timestamp);
+}
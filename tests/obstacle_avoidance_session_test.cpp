@@ -0,0 +1,216 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include "../obstacle_avoidance_session.h"
+}
+
+TEST_GROUP(ObstacleAvoidanceSessionTestGroup)
+{
+    obstacle_avoidance_session_t s;
+    obstacle_avoidance_point_t points[2][8];
+    obstacle_avoidance_path_t path[2];
+    uint8_t buf[256];
+
+    void setup()
+    {
+        struct ip_addr ip;
+
+        ip.addr = 0;
+        obstacle_avoidance_session_init(&s, ip, 1337);
+    }
+
+    /* Registers an outstanding request without sending it. */
+    void pending(int slot, int id, int max_points, int32_t deadline)
+    {
+        s.requests[slot].id = id;
+        s.requests[slot].status = OBSTACLE_AVOIDANCE_PENDING;
+        s.requests[slot].path = &path[slot];
+        s.requests[slot].points = points[slot];
+        s.requests[slot].max_points = max_points;
+        s.requests[slot].deadline = deadline;
+    }
+
+    /* Encodes the answer to a request, a path of n points starting at x. */
+    int answer(int id, int n, int x, uint8_t *dst)
+    {
+        obstacle_avoidance_point_t src[8];
+        obstacle_avoidance_path_t p;
+        int i;
+
+        memset(src, 0, sizeof(src));
+        for (i = 0; i < n; i++) {
+            src[i].x = x + i;
+            src[i].timestamp = 100 * i;
+        }
+
+        p.points = src;
+        p.len = n;
+
+        return obstacle_avoidance_binary_encode_session_path(&p, id, dst, 128);
+    }
+};
+
+TEST(ObstacleAvoidanceSessionTestGroup, InitHasNoRequest)
+{
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_session_status(&s, 0));
+    POINTERS_EQUAL(NULL, s.conn);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, AnswerCompletesItsRequest)
+{
+    int len = answer(7, 3, 100, buf);
+
+    pending(0, 7, 8, 1000);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 7));
+    CHECK_EQUAL(3, path[0].len);
+    POINTERS_EQUAL(points[0], path[0].points);
+    CHECK_EQUAL(102, points[0][2].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, AnswersAreMatchedById)
+{
+    int len;
+
+    pending(0, 1, 8, 1000);
+    pending(1, 2, 8, 1000);
+
+    /* The second request is answered first, in the same segment. */
+    len = answer(2, 2, 200, buf);
+    len += answer(1, 4, 100, buf + len);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 1));
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 2));
+    CHECK_EQUAL(4, path[0].len);
+    CHECK_EQUAL(100, points[0][0].x);
+    CHECK_EQUAL(2, path[1].len);
+    CHECK_EQUAL(201, points[1][1].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, ByteByByte)
+{
+    int len = answer(3, 2, 50, buf), i;
+
+    pending(0, 3, 8, 1000);
+
+    for (i = 0; i < len; i++) {
+        CHECK_EQUAL(OBSTACLE_AVOIDANCE_PENDING, obstacle_avoidance_session_status(&s, 3));
+        CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, &buf[i], 1));
+    }
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 3));
+    CHECK_EQUAL(51, points[0][1].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, UnknownAnswerIsSkipped)
+{
+    int len;
+
+    pending(0, 1, 8, 1000);
+
+    len = answer(9, 3, 900, buf);
+    len += answer(1, 1, 100, buf + len);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 1));
+    CHECK_EQUAL(1, path[0].len);
+    CHECK_EQUAL(100, points[0][0].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, PathTooLongOnlyFailsItsRequest)
+{
+    int len;
+
+    pending(0, 1, 2, 1000);
+    pending(1, 2, 8, 1000);
+
+    len = answer(1, 3, 100, buf);
+    len += answer(2, 3, 200, buf + len);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+    CHECK_EQUAL(ERR_BUF, obstacle_avoidance_session_status(&s, 1));
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_status(&s, 2));
+    CHECK_EQUAL(202, points[1][2].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, GarbageIsAnError)
+{
+    const char *json = "[[1,2,3,4,5]]";
+
+    CHECK_EQUAL(ERR_VAL, obstacle_avoidance_session_feed(&s, (const uint8_t *)json, strlen(json)));
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, JsonFirstAnswerMeansJsonPlanner)
+{
+    const char *json = "[[1,2,3,4,5]]";
+
+    obstacle_avoidance_session_feed(&s, (const uint8_t *)json, strlen(json));
+    CHECK_EQUAL(1, s.json);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, BinaryFirstAnswerMeansBinaryPlanner)
+{
+    int len = answer(1, 1, 0, buf);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+    CHECK_EQUAL(0, s.json);
+
+    /* Only the first answer of the connection tells. */
+    obstacle_avoidance_session_feed(&s, (const uint8_t *)"[", 1);
+    CHECK_EQUAL(0, s.json);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, TimeoutFailsOnlyExpiredRequests)
+{
+    pending(0, 1, 8, 1000);
+    pending(1, 2, 8, 2000);
+
+    obstacle_avoidance_session_check_timeouts(&s, 999);
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_PENDING, obstacle_avoidance_session_status(&s, 1));
+
+    obstacle_avoidance_session_check_timeouts(&s, 1000);
+    CHECK_EQUAL(ERR_TIMEOUT, obstacle_avoidance_session_status(&s, 1));
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_PENDING, obstacle_avoidance_session_status(&s, 2));
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, LateAnswerDoesNotOverwriteTimedOutRequest)
+{
+    int len = answer(1, 3, 100, buf);
+
+    pending(0, 1, 8, 1000);
+    points[0][0].x = -1;
+
+    obstacle_avoidance_session_check_timeouts(&s, 1000);
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, len));
+
+    CHECK_EQUAL(ERR_TIMEOUT, obstacle_avoidance_session_status(&s, 1));
+    CHECK_EQUAL(-1, points[0][0].x);
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, CancelledSlotReusedDuringAnswer)
+{
+    int len = answer(1, 2, 100, buf);
+
+    pending(0, 1, 8, 1000);
+
+    /* The answer starts, then its request is cancelled and the slot reused. */
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf, 10));
+    obstacle_avoidance_session_cancel(&s, 1);
+    pending(0, 2, 8, 1000);
+
+    CHECK_EQUAL(ERR_OK, obstacle_avoidance_session_feed(&s, buf + 10, len - 10));
+    CHECK_EQUAL(OBSTACLE_AVOIDANCE_PENDING, obstacle_avoidance_session_status(&s, 2));
+}
+
+TEST(ObstacleAvoidanceSessionTestGroup, CloseFailsOutstandingRequests)
+{
+    pending(0, 1, 8, 1000);
+
+    obstacle_avoidance_session_close(&s);
+
+    CHECK_EQUAL(ERR_CLSD, obstacle_avoidance_session_status(&s, 1));
+}
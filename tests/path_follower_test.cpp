@@ -0,0 +1,157 @@
+#include "CppUTest/TestHarness.h"
+#include <cmath>
+
+extern "C" {
+#include "../path_follower.h"
+}
+
+TEST_GROUP(PathFollowerTestGroup)
+{
+    path_follower_t f;
+    obstacle_avoidance_point_t points[3];
+    obstacle_avoidance_path_t path;
+    float v, w;
+
+    /* Straight line along x at 500 mm/s, one point per second. */
+    void setup()
+    {
+        int i;
+
+        for (i = 0; i < 3; i++) {
+            points[i].x = 500 * i;
+            points[i].y = 0;
+            points[i].vx = 500;
+            points[i].vy = 0;
+            points[i].timestamp = 1000 * i;
+        }
+        points[2].vx = 0;
+
+        path.points = points;
+        path.len = 3;
+
+        path_follower_init(&f);
+        path_follower_start(&f, &path, 0);
+    }
+};
+
+TEST(PathFollowerTestGroup, IdleByDefault)
+{
+    path_follower_init(&f);
+
+    CHECK_FALSE(path_follower_is_active(&f));
+    CHECK_EQUAL(0, path_follower_update(&f, 0, 0, 0, 0, &v, &w));
+    DOUBLES_EQUAL(0, v, 1e-6);
+    DOUBLES_EQUAL(0, w, 1e-6);
+}
+
+TEST(PathFollowerTestGroup, EmptyPathIsNotFollowed)
+{
+    path.len = 0;
+    path_follower_start(&f, &path, 0);
+
+    CHECK_FALSE(path_follower_is_active(&f));
+}
+
+TEST(PathFollowerTestGroup, ReferenceIsInterpolated)
+{
+    path_follower_reference_t ref;
+    int index = 0;
+
+    path_follower_reference(&path, &index, 1500, &ref);
+
+    CHECK_EQUAL(1, index);
+    DOUBLES_EQUAL(750, ref.x, 1e-3);
+    DOUBLES_EQUAL(250, ref.vx, 1e-3);
+}
+
+TEST(PathFollowerTestGroup, ReferenceStopsAtEnd)
+{
+    path_follower_reference_t ref;
+    int index = 0;
+
+    path_follower_reference(&path, &index, 5000, &ref);
+
+    DOUBLES_EQUAL(1000, ref.x, 1e-3);
+    DOUBLES_EQUAL(0, ref.vx, 1e-3);
+}
+
+TEST(PathFollowerTestGroup, ReferenceTurnRate)
+{
+    path_follower_reference_t ref;
+    int index = 0;
+
+    /* Quarter turn during the first second. */
+    points[1].vx = 0;
+    points[1].vy = 500;
+
+    path_follower_reference(&path, &index, 500, &ref);
+
+    DOUBLES_EQUAL(M_PI / 2, ref.w, 1e-3);
+}
+
+TEST(PathFollowerTestGroup, OnReferenceFollowsPlannerSpeed)
+{
+    CHECK_EQUAL(1, path_follower_update(&f, 500000, 250, 0, 0, &v, &w));
+
+    DOUBLES_EQUAL(500, v, 1e-3);
+    DOUBLES_EQUAL(0, w, 1e-6);
+}
+
+TEST(PathFollowerTestGroup, CatchesUpWhenLate)
+{
+    path_follower_update(&f, 500000, 150, 0, 0, &v, &w);
+
+    CHECK(v > 500);
+}
+
+TEST(PathFollowerTestGroup, TurnsBackTowardPath)
+{
+    /* Left of the path, so it must turn right. */
+    path_follower_update(&f, 500000, 250, 100, 0, &v, &w);
+    CHECK(w < 0);
+
+    /* Heading away from the path on the right, so it must turn left. */
+    path_follower_update(&f, 500000, 250, 0, -0.3, &v, &w);
+    CHECK(w > 0);
+}
+
+TEST(PathFollowerTestGroup, DoneOnceEndIsReached)
+{
+    CHECK_EQUAL(1, path_follower_update(&f, 2000000, 950, 0, 0, &v, &w));
+    CHECK_EQUAL(0, path_follower_update(&f, 2000000, 990, 0, 0, &v, &w));
+    CHECK_FALSE(path_follower_is_active(&f));
+}
+
+TEST(PathFollowerTestGroup, GivesUpAfterSettleTime)
+{
+    CHECK_EQUAL(1, path_follower_update(&f, 2000000 + PATH_FOLLOWER_SETTLE_TIME, 500, 300, 0, &v, &w));
+    CHECK_EQUAL(0, path_follower_update(&f, 2000001 + PATH_FOLLOWER_SETTLE_TIME, 500, 300, 0, &v, &w));
+}
+
+TEST(PathFollowerTestGroup, StartReplacesPath)
+{
+    obstacle_avoidance_path_t other = {&points[1], 2};
+
+    path_follower_start(&f, &other, 0);
+    path_follower_update(&f, 1000000, 500, 0, 0, &v, &w);
+
+    DOUBLES_EQUAL(500, v, 1e-3);
+}
+
+TEST(PathFollowerTestGroup, ConvergesOnSimulatedRobot)
+{
+    float x = 0, y = 80, a = 0.2;
+    int32_t now;
+
+    /* Unicycle robot integrated at the control rate. */
+    for (now = 0; now < 4000000 && path_follower_is_active(&f); now += 10000) {
+        path_follower_update(&f, now, x, y, a, &v, &w);
+        x += v * cosf(a) * 0.01;
+        y += v * sinf(a) * 0.01;
+        a += w * 0.01;
+    }
+
+    CHECK_FALSE(path_follower_is_active(&f));
+    DOUBLES_EQUAL(1000, x, PATH_FOLLOWER_WINDOW);
+    DOUBLES_EQUAL(0, y, PATH_FOLLOWER_WINDOW);
+}
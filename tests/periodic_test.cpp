@@ -0,0 +1,84 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../periodic.h"
+#include "uptime.h"
+}
+
+TEST_GROUP(PeriodicTestGroup)
+{
+    periodic_t p;
+
+    void setup()
+    {
+        uptime_set(1000);
+        periodic_init(&p, 100);
+    }
+
+    void teardown()
+    {
+        uptime_set(0);
+    }
+};
+
+TEST(PeriodicTestGroup, FirstDeadlineIsOnePeriodAway)
+{
+    CHECK_EQUAL(1100, p.next_deadline);
+    CHECK_EQUAL(0, p.overruns);
+    CHECK_FALSE(periodic_is_due(&p, 1099));
+    CHECK(periodic_is_due(&p, 1100));
+}
+
+TEST(PeriodicTestGroup, DeadlinesDoNotDriftWithExecutionTime)
+{
+    /* Work finished 30 us after the deadline, the next one is still on the grid. */
+    CHECK_EQUAL(0, periodic_advance(&p, 1130));
+    CHECK_EQUAL(1200, p.next_deadline);
+    CHECK_EQUAL(70, periodic_time_left(&p, 1130));
+}
+
+TEST(PeriodicTestGroup, OverrunsAreCountedAndResynchronized)
+{
+    CHECK_EQUAL(1, periodic_advance(&p, 1250));
+    CHECK_EQUAL(1, p.overruns);
+
+    /* We do not try to catch up with the missed periods. */
+    CHECK_EQUAL(1350, p.next_deadline);
+}
+
+TEST(PeriodicTestGroup, TimeLeftIsZeroWhenLate)
+{
+    CHECK_EQUAL(0, periodic_time_left(&p, 1500));
+}
+
+TEST(PeriodicTestGroup, IdleTimerIsNeverDue)
+{
+    periodic_set_period(&p, 0, 1000);
+    CHECK_FALSE(periodic_is_due(&p, 5000));
+    CHECK_EQUAL(-1, periodic_time_left(&p, 5000));
+    CHECK_EQUAL(0, periodic_advance(&p, 5000));
+}
+
+TEST(PeriodicTestGroup, WakingUpIdleTimerMakesItDue)
+{
+    periodic_set_period(&p, 0, 1000);
+    periodic_set_period(&p, 100, 5000);
+    CHECK(periodic_is_due(&p, 5000));
+}
+
+TEST(PeriodicTestGroup, ShorterPeriodBringsDeadlineCloser)
+{
+    periodic_set_period(&p, 1000, 1000);
+    periodic_advance(&p, 1100);
+    CHECK_EQUAL(2100, p.next_deadline);
+
+    periodic_set_period(&p, 100, 1200);
+    CHECK_EQUAL(1300, p.next_deadline);
+}
+
+TEST(PeriodicTestGroup, WorksWhenUptimeWraps)
+{
+    p.next_deadline = INT32_MAX - 10;
+    CHECK_FALSE(periodic_is_due(&p, INT32_MAX - 20));
+    CHECK(periodic_is_due(&p, INT32_MIN + 10));
+}
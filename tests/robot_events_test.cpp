@@ -0,0 +1,45 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../robot_events.h"
+}
+
+TEST_GROUP(RobotEventsTestGroup)
+{
+    void setup()
+    {
+        robot_events_init();
+    }
+};
+
+TEST(RobotEventsTestGroup, NoEventTimesOut)
+{
+    CHECK_EQUAL(0, robot_events_wait(ROBOT_EVENT_TRAJ_END, 0));
+}
+
+TEST(RobotEventsTestGroup, PostedEventIsReturned)
+{
+    robot_events_post(ROBOT_EVENT_LEFT_ARM_DONE);
+    CHECK_EQUAL(ROBOT_EVENT_LEFT_ARM_DONE, robot_events_wait(ROBOT_EVENT_LEFT_ARM_DONE, 0));
+}
+
+TEST(RobotEventsTestGroup, EventIsConsumed)
+{
+    robot_events_post(ROBOT_EVENT_LEFT_ARM_DONE);
+    robot_events_wait(ROBOT_EVENT_LEFT_ARM_DONE, 0);
+    CHECK_EQUAL(0, robot_events_wait(ROBOT_EVENT_LEFT_ARM_DONE, 0));
+}
+
+TEST(RobotEventsTestGroup, CanWaitForSeveralEvents)
+{
+    robot_events_post(ROBOT_EVENT_RIGHT_ARM_DONE);
+    CHECK_EQUAL(ROBOT_EVENT_RIGHT_ARM_DONE,
+                robot_events_wait(ROBOT_EVENT_LEFT_ARM_DONE | ROBOT_EVENT_RIGHT_ARM_DONE, 0));
+}
+
+TEST(RobotEventsTestGroup, OtherEventsStayPending)
+{
+    robot_events_post(ROBOT_EVENT_TRAJ_END | ROBOT_EVENT_BLOCKING);
+    CHECK_EQUAL(ROBOT_EVENT_TRAJ_END, robot_events_wait(ROBOT_EVENT_TRAJ_END, 0));
+    CHECK_EQUAL(ROBOT_EVENT_BLOCKING, robot_events_wait(ROBOT_EVENT_BLOCKING, 0));
+}
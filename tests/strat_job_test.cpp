@@ -0,0 +1,192 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include "../strat_job.h"
+#include "../strat_utils.h"
+#include "../robot_events.h"
+}
+
+static int fake_time;
+
+extern "C" int strat_get_time(void)
+{
+    return fake_time;
+}
+
+/* Each job appends its tag to the run log. */
+static char run_log[32];
+static int run_count;
+
+static int job_done(void *tag)
+{
+    run_log[run_count++] = *(char *)tag;
+    return STRAT_JOB_DONE;
+}
+
+static int job_again_twice(void *tag)
+{
+    static int calls = 0;
+
+    run_log[run_count++] = *(char *)tag;
+    return ++calls % 3 ? STRAT_JOB_AGAIN : STRAT_JOB_DONE;
+}
+
+struct waiting_job {
+    char tag;
+    uint32_t events;
+    int calls;
+};
+
+/* Waits for its events the first time, then finishes. */
+static int job_wait(void *p)
+{
+    struct waiting_job *job = (struct waiting_job *)p;
+
+    run_log[run_count++] = job->tag;
+
+    if (job->calls++ > 0)
+        return STRAT_JOB_DONE;
+
+    strat_job_wait_for(job->events);
+    return STRAT_JOB_WAIT;
+}
+
+TEST_GROUP(StratJobTestGroup)
+{
+    char a, b, c;
+
+    void setup()
+    {
+        a = 'a'; b = 'b'; c = 'c';
+        fake_time = 0;
+        run_count = 0;
+        memset(run_log, 0, sizeof(run_log));
+        strat_job_reset();
+        robot_events_init();
+    }
+
+    void run_all(void)
+    {
+        int i;
+        for (i = 0; i < 100 && !strat_job_pool_is_empty(); i++)
+            strat_job_step(fake_time);
+    }
+};
+
+TEST(StratJobTestGroup, EmptyPool)
+{
+    int id = strat_job_step(0);
+
+    CHECK_EQUAL(1, strat_job_pool_is_empty());
+    CHECK_EQUAL(-1, id);
+}
+
+TEST(StratJobTestGroup, JobIsRemovedWhenDone)
+{
+    strat_schedule_job(job_done, &a);
+    CHECK_EQUAL(0, strat_job_pool_is_empty());
+
+    strat_do_jobs();
+
+    CHECK_EQUAL(1, strat_job_pool_is_empty());
+    STRCMP_EQUAL("a", run_log);
+}
+
+TEST(StratJobTestGroup, JobRunsUntilDone)
+{
+    strat_schedule_job(job_again_twice, &a);
+    run_all();
+    STRCMP_EQUAL("aaa", run_log);
+}
+
+TEST(StratJobTestGroup, HighestPriorityRunsFirst)
+{
+    strat_schedule_job_ext(job_done, &a, 1, 0, 0, 0);
+    strat_schedule_job_ext(job_done, &b, 3, 0, 0, 0);
+    strat_schedule_job_ext(job_done, &c, 2, 0, 0, 0);
+    run_all();
+    STRCMP_EQUAL("bca", run_log);
+}
+
+TEST(StratJobTestGroup, HighestScoreRunsFirstAtSamePriority)
+{
+    strat_schedule_job_ext(job_done, &a, 0, 0, 0, 4);
+    strat_schedule_job_ext(job_done, &b, 0, 0, 0, 10);
+    run_all();
+    STRCMP_EQUAL("ba", run_log);
+}
+
+TEST(StratJobTestGroup, LateJobsAreDropped)
+{
+    strat_schedule_job_ext(job_done, &a, 0, 30, 10, 0);
+    strat_schedule_job_ext(job_done, &b, 0, 0, 10, 0);
+    fake_time = 25;
+    run_all();
+    STRCMP_EQUAL("b", run_log);
+}
+
+TEST(StratJobTestGroup, JobsCannotOutliveMatch)
+{
+    strat_schedule_job_ext(job_done, &a, 0, 0, 10, 0);
+    fake_time = MATCH_TIME - 5;
+    run_all();
+    STRCMP_EQUAL("", run_log);
+}
+
+TEST(StratJobTestGroup, WaitingJobLetsOthersRun)
+{
+    struct waiting_job left = {'a', ROBOT_EVENT_LEFT_ARM_DONE, 0};
+    int id;
+
+    strat_schedule_job_ext(job_wait, &left, 2, 0, 0, 0);
+    strat_schedule_job_ext(job_done, &b, 1, 0, 0, 0);
+
+    strat_job_step(0);
+    strat_job_step(0);
+    STRCMP_EQUAL("ab", run_log);
+
+    /* Nothing is runnable until the event is posted. */
+    robot_events_post(ROBOT_EVENT_LEFT_ARM_DONE);
+    id = strat_job_step(0);
+    CHECK_EQUAL(-1, id);
+
+    strat_job_step(0);
+    STRCMP_EQUAL("aba", run_log);
+}
+
+TEST(StratJobTestGroup, EventOnlyWakesItsJobs)
+{
+    struct waiting_job left = {'a', ROBOT_EVENT_LEFT_ARM_DONE, 0};
+    struct waiting_job right = {'b', ROBOT_EVENT_RIGHT_ARM_DONE, 0};
+
+    strat_schedule_job(job_wait, &left);
+    strat_schedule_job(job_wait, &right);
+    strat_job_step(0);
+    strat_job_step(0);
+
+    robot_events_post(ROBOT_EVENT_RIGHT_ARM_DONE);
+    strat_job_step(0);
+    strat_job_step(0);
+
+    STRCMP_EQUAL("abb", run_log);
+    CHECK_EQUAL(0, strat_job_pool_is_empty());
+}
+
+TEST(StratJobTestGroup, PoolIsBounded)
+{
+    int i, id;
+
+    for (i = 0; i < STRAT_JOB_MAX; i++)
+        CHECK(strat_schedule_job(job_done, &a) >= 0);
+
+    id = strat_schedule_job(job_done, &a);
+    CHECK_EQUAL(-1, id);
+}
+
+TEST(StratJobTestGroup, CanCancelJob)
+{
+    int id = strat_schedule_job(job_done, &a);
+    strat_cancel_job(id);
+    CHECK_EQUAL(1, strat_job_pool_is_empty());
+}
@@ -0,0 +1,189 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../strat_planner.h"
+}
+
+static strat_planner_point_t point(int32_t x, int32_t y)
+{
+    strat_planner_point_t p = {x, y};
+    return p;
+}
+
+TEST_GROUP(StratPlannerTestGroup)
+{
+    strat_planner_point_t path[STRAT_PLANNER_MAX_PATH];
+    strat_planner_stats_t stats;
+
+    void setup()
+    {
+        strat_planner_init();
+    }
+
+    /* Square from 400,400 to 600,600, in the way from 0,500 to 1000,500. */
+    void add_square()
+    {
+        strat_planner_point_t square[] = {
+            point(400, 400), point(600, 400), point(600, 600), point(400, 600)
+        };
+
+        CHECK_EQUAL(0, strat_planner_add_static_polygon(square, 4));
+    }
+};
+
+TEST(StratPlannerTestGroup, DirectPath)
+{
+    int len = strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(1, len);
+    CHECK_EQUAL(1000, path[0].x);
+    CHECK_EQUAL(0, path[0].y);
+}
+
+TEST(StratPlannerTestGroup, GoesAroundStaticPolygon)
+{
+    int len;
+
+    add_square();
+    len = strat_planner_get_path(point(0, 500), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(3, len);
+    CHECK_EQUAL(400, path[0].x);
+    CHECK_EQUAL(600, path[1].x);
+    CHECK_EQUAL(path[0].y, path[1].y);
+    CHECK_EQUAL(1000, path[2].x);
+    CHECK_EQUAL(500, path[2].y);
+}
+
+TEST(StratPlannerTestGroup, ClockwisePolygonIsAccepted)
+{
+    strat_planner_point_t square[] = {
+        point(400, 600), point(600, 600), point(600, 400), point(400, 400)
+    };
+    int len;
+
+    strat_planner_add_static_polygon(square, 4);
+    len = strat_planner_get_path(point(0, 500), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(3, len);
+}
+
+TEST(StratPlannerTestGroup, GoalInsideObstacle)
+{
+    int len;
+
+    add_square();
+    len = strat_planner_get_path(point(0, 500), point(500, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(0, len);
+    strat_planner_get_stats(&stats);
+    CHECK_EQUAL(1, stats.failures);
+}
+
+TEST(StratPlannerTestGroup, StartInsideObstacleCanEscape)
+{
+    int len;
+
+    add_square();
+    len = strat_planner_get_path(point(450, 500), point(0, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(1, len);
+    CHECK_EQUAL(0, path[0].x);
+}
+
+TEST(StratPlannerTestGroup, PathIsReused)
+{
+    int len;
+
+    add_square();
+    strat_planner_get_path(point(0, 500), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+    len = strat_planner_get_path(point(100, 500), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(3, len);
+    strat_planner_get_stats(&stats);
+    CHECK_EQUAL(1, stats.searches);
+    CHECK_EQUAL(1, stats.reuses);
+}
+
+TEST(StratPlannerTestGroup, ReachedWaypointsAreSkipped)
+{
+    int len, y;
+
+    add_square();
+    strat_planner_get_path(point(0, 500), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+    y = path[0].y;
+
+    /* Past the first corner, only the second one and the goal remain. */
+    len = strat_planner_get_path(point(500, y), point(1000, 500), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(2, len);
+    CHECK_EQUAL(600, path[0].x);
+}
+
+TEST(StratPlannerTestGroup, OpponentInTheWayTriggersReplan)
+{
+    int len;
+
+    strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+    strat_planner_set_opponent(0, 500, 0, 100);
+    len = strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(3, len);
+    CHECK_EQUAL(400, path[0].x);
+    CHECK_EQUAL(600, path[1].x);
+
+    strat_planner_get_stats(&stats);
+    CHECK_EQUAL(2, stats.searches);
+}
+
+TEST(StratPlannerTestGroup, SmallOpponentMoveIsIgnored)
+{
+    strat_planner_set_opponent(0, 500, 0, 100);
+    strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+
+    /* The opponent now blocks the 400,-100 corner, but has not really moved. */
+    strat_planner_set_opponent(0, 500 + STRAT_PLANNER_MOVE_THRESHOLD - 1, 0, 100);
+    strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+
+    strat_planner_get_stats(&stats);
+    CHECK_EQUAL(1, stats.searches);
+    CHECK_EQUAL(1, stats.reuses);
+}
+
+TEST(StratPlannerTestGroup, RemovedOpponentDoesNotBlock)
+{
+    int len;
+
+    strat_planner_set_opponent(0, 500, 0, 100);
+    strat_planner_remove_opponent(0);
+    len = strat_planner_get_path(point(0, 0), point(1000, 0), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(1, len);
+}
+
+TEST(StratPlannerTestGroup, BoundingBoxIsRespected)
+{
+    int len;
+
+    /* Only the corners above the square are inside the box. */
+    strat_planner_set_bounding_box(0, 0, 1000, 1000);
+    strat_planner_set_opponent(0, 500, 200, 300);
+    len = strat_planner_get_path(point(0, 100), point(1000, 100), path, STRAT_PLANNER_MAX_PATH);
+
+    CHECK_EQUAL(3, len);
+    CHECK_EQUAL(500, path[0].y);
+    CHECK_EQUAL(500, path[1].y);
+}
+
+TEST(StratPlannerTestGroup, TooManyPolygons)
+{
+    int i;
+
+    for (i = 0; i < STRAT_PLANNER_MAX_STATIC; i++)
+        add_square();
+
+    strat_planner_point_t square[] = {
+        point(0, 0), point(1, 0), point(1, 1)
+    };
+    CHECK_EQUAL(-1, strat_planner_add_static_polygon(square, 3));
+}
@@ -0,0 +1,206 @@
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+extern "C" {
+#include "../strat_pt.h"
+}
+
+struct test_action {
+    strat_pt_t pt;
+    char tag;
+    int steps;
+    int go;
+};
+
+static char run_log[32];
+static int run_count;
+
+static int test_action(void *p)
+{
+    struct test_action *a = (struct test_action *)p;
+
+    STRAT_PT_BEGIN(&a->pt);
+    STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE);
+    run_log[run_count++] = a->tag;
+    a->steps++;
+
+    STRAT_PT_YIELD(&a->pt);
+    a->steps++;
+
+    STRAT_PT_WAIT_UNTIL(&a->pt, ROBOT_EVENT_TRAJ_END, a->go);
+    run_log[run_count++] = a->tag;
+    a->steps++;
+
+    STRAT_PT_END(&a->pt);
+}
+
+TEST_GROUP(StratPtTestGroup)
+{
+    struct test_action a, b;
+
+    void setup()
+    {
+        memset(run_log, 0, sizeof(run_log));
+        run_count = 0;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        strat_pt_init(&a.pt);
+        strat_pt_init(&b.pt);
+        a.tag = 'a';
+        b.tag = 'b';
+        strat_job_reset();
+        robot_events_init();
+    }
+
+    void teardown()
+    {
+        strat_pt_release(&a.pt, a.pt.resources);
+        strat_pt_release(&b.pt, b.pt.resources);
+    }
+};
+
+TEST(StratPtTestGroup, ResumesAfterYield)
+{
+    CHECK_EQUAL(STRAT_JOB_AGAIN, test_action(&a));
+    CHECK_EQUAL(1, a.steps);
+
+    CHECK_EQUAL(STRAT_JOB_WAIT, test_action(&a));
+    CHECK_EQUAL(2, a.steps);
+}
+
+TEST(StratPtTestGroup, WaitsUntilConditionIsTrue)
+{
+    test_action(&a);
+    test_action(&a);
+    CHECK_EQUAL(STRAT_JOB_WAIT, test_action(&a));
+    CHECK_EQUAL(2, a.steps);
+
+    a.go = 1;
+    CHECK_EQUAL(STRAT_JOB_DONE, test_action(&a));
+    CHECK_EQUAL(3, a.steps);
+}
+
+TEST(StratPtTestGroup, ResourcesAreExclusive)
+{
+    CHECK_EQUAL(1, strat_pt_acquire(&a.pt, STRAT_RESOURCE_BASE));
+    CHECK_EQUAL(0, strat_pt_acquire(&b.pt, STRAT_RESOURCE_BASE | STRAT_RESOURCE_LEFT_ARM));
+    CHECK_EQUAL(1, strat_pt_acquire(&b.pt, STRAT_RESOURCE_LEFT_ARM));
+
+    /* Taking a resource twice is allowed. */
+    CHECK_EQUAL(1, strat_pt_acquire(&a.pt, STRAT_RESOURCE_BASE));
+}
+
+TEST(StratPtTestGroup, ReleaseWakesUpWaiters)
+{
+    uint32_t events;
+
+    strat_pt_acquire(&a.pt, STRAT_RESOURCE_BASE);
+    strat_pt_release(&a.pt, STRAT_RESOURCE_BASE);
+
+    events = robot_events_wait(ROBOT_EVENT_STRAT_RESOURCE, 0);
+    CHECK_EQUAL(ROBOT_EVENT_STRAT_RESOURCE, events);
+    CHECK_EQUAL(1, strat_pt_acquire(&b.pt, STRAT_RESOURCE_BASE));
+}
+
+struct phase_action {
+    strat_pt_t pt;
+    int phase;
+};
+
+static int phase_action(void *p)
+{
+    struct phase_action *a = (struct phase_action *)p;
+
+    STRAT_PT_BEGIN(&a->pt);
+    STRAT_PT_ACQUIRE(&a->pt, STRAT_RESOURCE_BASE | STRAT_RESOURCE_LEFT_ARM);
+    a->phase = 1;
+    STRAT_PT_NEXT_PHASE(&a->pt, STRAT_RESOURCE_BASE | STRAT_RESOURCE_RIGHT_ARM);
+    a->phase = 2;
+    STRAT_PT_YIELD(&a->pt);
+    STRAT_PT_END(&a->pt);
+}
+
+TEST(StratPtTestGroup, NextPhaseReleasesThenAcquires)
+{
+    struct phase_action c;
+
+    memset(&c, 0, sizeof(c));
+    strat_pt_init(&c.pt);
+    strat_pt_acquire(&a.pt, STRAT_RESOURCE_RIGHT_ARM);
+
+    /* The right arm is busy, nothing is kept while waiting for it. */
+    CHECK_EQUAL(STRAT_JOB_WAIT, phase_action(&c));
+    CHECK_EQUAL(1, c.phase);
+    CHECK_EQUAL(0, c.pt.resources);
+
+    strat_pt_release(&a.pt, STRAT_RESOURCE_RIGHT_ARM);
+    CHECK_EQUAL(STRAT_JOB_AGAIN, phase_action(&c));
+    CHECK_EQUAL(2, c.phase);
+    CHECK_EQUAL(STRAT_RESOURCE_BASE | STRAT_RESOURCE_RIGHT_ARM, c.pt.resources);
+
+    /* The left arm was not taken back. */
+    CHECK_EQUAL(1, strat_pt_acquire(&b.pt, STRAT_RESOURCE_LEFT_ARM));
+
+    CHECK_EQUAL(STRAT_JOB_DONE, phase_action(&c));
+}
+
+TEST(StratPtTestGroup, ActionsRunConcurrently)
+{
+    int i;
+
+    strat_schedule_job(test_action, &a);
+    strat_schedule_job(test_action, &b);
+
+    for (i = 0; i < 10; i++)
+        strat_job_step(0);
+
+    /* b waits for the base owned by a, a waits for go. */
+    STRCMP_EQUAL("a", run_log);
+
+    a.go = 1;
+    b.go = 1;
+    robot_events_post(ROBOT_EVENT_TRAJ_END);
+
+    for (i = 0; i < 10 && !strat_job_pool_is_empty(); i++)
+        strat_job_step(0);
+
+    STRCMP_EQUAL("aabb", run_log);
+    CHECK_EQUAL(1, strat_job_pool_is_empty());
+}
+
+struct parent_action {
+    strat_pt_t pt;
+    struct test_action child;
+    int done;
+};
+
+static int parent_action(void *p)
+{
+    struct parent_action *a = (struct parent_action *)p;
+
+    STRAT_PT_BEGIN(&a->pt);
+    STRAT_PT_SPAWN(&a->pt, &a->child.pt, test_action(&a->child));
+    a->done = 1;
+    STRAT_PT_END(&a->pt);
+}
+
+TEST(StratPtTestGroup, SpawnRunsChildUntilItEnds)
+{
+    struct parent_action parent;
+
+    memset(&parent, 0, sizeof(parent));
+    strat_pt_init(&parent.pt);
+    parent.child.tag = 'c';
+
+    CHECK_EQUAL(STRAT_JOB_AGAIN, parent_action(&parent));
+    CHECK_EQUAL(STRAT_JOB_WAIT, parent_action(&parent));
+    CHECK_EQUAL(0, parent.done);
+
+    parent.child.go = 1;
+    CHECK_EQUAL(STRAT_JOB_DONE, parent_action(&parent));
+    CHECK_EQUAL(1, parent.done);
+    STRCMP_EQUAL("cc", run_log);
+
+    /* The child released what it took. */
+    CHECK_EQUAL(1, strat_pt_acquire(&b.pt, STRAT_RESOURCE_BASE));
+}
@@ -0,0 +1,110 @@
+#include "CppUTest/TestHarness.h"
+
+extern "C" {
+#include "../task_stats.h"
+#include "../periodic.h"
+#include "uptime.h"
+}
+
+TEST_GROUP(TaskStatsTestGroup)
+{
+    task_stats_t stats;
+
+    void setup()
+    {
+        task_stats_init(&stats, "test");
+    }
+
+    void teardown()
+    {
+        uptime_set(0);
+    }
+};
+
+TEST(TaskStatsTestGroup, ExecutionTimeIsMeasured)
+{
+    task_stats_begin(&stats, 100, 100);
+    task_stats_end(&stats, 110);
+    task_stats_begin(&stats, 200, 200);
+    task_stats_end(&stats, 230);
+
+    CHECK_EQUAL(2, stats.count);
+    CHECK_EQUAL(10, stats.min_time);
+    CHECK_EQUAL(30, stats.max_time);
+    CHECK_EQUAL(20, task_stats_mean_time(&stats));
+}
+
+TEST(TaskStatsTestGroup, LatenessIsMeasured)
+{
+    task_stats_begin(&stats, 100, 105);
+    task_stats_end(&stats, 110);
+    task_stats_begin(&stats, 200, 215);
+    task_stats_end(&stats, 230);
+
+    CHECK_EQUAL(5, stats.min_lateness);
+    CHECK_EQUAL(15, stats.max_lateness);
+    CHECK_EQUAL(10, task_stats_mean_lateness(&stats));
+}
+
+TEST(TaskStatsTestGroup, HistogramUsesLog2Buckets)
+{
+    task_stats_begin(&stats, 0, 0);
+    task_stats_end(&stats, 1);
+    task_stats_begin(&stats, 0, 0);
+    task_stats_end(&stats, 5);
+    task_stats_begin(&stats, 0, 0);
+    task_stats_end(&stats, 7);
+    task_stats_begin(&stats, 0, 0);
+    task_stats_end(&stats, 1000000);
+
+    CHECK_EQUAL(1, stats.histogram[0]);
+    CHECK_EQUAL(2, stats.histogram[2]);
+    CHECK_EQUAL(1, stats.histogram[TASK_STATS_HISTOGRAM_SIZE - 1]);
+}
+
+TEST(TaskStatsTestGroup, EndWithoutBeginIsIgnored)
+{
+    task_stats_end(&stats, 10);
+    CHECK_EQUAL(0, stats.count);
+}
+
+TEST(TaskStatsTestGroup, ResetIsDoneOnNextActivation)
+{
+    task_stats_begin(&stats, 0, 0);
+    task_stats_end(&stats, 10);
+
+    task_stats_request_reset(&stats);
+    CHECK_EQUAL(1, stats.count);
+
+    task_stats_begin(&stats, 100, 100);
+    task_stats_end(&stats, 103);
+    CHECK_EQUAL(1, stats.count);
+    CHECK_EQUAL(3, stats.max_time);
+}
+
+TEST(TaskStatsTestGroup, TasksAreRegistered)
+{
+    int count = task_stats_count();
+
+    POINTERS_EQUAL(&stats, task_stats_find("test"));
+    POINTERS_EQUAL(NULL, task_stats_find("unknown"));
+
+    /* Initializing twice does not register twice. */
+    task_stats_init(&stats, "test");
+    CHECK_EQUAL(count, task_stats_count());
+}
+
+TEST(TaskStatsTestGroup, PeriodicWaitUpdatesStats)
+{
+    periodic_t p;
+
+    uptime_set(1000);
+    periodic_init(&p, 100);
+    periodic_set_stats(&p, &stats);
+
+    uptime_set(1040);
+    periodic_wait(&p);
+
+    CHECK_EQUAL(1, stats.count);
+    CHECK_EQUAL(40, stats.max_time);
+}
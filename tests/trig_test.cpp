@@ -0,0 +1,97 @@
+#include "CppUTest/TestHarness.h"
+#include <cmath>
+
+extern "C" {
+#include "../trig.h"
+}
+
+#define LUT_MAX_ERROR 1e-5
+#define CORDIC_MAX_ERROR 1e-6
+
+typedef void (*sincos_t)(float, float *, float *);
+typedef float (*atan2_t)(float, float);
+
+TEST_GROUP(TrigTestGroup)
+{
+    /* Returns the biggest error against libm over several turns. */
+    double sincos_max_error(sincos_t f)
+    {
+        double max_error = 0.;
+        float a, s, c;
+
+        for (a = -4 * M_PI; a < 4 * M_PI; a += 0.0013) {
+            f(a, &s, &c);
+            max_error = fmax(max_error, fabs(s - sin(a)));
+            max_error = fmax(max_error, fabs(c - cos(a)));
+        }
+
+        return max_error;
+    }
+
+    double atan2_max_error(atan2_t f)
+    {
+        double max_error = 0., error;
+        float a, r;
+
+        /* Different magnitudes check the scaling of the inputs. */
+        for (r = 1e-3; r < 1e4; r *= 7.) {
+            for (a = -M_PI; a < M_PI; a += 0.0013) {
+                error = fabs(f(r * sin(a), r * cos(a)) - atan2(r * sin(a), r * cos(a)));
+                max_error = fmax(max_error, error);
+            }
+        }
+
+        return max_error;
+    }
+};
+
+TEST(TrigTestGroup, LutSinCos)
+{
+    CHECK(sincos_max_error(trig_lut_sincos) < LUT_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, CordicSinCos)
+{
+    CHECK(sincos_max_error(trig_cordic_sincos) < CORDIC_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, LutAtan2)
+{
+    CHECK(atan2_max_error(trig_lut_atan2) < LUT_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, CordicAtan2)
+{
+    CHECK(atan2_max_error(trig_cordic_atan2) < CORDIC_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, Atan2Axes)
+{
+    DOUBLES_EQUAL(0, trig_lut_atan2(0, 1), CORDIC_MAX_ERROR);
+    DOUBLES_EQUAL(M_PI / 2, trig_lut_atan2(1, 0), CORDIC_MAX_ERROR);
+    DOUBLES_EQUAL(M_PI, trig_lut_atan2(0, -1), CORDIC_MAX_ERROR);
+    DOUBLES_EQUAL(-M_PI / 2, trig_cordic_atan2(-1, 0), CORDIC_MAX_ERROR);
+    DOUBLES_EQUAL(M_PI, trig_cordic_atan2(0, -1), CORDIC_MAX_ERROR);
+    DOUBLES_EQUAL(0, trig_cordic_atan2(0, 0), CORDIC_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, Acos)
+{
+    float x;
+
+    for (x = -1; x <= 1; x += 0.001)
+        DOUBLES_EQUAL(acos(x), trig_acos(x), LUT_MAX_ERROR);
+
+    /* Out of range values are clamped. */
+    DOUBLES_EQUAL(0, trig_acos(1.0001), LUT_MAX_ERROR);
+    DOUBLES_EQUAL(M_PI, trig_acos(-1.0001), LUT_MAX_ERROR);
+}
+
+TEST(TrigTestGroup, SinAndCosMatchSinCos)
+{
+    float s, c;
+
+    trig_sincos(1.234, &s, &c);
+    DOUBLES_EQUAL(s, trig_sin(1.234), 1e-9);
+    DOUBLES_EQUAL(c, trig_cos(1.234), 1e-9);
+}
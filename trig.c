@@ -0,0 +1,395 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "trig.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/** Number of intervals in the lookup tables. */
+#define LUT_SIZE 256
+
+/** sin(pi / 2 * i / LUT_SIZE) for i in [0, LUT_SIZE]. */
+static const float sin_table[LUT_SIZE + 1] = {
+    0.000000000f, 0.006135885f, 0.012271538f, 0.018406730f,
+    0.024541229f, 0.030674803f, 0.036807223f, 0.042938257f,
+    0.049067674f, 0.055195244f, 0.061320736f, 0.067443920f,
+    0.073564564f, 0.079682438f, 0.085797312f, 0.091908956f,
+    0.098017140f, 0.104121634f, 0.110222207f, 0.116318631f,
+    0.122410675f, 0.128498111f, 0.134580709f, 0.140658239f,
+    0.146730474f, 0.152797185f, 0.158858143f, 0.164913120f,
+    0.170961889f, 0.177004220f, 0.183039888f, 0.189068664f,
+    0.195090322f, 0.201104635f, 0.207111376f, 0.213110320f,
+    0.219101240f, 0.225083911f, 0.231058108f, 0.237023606f,
+    0.242980180f, 0.248927606f, 0.254865660f, 0.260794118f,
+    0.266712757f, 0.272621355f, 0.278519689f, 0.284407537f,
+    0.290284677f, 0.296150888f, 0.302005949f, 0.307849640f,
+    0.313681740f, 0.319502031f, 0.325310292f, 0.331106306f,
+    0.336889853f, 0.342660717f, 0.348418680f, 0.354163525f,
+    0.359895037f, 0.365612998f, 0.371317194f, 0.377007410f,
+    0.382683432f, 0.388345047f, 0.393992040f, 0.399624200f,
+    0.405241314f, 0.410843171f, 0.416429560f, 0.422000271f,
+    0.427555093f, 0.433093819f, 0.438616239f, 0.444122145f,
+    0.449611330f, 0.455083587f, 0.460538711f, 0.465976496f,
+    0.471396737f, 0.476799230f, 0.482183772f, 0.487550160f,
+    0.492898192f, 0.498227667f, 0.503538384f, 0.508830143f,
+    0.514102744f, 0.519355990f, 0.524589683f, 0.529803625f,
+    0.534997620f, 0.540171473f, 0.545324988f, 0.550457973f,
+    0.555570233f, 0.560661576f, 0.565731811f, 0.570780746f,
+    0.575808191f, 0.580813958f, 0.585797857f, 0.590759702f,
+    0.595699304f, 0.600616479f, 0.605511041f, 0.610382806f,
+    0.615231591f, 0.620057212f, 0.624859488f, 0.629638239f,
+    0.634393284f, 0.639124445f, 0.643831543f, 0.648514401f,
+    0.653172843f, 0.657806693f, 0.662415778f, 0.666999922f,
+    0.671558955f, 0.676092704f, 0.680600998f, 0.685083668f,
+    0.689540545f, 0.693971461f, 0.698376249f, 0.702754744f,
+    0.707106781f, 0.711432196f, 0.715730825f, 0.720002508f,
+    0.724247083f, 0.728464390f, 0.732654272f, 0.736816569f,
+    0.740951125f, 0.745057785f, 0.749136395f, 0.753186799f,
+    0.757208847f, 0.761202385f, 0.765167266f, 0.769103338f,
+    0.773010453f, 0.776888466f, 0.780737229f, 0.784556597f,
+    0.788346428f, 0.792106577f, 0.795836905f, 0.799537269f,
+    0.803207531f, 0.806847554f, 0.810457198f, 0.814036330f,
+    0.817584813f, 0.821102515f, 0.824589303f, 0.828045045f,
+    0.831469612f, 0.834862875f, 0.838224706f, 0.841554977f,
+    0.844853565f, 0.848120345f, 0.851355193f, 0.854557988f,
+    0.857728610f, 0.860866939f, 0.863972856f, 0.867046246f,
+    0.870086991f, 0.873094978f, 0.876070094f, 0.879012226f,
+    0.881921264f, 0.884797098f, 0.887639620f, 0.890448723f,
+    0.893224301f, 0.895966250f, 0.898674466f, 0.901348847f,
+    0.903989293f, 0.906595705f, 0.909167983f, 0.911706032f,
+    0.914209756f, 0.916679060f, 0.919113852f, 0.921514039f,
+    0.923879533f, 0.926210242f, 0.928506080f, 0.930766961f,
+    0.932992799f, 0.935183510f, 0.937339012f, 0.939459224f,
+    0.941544065f, 0.943593458f, 0.945607325f, 0.947585591f,
+    0.949528181f, 0.951435021f, 0.953306040f, 0.955141168f,
+    0.956940336f, 0.958703475f, 0.960430519f, 0.962121404f,
+    0.963776066f, 0.965394442f, 0.966976471f, 0.968522094f,
+    0.970031253f, 0.971503891f, 0.972939952f, 0.974339383f,
+    0.975702130f, 0.977028143f, 0.978317371f, 0.979569766f,
+    0.980785280f, 0.981963869f, 0.983105487f, 0.984210092f,
+    0.985277642f, 0.986308097f, 0.987301418f, 0.988257568f,
+    0.989176510f, 0.990058210f, 0.990902635f, 0.991709754f,
+    0.992479535f, 0.993211949f, 0.993906970f, 0.994564571f,
+    0.995184727f, 0.995767414f, 0.996312612f, 0.996820299f,
+    0.997290457f, 0.997723067f, 0.998118113f, 0.998475581f,
+    0.998795456f, 0.999077728f, 0.999322385f, 0.999529418f,
+    0.999698819f, 0.999830582f, 0.999924702f, 0.999981175f,
+    1.000000000f
+};
+
+/** atan(i / LUT_SIZE) for i in [0, LUT_SIZE]. */
+static const float atan_table[LUT_SIZE + 1] = {
+    0.000000000f, 0.003906230f, 0.007812341f, 0.011718214f,
+    0.015623729f, 0.019528767f, 0.023433210f, 0.027336938f,
+    0.031239833f, 0.035141777f, 0.039042650f, 0.042942335f,
+    0.046840713f, 0.050737667f, 0.054633079f, 0.058526833f,
+    0.062418810f, 0.066308895f, 0.070196971f, 0.074082923f,
+    0.077966634f, 0.081847990f, 0.085726876f, 0.089603177f,
+    0.093476781f, 0.097347573f, 0.101215442f, 0.105080273f,
+    0.108941957f, 0.112800381f, 0.116655435f, 0.120507010f,
+    0.124354995f, 0.128199281f, 0.132039762f, 0.135876328f,
+    0.139708874f, 0.143537294f, 0.147361481f, 0.151181332f,
+    0.154996742f, 0.158807608f, 0.162613829f, 0.166415301f,
+    0.170211925f, 0.174003601f, 0.177790229f, 0.181571711f,
+    0.185347950f, 0.189118849f, 0.192884312f, 0.196644245f,
+    0.200398554f, 0.204147145f, 0.207889927f, 0.211626809f,
+    0.215357700f, 0.219082511f, 0.222801154f, 0.226513541f,
+    0.230219587f, 0.233919206f, 0.237612314f, 0.241298827f,
+    0.244978663f, 0.248651741f, 0.252317981f, 0.255977303f,
+    0.259629629f, 0.263274883f, 0.266912988f, 0.270543868f,
+    0.274167451f, 0.277783663f, 0.281392433f, 0.284993689f,
+    0.288587362f, 0.292173383f, 0.295751686f, 0.299322203f,
+    0.302884868f, 0.306439619f, 0.309986391f, 0.313525123f,
+    0.317055753f, 0.320578222f, 0.324092470f, 0.327598441f,
+    0.331096077f, 0.334585322f, 0.338066123f, 0.341538425f,
+    0.345002177f, 0.348457327f, 0.351903825f, 0.355341622f,
+    0.358770670f, 0.362190922f, 0.365602332f, 0.369004855f,
+    0.372398447f, 0.375783065f, 0.379158669f, 0.382525217f,
+    0.385882669f, 0.389230988f, 0.392570135f, 0.395900074f,
+    0.399220770f, 0.402532187f, 0.405834293f, 0.409127055f,
+    0.412410442f, 0.415684422f, 0.418948967f, 0.422204048f,
+    0.425449637f, 0.428685708f, 0.431912235f, 0.435129194f,
+    0.438336560f, 0.441534311f, 0.444722424f, 0.447900879f,
+    0.451069656f, 0.454228735f, 0.457378099f, 0.460517729f,
+    0.463647609f, 0.466767724f, 0.469878058f, 0.472978598f,
+    0.476069330f, 0.479150243f, 0.482221324f, 0.485282564f,
+    0.488333951f, 0.491375478f, 0.494407135f, 0.497428916f,
+    0.500440813f, 0.503442821f, 0.506434934f, 0.509417149f,
+    0.512389460f, 0.515351866f, 0.518304364f, 0.521246951f,
+    0.524179629f, 0.527102395f, 0.530015251f, 0.532918198f,
+    0.535811238f, 0.538694373f, 0.541567605f, 0.544430940f,
+    0.547284381f, 0.550127933f, 0.552961602f, 0.555785394f,
+    0.558599315f, 0.561403374f, 0.564197577f, 0.566981934f,
+    0.569756453f, 0.572521145f, 0.575276018f, 0.578021084f,
+    0.580756354f, 0.583481839f, 0.586197551f, 0.588903504f,
+    0.591599710f, 0.594286183f, 0.596962937f, 0.599629987f,
+    0.602287346f, 0.604935031f, 0.607573058f, 0.610201443f,
+    0.612820202f, 0.615429353f, 0.618028912f, 0.620618899f,
+    0.623199330f, 0.625770225f, 0.628331602f, 0.630883482f,
+    0.633425883f, 0.635958826f, 0.638482330f, 0.640996418f,
+    0.643501109f, 0.645996425f, 0.648482388f, 0.650959019f,
+    0.653426341f, 0.655884377f, 0.658333148f, 0.660772679f,
+    0.663202993f, 0.665624112f, 0.668036062f, 0.670438866f,
+    0.672832548f, 0.675217133f, 0.677592646f, 0.679959111f,
+    0.682316555f, 0.684665002f, 0.687004478f, 0.689335010f,
+    0.691656622f, 0.693969341f, 0.696273194f, 0.698568208f,
+    0.700854408f, 0.703131822f, 0.705400477f, 0.707660400f,
+    0.709911618f, 0.712154160f, 0.714388052f, 0.716613323f,
+    0.718830000f, 0.721038111f, 0.723237685f, 0.725428749f,
+    0.727611333f, 0.729785464f, 0.731951171f, 0.734108483f,
+    0.736257429f, 0.738398037f, 0.740530337f, 0.742654356f,
+    0.744770126f, 0.746877674f, 0.748977029f, 0.751068222f,
+    0.753151281f, 0.755226236f, 0.757293116f, 0.759351951f,
+    0.761402770f, 0.763445603f, 0.765480479f, 0.767507428f,
+    0.769526480f, 0.771537665f, 0.773541012f, 0.775536550f,
+    0.777524310f, 0.779504322f, 0.781476615f, 0.783441219f,
+    0.785398163f
+};
+
+/* CORDIC angles are in Q28 fixed point and coordinates in Q29. */
+#define CORDIC_ANGLE_SHIFT 28
+#define CORDIC_COORD_SHIFT 29
+#define CORDIC_ITERATIONS 24
+
+/** atan(2^-i) in Q28. */
+static const int32_t cordic_atan_table[28] = {
+    210828714, 124459457, 65760959, 33381290, 16755422, 8385879,
+    4193963, 2097109, 1048571, 524287, 262144, 131072,
+    65536, 32768, 16384, 8192, 4096, 2048,
+    1024, 512, 256, 128, 64, 32,
+    16, 8, 4, 2
+};
+
+/** Inverse of the CORDIC gain, 0.607252935 in Q29. */
+#define CORDIC_INV_GAIN 326016437
+
+#define CORDIC_PI ((int32_t)(M_PI * (1 << CORDIC_ANGLE_SHIFT)))
+
+/** Brings an angle back between -pi and pi. */
+static float wrap_angle(float a)
+{
+    int32_t turns;
+
+    if (a <= M_PI && a >= -M_PI)
+        return a;
+
+    turns = (int32_t)(a * (float)(0.5 / M_PI) + (a > 0 ? 0.5f : -0.5f));
+    return a - turns * (float)(2 * M_PI);
+}
+
+/** Interpolates sin_table at a position given in table intervals, between 0
+ * and 4 * LUT_SIZE (one full turn). */
+static float lut_sin_index(int32_t index, float frac)
+{
+    int32_t pos = index & (LUT_SIZE - 1);
+    float a, b;
+
+    switch ((index / LUT_SIZE) & 3) {
+        case 0:
+            a = sin_table[pos];
+            b = sin_table[pos + 1];
+            break;
+        case 1:
+            a = sin_table[LUT_SIZE - pos];
+            b = sin_table[LUT_SIZE - pos - 1];
+            break;
+        case 2:
+            a = -sin_table[pos];
+            b = -sin_table[pos + 1];
+            break;
+        default:
+            a = -sin_table[LUT_SIZE - pos];
+            b = -sin_table[LUT_SIZE - pos - 1];
+            break;
+    }
+
+    return a + frac * (b - a);
+}
+
+void trig_lut_sincos(float a, float *s, float *c)
+{
+    float u;
+    int32_t index;
+
+    u = a * (float)(2 * LUT_SIZE / M_PI);
+    index = (int32_t)u;
+    if (u < index)
+        index--;
+    u -= index;
+
+    /* Wraps negative angles too, the table covers a full turn. */
+    index &= 4 * LUT_SIZE - 1;
+
+    if (s)
+        *s = lut_sin_index(index, u);
+    if (c)
+        *c = lut_sin_index(index + LUT_SIZE, u);
+}
+
+/** atan of a value between 0 and 1. */
+static float lut_atan_unit(float t)
+{
+    float u = t * LUT_SIZE;
+    int32_t index = (int32_t)u;
+
+    if (index >= LUT_SIZE)
+        index = LUT_SIZE - 1;
+
+    u -= index;
+    return atan_table[index] + u * (atan_table[index + 1] - atan_table[index]);
+}
+
+float trig_lut_atan2(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float result;
+
+    if (ax == 0 && ay == 0)
+        return 0;
+
+    /* Reduces to the first octant. */
+    if (ay <= ax)
+        result = lut_atan_unit(ay / ax);
+    else
+        result = (float)(M_PI / 2) - lut_atan_unit(ax / ay);
+
+    if (x < 0)
+        result = (float)M_PI - result;
+
+    if (y < 0)
+        result = -result;
+
+    return result;
+}
+
+void trig_cordic_sincos(float a, float *s, float *c)
+{
+    int32_t x, y, z, next_x;
+    int i, flip = 0;
+
+    /* CORDIC converges between -pi/2 and pi/2, so we use
+     * sin(pi - a) = sin(a) and cos(pi - a) = -cos(a). */
+    a = wrap_angle(a);
+    if (a > M_PI / 2) {
+        a = (float)M_PI - a;
+        flip = 1;
+    } else if (a < -M_PI / 2) {
+        a = (float)-M_PI - a;
+        flip = 1;
+    }
+
+    x = CORDIC_INV_GAIN;
+    y = 0;
+    z = (int32_t)ldexpf(a, CORDIC_ANGLE_SHIFT);
+
+    for (i = 0; i < CORDIC_ITERATIONS; i++) {
+        if (z >= 0) {
+            next_x = x - (y >> i);
+            y += x >> i;
+            z -= cordic_atan_table[i];
+        } else {
+            next_x = x + (y >> i);
+            y -= x >> i;
+            z += cordic_atan_table[i];
+        }
+        x = next_x;
+    }
+
+    if (flip)
+        x = -x;
+
+    if (s)
+        *s = ldexpf((float)y, -CORDIC_COORD_SHIFT);
+    if (c)
+        *c = ldexpf((float)x, -CORDIC_COORD_SHIFT);
+}
+
+float trig_cordic_atan2(float y, float x)
+{
+    int32_t xi, yi, z, next_x;
+    int i, exponent;
+
+    if (x == 0 && y == 0)
+        return 0;
+
+    /* Scales the vector so its largest coordinate fits in Q29. */
+    frexpf(fabsf(x) > fabsf(y) ? x : y, &exponent);
+    xi = (int32_t)ldexpf(x, CORDIC_COORD_SHIFT - exponent);
+    yi = (int32_t)ldexpf(y, CORDIC_COORD_SHIFT - exponent);
+
+    /* Vectoring mode only converges for x >= 0, rotate by pi if needed. */
+    z = 0;
+    if (xi < 0) {
+        xi = -xi;
+        yi = -yi;
+        z = y >= 0 ? CORDIC_PI : -CORDIC_PI;
+    }
+
+    for (i = 0; i < CORDIC_ITERATIONS; i++) {
+        if (yi > 0) {
+            next_x = xi + (yi >> i);
+            yi -= xi >> i;
+            z += cordic_atan_table[i];
+        } else {
+            next_x = xi - (yi >> i);
+            yi += xi >> i;
+            z -= cordic_atan_table[i];
+        }
+        xi = next_x;
+    }
+
+    return ldexpf((float)z, -CORDIC_ANGLE_SHIFT);
+}
+
+void trig_sincos(float a, float *s, float *c)
+{
+#if defined(TRIG_USE_LUT)
+    trig_lut_sincos(a, s, c);
+#elif defined(TRIG_USE_CORDIC)
+    trig_cordic_sincos(a, s, c);
+#else
+    if (s)
+        *s = sinf(a);
+    if (c)
+        *c = cosf(a);
+#endif
+}
+
+float trig_sin(float a)
+{
+    float s;
+    trig_sincos(a, &s, NULL);
+    return s;
+}
+
+float trig_cos(float a)
+{
+    float c;
+    trig_sincos(a, NULL, &c);
+    return c;
+}
+
+float trig_atan2(float y, float x)
+{
+#if defined(TRIG_USE_LUT)
+    return trig_lut_atan2(y, x);
+#elif defined(TRIG_USE_CORDIC)
+    return trig_cordic_atan2(y, x);
+#else
+    return atan2f(y, x);
+#endif
+}
+
+float trig_acos(float x)
+{
+    if (x > 1.)
+        x = 1.;
+    if (x < -1.)
+        x = -1.;
+
+    /* acos(x) = atan2(sqrt(1 - x^2), x), factored to avoid cancellation
+     * around 1. */
+    return trig_atan2(sqrtf((1 - x) * (1 + x)), x);
+}
@@ -0,0 +1,35 @@
+/** @file trig.h
+ * @brief Trigonometry functions used by the arm cinematics.
+ *
+ * The NIOS2 has no FPU, which makes libm trigonometry very slow. The backend
+ * is chosen at compile time:
+ *  - TRIG_USE_LUT : interpolated lookup tables, error below 1e-5.
+ *  - TRIG_USE_CORDIC : fixed point CORDIC, error below 1e-6.
+ *  - Otherwise libm is used.
+ *
+ * All backends are always compiled so they can be tested against libm on the
+ * host. All angles are in radians.
+ */
+#ifndef _TRIG_H_
+#define _TRIG_H_
+
+float trig_sin(float a);
+float trig_cos(float a);
+
+/** Computes both sine and cosine of an angle, which is cheaper than calling
+ * trig_sin and trig_cos separately. */
+void trig_sincos(float a, float *s, float *c);
+
+/** Same as atan2f, returns an angle between -pi and pi. */
+float trig_atan2(float y, float x);
+
+/** Same as acosf, x is clamped to [-1, 1]. */
+float trig_acos(float x);
+
+/* Backends, the functions above forward to one of them. */
+void trig_lut_sincos(float a, float *s, float *c);
+float trig_lut_atan2(float y, float x);
+void trig_cordic_sincos(float a, float *s, float *c);
+float trig_cordic_atan2(float y, float x);
+
+#endif